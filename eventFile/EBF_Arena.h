@@ -0,0 +1,58 @@
+/** @class eventFile::EBF_Arena
+ *
+ * @brief Reusable pool of memory from which EBF_Data payloads can be drawn.
+ *
+ * An EBF_Arena hands out storage by bumping a pointer through a list of large
+ * blocks, so that a batch of events costs only the space their EBF actually
+ * occupies.  reset() makes all of the storage available again without giving
+ * it back to the system; any EBF_Data that drew from the arena before the
+ * reset will allocate fresh storage on its next read/init/assign.  An arena
+ * must outlive every EBF_Data that uses it, and is not thread-safe.
+ *
+ * @author agent <agent@local>
+ *
+ * $Header$
+ */
+
+#ifndef EVENTFILE_EBF_ARENA_HH
+#define EVENTFILE_EBF_ARENA_HH
+
+#include <stddef.h>
+
+#include <vector>
+
+namespace eventFile {
+
+  class EBF_Arena {
+  public:
+
+    explicit EBF_Arena( size_t blocksize = 1024*1024 );
+    ~EBF_Arena();
+
+    unsigned char* allocate( size_t nbytes );
+    void reset();
+
+    unsigned generation() const { return m_generation; };
+    size_t used() const;
+    size_t capacity() const;
+
+  private:
+    struct Block {
+      unsigned char* data;
+      size_t         size;
+    };
+
+    size_t              m_blocksize;
+    std::vector<Block>  m_blocks;
+    size_t              m_current;
+    size_t              m_offset;
+    unsigned            m_generation;
+
+    // not copyable
+    EBF_Arena( const EBF_Arena& );
+    EBF_Arena& operator=( const EBF_Arena& );
+  };
+
+};
+
+#endif
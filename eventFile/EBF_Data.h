@@ -7,6 +7,13 @@
  * for parsing by the LDF library.  The start() and end() methods provide pointers delineating
  * the range of memory over which an EBFeventIterator subclass should operate.
  *
+ * The payload storage is sized to the event rather than fixed.  By default it
+ * comes from the heap and is reused (growing as needed) across read() calls;
+ * an EBF_Data constructed with an EBF_Arena draws it from the arena instead, so
+ * that large batches of events can be held compactly.  Copies always own their
+ * storage.  read() refuses a stored length longer than what is left of the
+ * file, and holds no payload after a read that fails.
+ *
  * @author Bryson Lee <blee@slac.stanford.edu>
  *
  * $Header$
@@ -21,22 +28,37 @@ class EBFevent;
 
 namespace eventFile {
 
+  class EBF_Arena;
+
   class EBF_Data {
   public:
 
-    EBF_Data() {};
+    EBF_Data();
+    explicit EBF_Data( EBF_Arena& arena );
+    EBF_Data( const EBF_Data& other );
+    EBF_Data& operator=( const EBF_Data& other );
+    ~EBF_Data();
 
-    const EBFevent* start() const { return reinterpret_cast< const EBFevent* >( &m_data[0] ); };
-    const EBFevent* end() const { return reinterpret_cast< const EBFevent* >( &m_data[m_len] ); };
+    const EBFevent* start() const { return reinterpret_cast< const EBFevent* >( m_data ); };
+    const EBFevent* end() const { return reinterpret_cast< const EBFevent* >( m_data + m_len ); };
     const unsigned char* data() const { return m_data; }
     unsigned size() const { return m_len; };
     void init( unsigned nbytes, const void* payload );
+    void assign( unsigned nbytes, const void* ebf );
     void write( FILE* ) const;
     void read( FILE* );
 
+    unsigned capacity() const { return m_cap; };
+
   private:
-    unsigned char m_data[128*1024];
-    unsigned      m_len;
+    unsigned char* m_data;
+    unsigned       m_len;
+    unsigned       m_cap;
+    EBF_Arena*     m_arena;
+    unsigned       m_generation;
+
+    void reserve( unsigned nbytes );
+    void release();
   };
 
 };
@@ -17,6 +17,21 @@
 #define LSEHEADER_ALIAS_LEN 64
 
 namespace eventFile {
+
+  /** the MOOT key and alias that follow the fixed header on disk.  Each
+      reader and writer keeps its own copy, so files opened concurrently in
+      one process do not see each other's metadata. */
+  struct LSEHeaderMeta {
+    LSEHeaderMeta();
+
+    unsigned m_moot_key;
+    char     m_moot_alias[LSEHEADER_ALIAS_LEN];
+
+    unsigned    moot_key()   const { return m_moot_key; }
+    const char* moot_alias() const { return m_moot_alias; }
+    void set_moot_key( unsigned );
+    void set_moot_alias( const char* );
+  };
   
   struct LSEHeader {
     // ctor/dtor
@@ -36,18 +51,29 @@ namespace eventFile {
     unsigned m_dfi_apids[LSEHEADER_MAX_APIDS];
     unsigned m_dfi_dfierr[LSEHEADER_MAX_APIDS];
 
-    // read-write routines
+    // read-write routines; the one-argument forms go through the static
+    // MOOT key/alias below and are kept for existing single-file callers
+    void read( FILE*, LSEHeaderMeta& );
+    void write( FILE*, const LSEHeaderMeta& );
     void read( FILE* );
     void write( FILE* );
 
     // version accessor
     unsigned version() const { return m_version & 0x000000FF; }
 
-    // static-variable accessors/mutators
+    // blocked files (v10) end with an LSE_Footer
+    bool blocked() const { return m_version == BlockedFormatVersion; }
+    void set_blocked() { m_version = BlockedFormatVersion; }
+
+    // static-variable accessors/mutators, deprecated and process-global:
+    // prefer the LSEHeaderMeta of the owning reader or writer.  Unless set
+    // here or by the one-argument read(), they hold the MOOT key/alias of
+    // the first file an LSEReader opens, and are not written after that.
     static unsigned    moot_key()   { return m_moot_key; }
     static const char* moot_alias() { return m_moot_alias; }
     void set_moot_key( unsigned );
     void set_moot_alias( const char* );
+    static void publishOnce( const LSEHeaderMeta& );
 
     private:
 
@@ -55,8 +81,9 @@ namespace eventFile {
     static unsigned m_moot_key;
     static char     m_moot_alias[LSEHEADER_ALIAS_LEN];
 
-    // file-format version specifier
+    // file-format version specifiers
     static const unsigned FormatVersion = 0x09090909;
+    static const unsigned BlockedFormatVersion = 0x0A0A0A0A;
   };
 };
 
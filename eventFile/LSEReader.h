@@ -15,32 +15,129 @@
 
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "eventFile/LSE_Info.h"
 #include "eventFile/LSEHeader.h"
 #include "eventFile/LSE_Keys.h"
+#include "eventFile/LSE_Footer.h"
+#include "eventFile/LSE_FileStamp.h"
 
 namespace eventFile {
 
   class LSE_Context;
   class EBF_Data;
+  class LSE_EventView;
+  struct LSE_EventBatch;
+  class LSE_ChunkSource;
+  class LSE_Index;
+  class LSE_EventFilter;
+  class LSE_ContextCodec;
+  class LSE_HandlerTable;
   
   class LSEReader {
   public:
-    LSEReader( const std::string& filename );
+
+    /** enumerate the ways the file content can be accessed */
+    enum IOMode {
+      STDIO = 0,  /// buffered stdio reads, copied into the caller's objects
+      MMAP  = 1,  /// whole file mapped, events viewed in place (not on WIN32)
+      PREFETCH = 2, /// large chunks read ahead on an I/O thread (not on WIN32)
+      URING = 3,    /// large chunks read ahead through io_uring (Linux only)
+    };
+
+    /** read-ahead statistics for PREFETCH and URING modes */
+    struct PrefetchStats {
+      PrefetchStats() : chunks( 0 ), bytes( 0 ), stalls( 0 ), stallTime( 0.0 ) {};
+      unsigned long long chunks;     /// chunks read by the I/O thread
+      unsigned long long bytes;      /// bytes read by the I/O thread
+      unsigned long long stalls;     /// times the consumer waited for a chunk
+      double             stallTime;  /// total seconds the consumer waited
+    };
+
+    /** records skipped by the filter */
+    struct FilterStats {
+      FilterStats() : accepted( 0 ), rejected( 0 ), skippedBytes( 0 ) {};
+      unsigned long long accepted;      /// records passed to the caller
+      unsigned long long rejected;      /// records skipped
+      unsigned long long skippedBytes;  /// total size of the skipped records
+    };
+
+    /** depth and chunksize set the number and size of read-ahead buffers
+	used in PREFETCH and URING modes; they are ignored otherwise.  A
+	compressed file (see LSEWriter::enableCompression) is always read
+	in PREFETCH mode, with its blocks inflated on depth-1 worker threads
+	into depth buffers; offsets into it, for seek() and in its index and
+	footer, are positions in the uncompressed event stream. */
+    LSEReader( const std::string& filename, IOMode mode = STDIO,
+	       unsigned depth = 4, size_t chunksize = 1024*1024 );
     virtual ~LSEReader();
 
     bool read( LSE_Context&, EBF_Data&, 
 	       LSE_Info::InfoType&, LPA_Info&, LCI_ACD_Info&, LCI_CAL_Info&, LCI_TKR_Info&, 
 	       LSE_Keys::KeysType&, LPA_Keys&, LCI_Keys& );
+
+    /// projections of the next event that leave out the EBF payload, which is
+    /// skipped over rather than copied; readContext() also skips the meta-info
+    bool read( LSE_Context&,
+	       LSE_Info::InfoType&, LPA_Info&, LCI_ACD_Info&, LCI_CAL_Info&, LCI_TKR_Info&, 
+	       LSE_Keys::KeysType&, LPA_Keys&, LCI_Keys& );
+    bool readContext( LSE_Context& );
+
+    /// point the view at the next event; in MMAP mode nothing is copied
+    bool read( LSE_EventView& );
+
+    /// replace the batch content with up to n events, returning the number read
+    size_t readBatch( LSE_EventBatch&, size_t n );
+
     void close();
 
+    /** reopen the file after close() in the same mode, at the first event.
+	The header, footer and any loaded index are kept rather than read
+	again unless the file's size, modification time or inode has
+	changed. */
+    void reopen();
+    bool isOpen() const { return m_FILE != NULL; };
+
+    /** only return events the filter accepts; the filter is evaluated on
+	each record before its EBF or meta-info is copied anywhere.  The
+	reader does not take ownership; NULL removes the filter. */
+    void setFilter( LSE_EventFilter* filter ) { m_filter = filter; };
+    FilterStats filterStats() const { return m_filterStats; };
+
+    IOMode mode() const { return m_mode; };
+    unsigned long long dataOffset() const { return m_start; };  /// file offset of the first event
+    PrefetchStats prefetchStats() const;
+
 #ifdef _FILE_OFFSET_BITS
     int seek( off_t ofst );
 #else
     int seek( int ofst );
 #endif
 
+    /** position the reader at the first event whose GEM sequence (or
+	current.timeSecs) is at least the target, returning false and leaving
+	the reader at end of file if there is none.  The events are located
+	by binary search of the file's LSE_Index when one is present and
+	consistent with the header, then of the block footer of a blocked
+	file, and by a sequential scan otherwise. */
+    bool seekSequence( unsigned long long seq );
+    bool seekTime( unsigned secs );
+
+    /** position the reader at the last event, returning false if there are
+	none.  Blocked files locate it through the footer without reading. */
+    bool seekLast();
+
+    /** the block footer of a blocked (v10) file, NULL otherwise.  Block
+	offsets can be passed to seek() to step over whole blocks. */
+    const LSE_Footer* footer() const { return m_hdr.blocked() ? &m_footer : NULL; };
+
+    /** load the index used by seekSequence()/seekTime(); the default name
+	is LSE_Index::name( filename ).  Returns false if there is no usable
+	index, in which case the seeks fall back to scanning. */
+    bool loadIndex( const std::string& idxname = "" );
+    const LSE_Index* index() const { return m_index; };
+
     // header accessors
     unsigned runid() const { return m_hdr.m_runid; };
     unsigned begSec() const { return m_hdr.m_secs_beg; };
@@ -48,6 +145,9 @@ namespace eventFile {
     unsigned long long evtcnt() const { return m_hdr.m_evtcnt; };
     unsigned long long begGEM() const { return m_hdr.m_GEMseq_beg; };
     unsigned long long endGEM() const { return m_hdr.m_GEMseq_end; };
+    unsigned mootKey() const { return m_meta.moot_key(); };
+    const char* mootAlias() const { return m_meta.moot_alias(); };
+    const LSEHeaderMeta& meta() const { return m_meta; };
     std::pair<unsigned, unsigned> seqErr( int islot ) const
       {
 	if ( islot < LSEHEADER_MAX_APIDS ) {
@@ -68,16 +168,87 @@ namespace eventFile {
   private:
     std::string m_name;
     LSEHeader m_hdr;
+    LSEHeaderMeta m_meta;
     FILE* m_FILE;
+    IOMode m_mode;
+
+    // memory-mapped file state
+    unsigned char* m_map;
+    size_t         m_maplen;
+    size_t         m_mappos;
+
+    // read-ahead state
+    LSE_ChunkSource*     m_source;
+    unsigned             m_depth;
+    size_t               m_chunksize;
+    const unsigned char* m_chunk;
+    size_t               m_chunklen;
+    size_t               m_chunkpos;
+    unsigned long long   m_srcpos;     // file offset of the next chunk
+
+    // staging area for records read through stdio or split across chunks
+    std::vector< unsigned char > m_rec;
+
+    // file offsets of the first event and of the end of the events, and
+    // the block footer and optional index
+    unsigned long long m_start;
+    unsigned long long m_end;
+    LSE_Footer         m_footer;
+    LSE_Index*         m_index;
+    bool               m_indexTried;
+
+    // what the header was read from, to skip reading it again on reopen()
+    LSE_FileStamp      m_stamp;
+
+    // record decoding for CONTEXT_DELTA and HANDLER_TABLE files; m_stored
+    // is the length in the file of the record fetchRecord() last returned,
+    // and m_decodedAt the offset of the next one while the codec holds the
+    // context before it (~0 when unknown)
+    LSE_ContextCodec*            m_codec;
+    LSE_HandlerTable*            m_htable;
+    std::vector< unsigned char > m_decoded;
+    size_t                       m_stored;
+    unsigned long long           m_decodedAt;
+
+    // optional record filter
+    LSE_EventFilter*   m_filter;
+    FilterStats        m_filterStats;
 
     bool read( LSE_Context&, EBF_Data& );
-    void read( unsigned char*, size_t& );
+    bool readSkipEBF( LSE_Context& );
+    void skip( size_t );
+    void skipMeta();
+    bool readRecord( const unsigned char*&, size_t&, bool ebf = true );
+    bool fetchRecord( const unsigned char*&, size_t& );
+    bool fetchStored( const unsigned char*&, size_t& );
+    size_t measure( const unsigned char*, size_t ) const;
+    size_t decode( const unsigned char*, size_t );
+    bool readStaged( const unsigned char*&, size_t&, bool ebf );
+    void stage( size_t, size_t );
+    bool readView( LSE_EventView&, bool ebf );
+    bool readChunked( const unsigned char*&, size_t& );
+    void unpack( const LSE_EventView&, LSE_Context&, EBF_Data&, 
+		 LSE_Info::InfoType&, LPA_Info&, LCI_ACD_Info&, LCI_CAL_Info&, LCI_TKR_Info&, 
+		 LSE_Keys::KeysType&, LPA_Keys&, LCI_Keys& );
+    void unpack( const LSE_EventView&,
+		 LSE_Info::InfoType&, LPA_Info&, LCI_ACD_Info&, LCI_CAL_Info&, LCI_TKR_Info&, 
+		 LSE_Keys::KeysType&, LPA_Keys&, LCI_Keys& );
+    void map();
+    void prefetch();
+    void inflate();
+    void read( std::vector< unsigned char >&, size_t& );
     void read( LPA_Keys& );
     void read( LCI_Keys& );
     void read( LSE_Keys& );
     void readKeys( LSE_Keys::KeysType&, LPA_Keys&, LCI_Keys& );
     void readInfo( LSE_Info::InfoType&, LPA_Info&, LCI_ACD_Info&, LCI_CAL_Info&, LCI_TKR_Info& );
     void readHeader();
+    void start();
+    bool seekEntry( size_t );
+    bool scanTo( bool bytime, unsigned long long target, unsigned long long from );
+    bool pastEnd();
+    int reposition( unsigned long long );
+    int seekDecoded( unsigned long long );
   };
   
 };
@@ -15,8 +15,15 @@
 
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "eventFile/LSEHeader.h"
+#include "eventFile/LSE_Index.h"
+#include "eventFile/LSE_ContextColumns.h"
+#include "eventFile/LSE_Footer.h"
+
+#define LSEWRITER_DEFAULT_BLOCK 1024
+#define LSEWRITER_DEFAULT_QUEUE 256
 
 namespace eventFile {
 
@@ -28,22 +35,149 @@ namespace eventFile {
   class LCI_TKR_Info;
   struct LPA_Keys;
   struct LCI_Keys;
+  class LSE_UringWriter;
+  class LSE_StagedWriter;
+  class LSE_ContextCodec;
+  class LSE_HandlerTable;
+  class LSE_WriteQueue;
+  class LSE_EventView;
+  class LSE_PositionalReader;
   
   class LSEWriter {
   public:
-    LSEWriter( const std::string& filename, unsigned runid = 0 );
+
+    /** enumerate the ways event data can be written */
+    enum IOMode {
+      STDIO = 0,  /// buffered stdio writes
+      URING = 1,  /// large positional writes through io_uring (Linux only)
+      STAGED = 2, /// whole events gathered into one large buffer, flushed with writev()
+    };
+
+    /** statistics of the asynchronous writer */
+    struct AsyncStats {
+      AsyncStats() : events( 0 ), depth( 0 ), maxDepth( 0 ), stalls( 0 ), blockedTime( 0.0 ) {};
+      unsigned long long events;       /// events handed to the writer thread
+      unsigned           depth;        /// events queued but not yet written
+      unsigned           maxDepth;     /// the most events ever queued at once
+      unsigned long long stalls;       /// times a producer waited for room
+      double             blockedTime;  /// total seconds producers waited
+    };
+
+    /** bufsize sets the size of the staging buffers used in URING and
+	STAGED modes, and depth the number of them in URING mode; they are
+	ignored otherwise */
+    LSEWriter( const std::string& filename, unsigned runid = 0, IOMode mode = STDIO,
+	       unsigned depth = 4, size_t bufsize = 1024*1024 );
     ~LSEWriter();
 
     std::string name() const { return m_name; };
+    IOMode mode() const { return m_mode; };
 
     void write( const LSE_Context&, const EBF_Data&, const LPA_Info&, const LPA_Keys& );
     void write( const LSE_Context&, const EBF_Data&, const LCI_ACD_Info&, const LCI_Keys& );
     void write( const LSE_Context&, const EBF_Data&, const LCI_CAL_Info&, const LCI_Keys& );
     void write( const LSE_Context&, const EBF_Data&, const LCI_TKR_Info&, const LCI_Keys& );
 
+    /** write the record behind a view, e.g. one read by LSEReader, as is:
+	only the header, index and footer bookkeeping look inside it */
+    void write( const LSE_EventView& );
+
+    /** append the nevents records stored in [begin, end) of src, the first
+	and last with the given contexts, e.g. as found by
+	LSE_PositionalReader::probe().  When neither the writer nor src
+	encodes its records and the writer keeps no index, columns or
+	blocks, the bytes are moved by the kernel with copy_file_range()
+	where it is available, without passing through this process;
+	otherwise each record is read and written as by write( view ). */
+    void copy( const LSE_PositionalReader& src, unsigned long long begin, unsigned long long end,
+	       unsigned long long nevents, const LSE_Context& first, const LSE_Context& last );
+
+    /** finish the file and close it with its index and columns; every step
+	is taken even if one fails, and then the first error is thrown.  The
+	destructor closes too, but swallows the error. */
     void close();
 
-    // header mutators
+    /** hand events to a writer thread through a queue of depth serialized
+	records: write() then only packs the event, and the encoding, file
+	I/O and header, index and footer bookkeeping happen on that thread.
+	write() may then be called from several threads, and blocks while
+	the queue is full.  Errors on the writer thread are thrown by the
+	next write(), flush() or close().  The header accessors lag behind
+	write() until flush(); tell() flushes first.  LSEWRITER_ASYNC=<depth>
+	in the environment does the same for every writer. */
+    void enableAsync( unsigned depth = LSEWRITER_DEFAULT_QUEUE );
+    bool async() const { return m_queue != NULL; };
+    AsyncStats asyncStats() const;
+
+    /** wait for the writer thread to write every queued event */
+    void flush();
+
+    /** reserve disk space for about nbytes more of events with fallocate(),
+	so that the file is laid out in few extents.  The file keeps its real
+	length, and close() frees whatever was not used by truncating the
+	file past its end and back.  Returns false
+	where the platform or filesystem cannot reserve space.
+	LSEWRITER_PREALLOC=<bytes> in the environment does the same for
+	every writer. */
+    bool preallocate( unsigned long long nbytes );
+    bool preallocate( unsigned long long nevents, unsigned long long eventBytes )
+      {
+	return preallocate( nevents * eventBytes );
+      };
+
+    /** also write a binary LSE_Index of the events; the default name is
+	LSE_Index::name( filename ).  Setting LSEWRITER_INDEX in the
+	environment does the same for every writer.  Must be called before
+	the first event is written. */
+    void enableIndex( const std::string& idxname = "" );
+    bool indexed() const { return m_idxFILE != NULL; };
+
+    /** also write an LSE_ContextColumns sidecar of the events' numeric
+	context fields; the default name is LSE_ContextColumns::name( filename ).
+	LSEWRITER_COLUMNS in the environment does the same for every writer.
+	Must be called before the first event is written. */
+    void enableColumns( const std::string& colname = "" );
+    bool columnar() const { return m_colFILE != NULL; };
+
+    /** group the events into blocks of nevents records and end the file
+	with an LSE_Footer of per-block zone maps.  This writes the v10
+	(blocked) format, into the header at once, so readers refuse a file
+	whose footer was never written.  LSEWRITER_BLOCK=<nevents> in the
+	environment does the same for every writer.  Must be called before
+	the first event is written. */
+    void enableBlocks( unsigned nevents );
+    unsigned blockEvents() const { return m_blockEvents; };
+
+    /** deflate each block with zlib at the given level (1 is fastest) and
+	mark the footer COMPRESSED; LSEReader inflates such files
+	transparently.  Turns on blocks of LSEWRITER_DEFAULT_BLOCK events if
+	enableBlocks() has not been called.  LSEWRITER_COMPRESS=<level> in
+	the environment does the same for every writer.  Must be called
+	before the first event is written. */
+    void enableCompression( int level = 1 );
+    bool compressed() const { return m_zlevel >= 0; };
+
+    /** store each event's context as its changes from the previous event's,
+	with a full context at the start of every block; LSEReader rebuilds
+	the contexts transparently.  Turns on blocks of LSEWRITER_DEFAULT_BLOCK
+	events if enableBlocks() has not been called.  LSEWRITER_CTXDELTA in
+	the environment does the same for every writer.  Must be called
+	before the first event is written. */
+    void enableContextDelta();
+    bool contextDelta() const { return m_ctxcodec != NULL; };
+
+    /** store the fixed configuration fields of LPA handlers once, in a
+	table in the footer, and only each handler's table index and
+	per-event results in the records; LSEReader rebuilds the handlers
+	transparently.  Turns on blocks of LSEWRITER_DEFAULT_BLOCK events if
+	enableBlocks() has not been called.  LSEWRITER_HANDLERS in the
+	environment does the same for every writer.  Must be called before
+	the first event is written. */
+    void enableHandlerTable();
+    bool handlerTable() const { return m_htable != NULL; };
+
+    // header mutators; with enableAsync(), call these between flush() and
+    // the next write()
     void seqErr( unsigned apid, unsigned seqerr, int islot )
       {
 	if ( islot >= LSEHEADER_MAX_APIDS ) return;
@@ -64,6 +198,9 @@ namespace eventFile {
     unsigned long long evtcnt() const { return m_hdr.m_evtcnt; };
     unsigned long long begGEM() const { return m_hdr.m_GEMseq_beg; };
     unsigned long long endGEM() const { return m_hdr.m_GEMseq_end; };
+    unsigned mootKey() const { return m_meta.moot_key(); };
+    const char* mootAlias() const { return m_meta.moot_alias(); };
+    const LSEHeaderMeta& meta() const { return m_meta; };
     std::pair<unsigned, unsigned> seqErr( int islot ) const
       {
 	if ( islot < LSEHEADER_MAX_APIDS ) {
@@ -81,7 +218,8 @@ namespace eventFile {
 	}
       };
 
-    // file position accessor
+    // file position accessor; when compressing, the position in the
+    // uncompressed event stream
 #ifdef _FILE_OFFSET_BITS
     off_t tell();
 #else
@@ -91,12 +229,63 @@ namespace eventFile {
   private:
     std::string m_name;
     LSEHeader m_hdr;
+    LSEHeaderMeta m_meta;
     FILE* m_FILE;
+    IOMode m_mode;
+    LSE_UringWriter* m_uring;
+    LSE_StagedWriter* m_staged;
+    bool m_prealloc;
+
+    // the event being serialized
+    std::vector< unsigned char > m_rec;
+
+    // optional sidecar index
+    std::string m_idxname;
+    FILE* m_idxFILE;
+    LSE_IndexHeader m_idxhdr;
+
+    // optional columnar context sidecar, written a block at a time
+    std::string m_colname;
+    FILE* m_colFILE;
+    LSE_ColumnsHeader m_colhdr;
+    LSE_ContextColumns m_cols;
+
+    // optional block footer, and the block being filled
+    unsigned m_blockEvents;
+    LSE_Footer m_footer;
+    LSE_BlockInfo m_block;
+
+    // optional compression: the records of the current block, gathered
+    // for deflating, and the stream position of the next record
+    int m_zlevel;
+    std::vector< unsigned char > m_frame;
+    std::vector< unsigned char > m_zbuf;
+    unsigned long long m_logical;
+
+    // optional context delta encoding, and the record it produces
+    LSE_ContextCodec* m_ctxcodec;
+    std::vector< unsigned char > m_enc;
+
+    // optional handler-config table
+    LSE_HandlerTable* m_htable;
+
+    // optional writer thread, and its statistics once stopped
+    LSE_WriteQueue* m_queue;
+    AsyncStats m_astats;
+    friend class LSE_WriteQueue;
 
-    void write( const LSE_Context&, const EBF_Data& );
-    void write( int, const void*, size_t );
-    void write( const LPA_Keys& );
-    void write( const LCI_Keys& );
+    void pack( const LSE_Context&, const EBF_Data& );
+    void pack( int, const void*, size_t );
+    void pack( const LPA_Keys& );
+    void pack( const LCI_Keys& );
+    void submit( const LSE_Context&, int itype, int ktype );
+    void commit( std::vector< unsigned char >& rec, const LSE_Context&, int itype, int ktype );
+    void encodeContext( std::vector< unsigned char >& rec, const LSE_Context& );
+    void addToBlock( const LSE_Context&, int itype, unsigned long long ofst, size_t len );
+    void output( const unsigned char*, size_t );
+    bool plain() const;
+    void writeFrame();
+    unsigned long long position();
     void writeHeader();
   };
   
@@ -83,10 +83,13 @@ namespace eventFile {
     char reasonTxt[16];
   };
 
+  struct LSEHeaderMeta;
+
   struct LSE_Context {
 
     LSE_Context() {};
     void dump() const;
+    void dump( const LSEHeaderMeta& meta ) const;
 
     // from the enclosing CCSDS packet stream
     FromCcsds ccsds;
@@ -109,7 +112,9 @@ namespace eventFile {
     // from the close info
     FromClose close;
 
-    // from MOOT
+    // from MOOT; deprecated: these report the process-global LSEHeader
+    // values, filled once from the first file an LSEReader opens.  Use the
+    // mootKey()/mootAlias() of the owning reader or of an LSE_EventView.
     unsigned    mootKey()   const;
     const char* mootAlias() const;
   };
@@ -0,0 +1,89 @@
+/** -*- Mode: C++; -*-
+ * @class eventFile::LSE_ContextColumns
+ *
+ * @brief Numeric LSE_Context fields held column-wise, and their sidecar file
+ *
+ * LSEWriter can write a columnar sidecar (conventionally the event-file name
+ * with ".cols" appended) holding the scaler, timetone and CCSDS-time fields
+ * of every event's context.  The file is a short header followed by blocks
+ * of up to LSE_COLUMNS_BLOCK events; within a block each field is one
+ * contiguous array in host (little-endian) byte order.  load() concatenates
+ * the blocks, so reports that only need these counters can sum plain arrays
+ * instead of walking the event file.
+ *
+ * @author agent <agent@local>
+ *
+ * $Header$
+ */
+
+#ifndef EVENTFILE_LSE_CONTEXTCOLUMNS_HH
+#define EVENTFILE_LSE_CONTEXTCOLUMNS_HH
+
+#include <stdio.h>
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+#define LSE_COLUMNS_MARKER  0xFAF32C01
+#define LSE_COLUMNS_VERSION 1
+#define LSE_COLUMNS_BLOCK   65536
+
+namespace eventFile {
+
+  struct LSE_Context;
+
+  /// the leading block of a columns file
+  struct LSE_ColumnsHeader {
+    unsigned           marker;
+    unsigned           version;
+    unsigned           ncolumns;
+    unsigned           runid;
+    unsigned long long count;
+
+    LSE_ColumnsHeader();
+
+    void read( FILE*, const std::string& );
+    void write( FILE*, const std::string& );
+  };
+
+  struct LSE_ContextColumns {
+    LSE_ContextColumns() {};
+
+    /// the conventional sidecar name for an event file
+    static std::string name( const std::string& evtfile ) { return evtfile + ".cols"; };
+
+    size_t size() const { return sequence.size(); }
+    bool empty() const { return sequence.empty(); }
+    void clear();
+    void reserve( size_t nevents );
+    void append( const LSE_Context& );
+
+    /// replace the content with the whole of the named columns file,
+    /// returning the header
+    LSE_ColumnsHeader load( const std::string& filename );
+
+    /// block i/o used by LSEWriter and load()
+    void writeBlock( FILE*, const std::string& ) const;
+    bool readBlock( FILE*, const std::string& );
+
+    // scaler columns
+    std::vector< unsigned long long > elapsed;
+    std::vector< unsigned long long > livetime;
+    std::vector< unsigned long long > prescaled;
+    std::vector< unsigned long long > discarded;
+    std::vector< unsigned long long > sequence;
+    std::vector< unsigned long long > deadzone;
+
+    // current timetone and CCSDS columns
+    std::vector< double >             utc;
+    std::vector< unsigned >           timeSecs;
+    std::vector< unsigned >           tics;
+    std::vector< unsigned >           hacks;
+
+    static const unsigned NCOLUMNS = 10;
+  };
+
+};
+
+#endif
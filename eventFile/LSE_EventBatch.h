@@ -0,0 +1,61 @@
+/** -*- Mode: C++; -*-
+ * @class eventFile::LSE_EventBatch
+ *
+ * @brief Column-wise summary of a batch of events
+ *
+ * An LSE_EventBatch is filled by LSEReader::readBatch().  Each of the
+ * commonly-used context and type fields is held in its own contiguous array,
+ * indexed by event number within the batch, and the EBF for every event is
+ * packed back-to-back into a single payload buffer.  Clearing a batch keeps
+ * its storage, so a batch can be refilled repeatedly without reallocating.
+ *
+ * @author agent <agent@local>
+ *
+ * $Header$
+ */
+
+#ifndef EVENTFILE_LSE_EVENTBATCH_HH
+#define EVENTFILE_LSE_EVENTBATCH_HH
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "eventFile/LSE_Info.h"
+#include "eventFile/LSE_Keys.h"
+
+namespace eventFile {
+
+  class LSE_EventView;
+
+  struct LSE_EventBatch {
+    LSE_EventBatch() {};
+
+    size_t size() const { return sequence.size(); }
+    bool empty() const { return sequence.empty(); }
+    void clear();
+    void reserve( size_t nevents, size_t nbytes );
+    void append( const LSE_EventView& );
+
+    // EBF accessors for event i
+    const unsigned char* ebf( size_t i ) const { return payload.empty() ? NULL : &payload[0] + ebfOffset[i]; }
+    unsigned ebfSize( size_t i ) const { return ebfLength[i]; }
+
+    // context columns
+    std::vector< unsigned long long > sequence;  /// scalers.sequence
+    std::vector< unsigned >           timeSecs;  /// current.timeSecs
+    std::vector< unsigned long long > livetime;  /// scalers.livetime
+
+    // type columns
+    std::vector< LSE_Info::InfoType > infotype;
+    std::vector< LSE_Keys::KeysType > keystype;
+
+    // EBF location within the payload buffer
+    std::vector< size_t >             ebfOffset;
+    std::vector< unsigned >           ebfLength;
+    std::vector< unsigned char >      payload;
+  };
+
+};
+
+#endif
@@ -0,0 +1,122 @@
+/** -*- Mode: C++; -*-
+ * @class eventFile::LSE_EventFetcher
+ *
+ * @brief Reads events by file offset on a pool of threads, returning them in request order
+ *
+ * request() queues a read of the record at an offset of an
+ * LSE_PositionalReader.  Worker threads take the requests in turn and read
+ * them concurrently, so reads from different files, or from distant parts
+ * of one file, overlap instead of following one another.  next() returns
+ * the results in exactly the order they were requested, waiting for the
+ * oldest if it is still being read: the slots form a reorder buffer of
+ * depth requests, and request() blocks while they are all in use.  A
+ * request may ask for only the record's context and extent, as
+ * LSE_PositionalReader::probe() finds them.
+ *
+ * An error reading a record is thrown by the next() that would have
+ * returned it.  The readers must outlive the requests made of them.
+ * request() and next() must be called from one thread.  Not available on
+ * WIN32.
+ *
+ * @author agent <agent@local>
+ *
+ * $Header$
+ */
+
+#ifndef EVENTFILE_LSE_EVENTFETCHER_HH
+#define EVENTFILE_LSE_EVENTFETCHER_HH
+
+#ifndef WIN32
+
+#include <pthread.h>
+
+#include <string>
+#include <vector>
+
+#include "eventFile/LSE_Context.h"
+#include "eventFile/LSE_EventView.h"
+#include "eventFile/LSE_PositionalReader.h"
+
+namespace eventFile {
+
+  class LSE_EventFetcher {
+  public:
+
+    /** statistics of the fetcher */
+    struct Stats {
+      Stats() : requests( 0 ), waits( 0 ), waitTime( 0.0 ) {};
+      unsigned long long requests;  /// reads requested
+      unsigned long long waits;     /// times next() waited for a read to finish
+      double             waitTime;  /// total seconds next() waited
+    };
+
+    /// nthreads workers (0 means one per online CPU) and depth outstanding requests
+    LSE_EventFetcher( unsigned nthreads, unsigned depth );
+    ~LSE_EventFetcher();
+
+    /** queue a read of the record at ofst of src, or of only its context
+	and extent if extentOnly is set */
+    void request( const LSE_PositionalReader& src, unsigned long long ofst, bool extentOnly = false );
+
+    /** wait for the oldest outstanding request, which read a whole record.
+	Returns false if there was no event at its offset; otherwise points
+	the view at the record, until the next request() or next(), and sets
+	end to the offset of the record after it. */
+    bool next( LSE_EventView& view, unsigned long long& end );
+
+    /// the same for a request of the context, types and extent only
+    bool next( LSE_Context& ctx, LSE_Info::InfoType& infotype, LSE_Keys::KeysType& keystype,
+	       unsigned long long& end );
+
+    unsigned depth() const { return m_slots.size(); };
+    Stats stats() const;
+
+  private:
+    enum SlotState { QUEUED, READING, DONE };
+    struct Slot {
+      const LSE_PositionalReader*  src;
+      unsigned long long           ofst;
+      bool                         extentOnly;
+      SlotState                    state;
+      bool                         found;
+      LSE_Context                  ctx;
+      LSE_Info::InfoType           infotype;
+      LSE_Keys::KeysType           keystype;
+      unsigned long long           end;
+      LSE_PositionalReader::Buffer buf;
+      LSE_EventView                view;
+      std::string                  error;
+    };
+
+    std::vector<Slot>      m_slots;
+    unsigned               m_head;      // oldest request not yet returned by next()
+    unsigned               m_count;     // slots in use, including a held one
+    unsigned               m_take;      // next slot a worker will read
+    unsigned               m_queued;    // slots waiting for a worker
+    bool                   m_held;      // the caller holds the slot at m_head
+    bool                   m_stop;
+
+    std::vector<pthread_t> m_threads;
+    mutable pthread_mutex_t m_mutex;
+    pthread_cond_t         m_queuedCond;
+    pthread_cond_t         m_doneCond;
+    pthread_cond_t         m_freedCond;
+
+    Stats                  m_stats;
+
+    static void* run( void* );
+    void loop();
+    void release();
+    Slot& oldest( bool extentOnly );
+    void shutdown();
+
+    // not copyable
+    LSE_EventFetcher( const LSE_EventFetcher& );
+    LSE_EventFetcher& operator=( const LSE_EventFetcher& );
+  };
+
+}
+
+#endif // WIN32
+
+#endif
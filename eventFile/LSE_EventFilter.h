@@ -0,0 +1,66 @@
+/** -*- Mode: C++; -*-
+ * @class eventFile::LSE_EventFilter
+ *
+ * @brief Predicate LSEReader applies to each record before decoding it
+ *
+ * A filter installed with LSEReader::setFilter() sees every record as an
+ * LSE_EventView before anything is copied out of it; rejected records are
+ * skipped and never reach the caller.  The predicate may look at the
+ * context, the meta-info (including the LPA_Handler array) and the keys,
+ * but not at the EBF: in STDIO mode the EBF is only read in after the event
+ * has been accepted, so the view shows it as empty.
+ *
+ * @author agent <agent@local>
+ *
+ * $Header$
+ */
+
+#ifndef EVENTFILE_LSE_EVENTFILTER_HH
+#define EVENTFILE_LSE_EVENTFILTER_HH
+
+#include <stdio.h>
+
+#include "eventFile/LSE_Info.h"
+#include "eventFile/LPA_Handler.h"
+
+namespace eventFile {
+
+  class LSE_EventView;
+
+  class LSE_EventFilter {
+  public:
+    virtual ~LSE_EventFilter() {};
+
+    /// return true to keep the event
+    virtual bool accept( const LSE_EventView& ) = 0;
+  };
+
+  /// keep events carrying one kind of meta-info, e.g. LSE_Info::LCI_CAL
+  class LSE_InfoTypeFilter : public LSE_EventFilter {
+  public:
+    explicit LSE_InfoTypeFilter( LSE_Info::InfoType itype ) : m_itype( itype ) {};
+    bool accept( const LSE_EventView& );
+  private:
+    LSE_Info::InfoType m_itype;
+  };
+
+  /// keep LPA events in which the given handler reported the given state,
+  /// e.g. GAMMA and LEAKED, optionally through a particular prescaler
+  class LSE_HandlerFilter : public LSE_EventFilter {
+  public:
+    LSE_HandlerFilter( LPA_Handler::HandlerId id, LPA_Handler::RsdState state ) :
+      m_id( id ), m_state( state ), m_prescaler( LPA_Handler::UNSUPPORTED ), m_anyPrescaler( true ) {};
+    LSE_HandlerFilter( LPA_Handler::HandlerId id, LPA_Handler::RsdState state,
+		       LPA_Handler::LeakedPrescaler prescaler ) :
+      m_id( id ), m_state( state ), m_prescaler( prescaler ), m_anyPrescaler( false ) {};
+    bool accept( const LSE_EventView& );
+  private:
+    LPA_Handler::HandlerId       m_id;
+    LPA_Handler::RsdState        m_state;
+    LPA_Handler::LeakedPrescaler m_prescaler;
+    bool                         m_anyPrescaler;
+  };
+
+}
+
+#endif
@@ -0,0 +1,121 @@
+/** -*- Mode: C++; -*-
+ * @class eventFile::LSE_EventView
+ *
+ * @brief Read-only view of one serialized event record
+ *
+ * An LSE_EventView refers directly to the bytes of a single record as it is
+ * laid out in an .evt file (context, EBF, meta-info, translated keys) instead
+ * of copying them into separate objects.  Views are filled in by
+ * LSEReader::read( LSE_EventView& ) and remain valid only until the next
+ * read(), seek() or close() on the reader that produced them.
+ *
+ * The fixed-size members are referenced in place, so the view is only as
+ * aligned as the underlying record.  That is fine on the x86 platforms we
+ * run on; elsewhere, use the copying LSEReader::read() interface.
+ *
+ * @author agent <agent@local>
+ *
+ * $Header$
+ */
+
+#ifndef EVENTFILE_LSE_EVENTVIEW_HH
+#define EVENTFILE_LSE_EVENTVIEW_HH
+
+#include <stddef.h>
+
+#include "eventFile/LSE_Info.h"
+#include "eventFile/LSE_Keys.h"
+
+namespace eventFile {
+
+  struct LSE_Context;
+  struct LSEHeaderMeta;
+  class EBF_Data;
+  class LPA_Handler;
+
+  class LSE_EventView {
+  public:
+    LSE_EventView();
+
+    /** return the number of bytes needed to make progress on the record that
+	starts at buf.  If the return value is <= avail, the record is complete
+	and the return value is its total length; otherwise the caller must
+	supply at least that many bytes and ask again. */
+    static size_t measure( const unsigned char* buf, size_t avail );
+
+    /// measure() for records whose LPA handlers are handlerSize bytes each,
+    /// and for the part of such a record that follows the context; that
+    /// also gives the meta-info and key types once it has reached them
+    static size_t measure( const unsigned char* buf, size_t avail, size_t handlerSize );
+    static size_t measureBody( const unsigned char* buf, size_t avail, size_t handlerSize,
+			       LSE_Info::InfoType* infotype = NULL, LSE_Keys::KeysType* keystype = NULL );
+
+    /** point the view at the record starting at buf.  Returns the record
+	length, or 0 if fewer than that many bytes are available. */
+    size_t parse( const unsigned char* buf, size_t avail );
+
+    /// attach the header metadata of the file the record came from; readers
+    /// do this for every view they fill
+    void bind( const LSEHeaderMeta* meta ) { m_meta = meta; }
+    const LSEHeaderMeta* meta() const { return m_meta; }
+
+    // raw record accessors
+    const unsigned char* record() const { return m_rec; }
+    size_t size() const { return m_len; }
+
+    // context and EBF accessors
+    const LSE_Context& ctx() const { return *reinterpret_cast< const LSE_Context* >( m_rec ); }
+    const unsigned char* ebf() const { return m_ebf; }
+    unsigned ebfSize() const { return m_ebflen; }
+
+    /// MOOT key/alias of the file the record came from; the process-global
+    /// LSEHeader values if no metadata is bound
+    unsigned mootKey() const;
+    const char* mootAlias() const;
+
+    // meta-info accessors
+    LSE_Info::InfoType infotype() const { return m_itype; }
+    const LSE_Info* info() const { return reinterpret_cast< const LSE_Info* >( m_info ); }
+    unsigned nhandlers() const { return m_nhandlers; }
+    const LPA_Handler* handlers() const;
+    /// NULL unless the record is of that type and stores the whole struct;
+    /// copy() also takes a shorter block, zero-filling the rest
+    const LCI_ACD_Info* ainfo() const;
+    const LCI_CAL_Info* cinfo() const;
+    const LCI_TKR_Info* tinfo() const;
+
+    // translated-keys accessors
+    LSE_Keys::KeysType keystype() const { return m_ktype; }
+    unsigned LATC_master() const;
+    unsigned LATC_ignore() const;
+
+    /// offset of the translated keys (LATC_master first) within the record,
+    /// for patching a copy of it
+    size_t keysOffset() const { return m_keys - m_rec; }
+
+    // copy the viewed content into the objects used by the copying interface
+    void copy( EBF_Data& ) const;
+    void copy( LPA_Info& ) const;
+    void copy( LCI_ACD_Info& ) const;
+    void copy( LCI_CAL_Info& ) const;
+    void copy( LCI_TKR_Info& ) const;
+    void copy( LPA_Keys& ) const;
+    void copy( LCI_Keys& ) const;
+
+  private:
+    const unsigned char* m_rec;
+    size_t               m_len;
+    const unsigned char* m_ebf;
+    unsigned             m_ebflen;
+    LSE_Info::InfoType   m_itype;
+    const unsigned char* m_info;
+    unsigned             m_nhandlers;
+    unsigned             m_infolen;
+    LSE_Keys::KeysType   m_ktype;
+    const unsigned char* m_keys;
+    const LSEHeaderMeta* m_meta;
+  };
+
+};
+
+#endif
@@ -0,0 +1,46 @@
+/** -*- Mode: C++; -*-
+ * @class eventFile::LSE_FileStamp
+ *
+ * @brief What an open file was when its header was read
+ *
+ * LSEReader and LSE_PositionalReader keep the header, footer and index of a
+ * file across close() and reopen() as long as the file reopened is the one
+ * they were read from.  The stamp holds the device, inode, size and
+ * modification time, to the nanosecond where the platform keeps it, so a
+ * file rewritten in place within the same second is still told apart.  A
+ * default-constructed stamp matches no file.  Not available on WIN32, where
+ * take() always reports a change.
+ *
+ * @author agent <agent@local>
+ *
+ * $Header$
+ */
+
+#ifndef EVENTFILE_LSE_FILESTAMP_HH
+#define EVENTFILE_LSE_FILESTAMP_HH
+
+namespace eventFile {
+
+  class LSE_FileStamp {
+  public:
+    LSE_FileStamp();
+
+    // stamp the file open on fd, returning true if it is the file stamped
+    // before; a file that cannot be stat'd leaves the stamp cleared
+    bool take( int fd );
+
+    // forget the file, e.g. when what was read from it is dropped
+    void clear() { m_valid = false; };
+
+  private:
+    bool               m_valid;
+    unsigned long long m_dev;
+    unsigned long long m_ino;
+    unsigned long long m_size;
+    long long          m_mtime;
+    long               m_mtimeNsec;
+  };
+
+};
+
+#endif
@@ -0,0 +1,117 @@
+/** -*- Mode: C++; -*-
+ * @class eventFile::LSE_Footer
+ *
+ * @brief Per-block zone maps stored at the end of a blocked (v10) LSE file
+ *
+ * When LSEWriter::enableBlocks() is used, the events are grouped into blocks
+ * of a fixed number of records and the file gets the v10 LSEHeader format
+ * version.  Behind the last event the writer appends one LSE_BlockInfo per
+ * block, followed by a fixed-size trailer that ends the file.  The trailer
+ * locates the footer and the last event, so readers find both with two
+ * small reads, and the per-block minima and maxima let time- and
+ * sequence-window queries step over whole blocks.
+ *
+ * In a COMPRESSED file each block is stored as one frame: the raw and
+ * deflated lengths (two 32-bit words) followed by the zlib stream of its
+ * records.  Event, block and index offsets then refer to positions in the
+ * uncompressed event stream, which starts where the header ends just as in
+ * an uncompressed file; the footer adds a table of frame positions, which
+ * follows the block entries.
+ *
+ * In a CONTEXT_DELTA file each record starts with an encoded context (see
+ * LSE_ContextCodec) in place of the raw LSE_Context.  The first record of
+ * every block carries the whole context, so decoding can begin at any block.
+ *
+ * In a HANDLER_TABLE file each LPA_Handler of a record is stored compactly
+ * as an index into the footer's table of distinct handler configurations
+ * plus the per-event result fields (see LSE_HandlerTable).  The table, a
+ * count followed by the LSE_HandlerConfig entries, comes after the frame
+ * table.
+ *
+ * @author agent <agent@local>
+ *
+ * $Header$
+ */
+
+#ifndef EVENTFILE_LSE_FOOTER_HH
+#define EVENTFILE_LSE_FOOTER_HH
+
+#include <stdio.h>
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+#define LSE_FOOTER_MARKER 0xFAF32F00
+
+namespace eventFile {
+
+  /// location and zone map of one block of events, 48 bytes on disk
+  struct LSE_BlockInfo {
+    unsigned long long offset;       /// file offset of the first event
+    unsigned long long length;       /// bytes from the first event to the end of the last
+    unsigned long long minSequence;  /// smallest context.scalers.sequence
+    unsigned long long maxSequence;  /// largest context.scalers.sequence
+    unsigned           nevents;
+    unsigned           minSecs;      /// smallest context.current.timeSecs
+    unsigned           maxSecs;      /// largest context.current.timeSecs
+    unsigned           infotypes;    /// bit ( 1 << ( infotype + 1 ) ) set for each type present
+
+    /// does the block contain events with the given meta-info type?
+    bool has( int infotype ) const { return ( infotypes >> ( infotype + 1 ) ) & 1; }
+  };
+
+  /// the per-configuration fields of an LPA_Handler, 24 bytes on disk
+  struct LSE_HandlerConfig {
+    int      type;       /// LPA_Handler::HandlerType
+    unsigned masterKey;
+    unsigned cfgKey;
+    unsigned cfgId;
+    unsigned version;
+    int      id;         /// LPA_Handler::HandlerId
+  };
+
+  /// the fixed-size record that ends the file, 32 bytes on disk
+  struct LSE_Trailer {
+    unsigned long long footer;       /// file offset of the first LSE_BlockInfo
+    unsigned long long lastEvent;    /// file offset of the last event
+    unsigned           flags;        /// encodings used for the event data
+    unsigned           blockEvents;  /// events per block (the last may be short)
+    unsigned           nblocks;
+    unsigned           marker;
+  };
+
+  struct LSE_Footer {
+    LSE_Footer();
+
+    /// flag bits for the encodings used for the event data
+    static const unsigned COMPRESSED = 0x1;     /// each block is a zlib-deflated frame
+    static const unsigned CONTEXT_DELTA = 0x2;  /// contexts are stored as changes from the one before
+    static const unsigned HANDLER_TABLE = 0x4;  /// LPA handlers refer to the handler-config table
+
+    std::vector< LSE_BlockInfo > blocks;
+    std::vector< unsigned long long > frames;  /// file offset of each block's frame, if COMPRESSED
+    std::vector< LSE_HandlerConfig > handlers; /// the distinct handler configurations, if HANDLER_TABLE
+    unsigned long long offset;       /// where the footer starts, i.e. the end of the events
+    unsigned long long lastEvent;
+    unsigned           flags;
+    unsigned           blockEvents;
+
+    /// read the trailer and block table from the end of the file
+    void read( FILE*, const std::string& );
+
+    /// write the block table and trailer at the current file position
+    void write( FILE*, const std::string& );
+
+    /// first block that may hold an event with sequence >= seq (or
+    /// timeSecs >= secs), blocks.size() if there is none
+    size_t lowerSequence( unsigned long long seq ) const;
+    size_t lowerTime( unsigned secs ) const;
+
+    /// the block whose records span the offset, blocks.size() if none does
+    size_t find( unsigned long long ofst ) const;
+  };
+
+};
+
+#endif
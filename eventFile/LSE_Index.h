@@ -0,0 +1,81 @@
+/**
+ * @class eventFile::LSE_Index
+ *
+ * @brief Class representing the binary offset index written alongside an LSE event file
+ *
+ * The index (conventionally the event-file name with ".idx" appended) holds
+ * a short header followed by one fixed-size LSE_IndexEntry per event, in
+ * file order.  It is produced by LSEWriter in the same pass as the events.
+ *
+ * @author agent <agent@local>
+ *
+ * $Header$
+ */
+
+#ifndef LSE_INDEX_H
+#define LSE_INDEX_H
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#define LSE_INDEX_MARKER  0xFAF32D1C
+#define LSE_INDEX_VERSION 1
+
+namespace eventFile {
+
+  /// one event's location and summary, 32 bytes on disk
+  struct LSE_IndexEntry {
+    unsigned long long offset;    /// file offset of the event record
+    unsigned long long sequence;  /// context.scalers.sequence
+    unsigned           length;    /// record length in bytes
+    unsigned           timeSecs;  /// context.current.timeSecs
+    int                infotype;  /// LSE_Info::InfoType
+    int                keystype;  /// LSE_Keys::KeysType
+  };
+
+  /// the leading block of an index file
+  struct LSE_IndexHeader {
+    unsigned           marker;
+    unsigned           version;
+    unsigned           entrysize;
+    unsigned           runid;
+    unsigned long long count;
+
+    LSE_IndexHeader();
+
+    void read( FILE*, const std::string& );
+    void write( FILE*, const std::string& );
+  };
+
+  class LSE_Index {
+  public:
+    /// load the whole index from the named file
+    explicit LSE_Index( const std::string& filename );
+    ~LSE_Index() {};
+
+    /// the conventional index name for an event file
+    static std::string name( const std::string& evtfile ) { return evtfile + ".idx"; };
+
+    std::string filename() const { return m_name; };
+    unsigned runid() const { return m_hdr.runid; };
+    size_t size() const { return m_entries.size(); };
+    bool empty() const { return m_entries.empty(); };
+    const LSE_IndexEntry& operator[]( size_t i ) const { return m_entries[i]; };
+
+    /// position of the first entry with sequence >= seq (or timeSecs >= secs),
+    /// size() if there is none; entries must be in increasing order, as
+    /// LSEWriter produces them
+    size_t lowerSequence( unsigned long long seq ) const;
+    size_t lowerTime( unsigned secs ) const;
+
+  private:
+    std::string m_name;
+    LSE_IndexHeader m_hdr;
+    std::vector< LSE_IndexEntry > m_entries;
+  };
+
+}
+
+#endif
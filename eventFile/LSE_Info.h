@@ -11,13 +11,18 @@
 #ifndef EVENTFILE_LSE_INFO_HH
 #define EVENTFILE_LSE_INFO_HH
 
+#include <stdio.h>
+
 #include <vector>
 
 #include "eventFile/LSE_GemTime.h"
+#include "eventFile/LPA_Handler.h"
+
+// largest LCI_Info block a record may store
+#define LSE_INFO_MAX_LCI ( 128 * 1024 )
 
 namespace eventFile {
 
-  class LPA_Handler;
   class LSEReader;
   class LSEWriter;
 
@@ -48,7 +53,7 @@ namespace eventFile {
     std::vector< LPA_Handler > handlers;
 
   private:
-    void write( FILE* fp ) const;
+    void write( std::vector< unsigned char >& rec ) const;
     void read( FILE* fp );
     friend class LSEReader;
     friend class LSEWriter;
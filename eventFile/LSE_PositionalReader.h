@@ -0,0 +1,147 @@
+/** -*- Mode: C++; -*-
+ * @class eventFile::LSE_PositionalReader
+ *
+ * @brief Thread-safe reader that fetches events by file offset with pread()
+ *
+ * Unlike LSEReader, an LSE_PositionalReader has no cursor: every read()
+ * names the offset of the record it wants and reports the offset of the
+ * record after it.  All the read methods are const and use pread() on the
+ * one descriptor opened by the constructor, so any number of threads may
+ * read from the same object at once, each with its own Buffer.  Offsets
+ * come from dataOffset(), from the next offset of a previous read, or from
+ * the file's LSE_Index or block footer.
+ *
+ * Files written with LSEWriter::enableHandlerTable() and
+ * enableContextDelta() are decoded transparently; for the latter, a read
+ * from the middle of a block first decodes the contexts before it, from the
+ * start of the block or from the record last read into the same Buffer if
+ * that is nearer.  Compressed files must be read with LSEReader.  Not
+ * available on WIN32.
+ *
+ * @author agent <agent@local>
+ *
+ * $Header$
+ */
+
+#ifndef EVENTFILE_LSE_POSITIONALREADER_HH
+#define EVENTFILE_LSE_POSITIONALREADER_HH
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "eventFile/LSE_Info.h"
+#include "eventFile/LSEHeader.h"
+#include "eventFile/LSE_Keys.h"
+#include "eventFile/LSE_Footer.h"
+#include "eventFile/LSE_FileStamp.h"
+
+namespace eventFile {
+
+  class LSE_Context;
+  class EBF_Data;
+  class LSE_EventView;
+  class LSE_HandlerTable;
+
+  class LSE_PositionalReader {
+  public:
+
+    /** per-thread scratch space; views point into it until its next use */
+    struct Buffer {
+      Buffer() : serial( 0 ), next( 0 ) {};
+      std::vector< unsigned char > stored;   /// the record as it is in the file
+      std::vector< unsigned char > record;   /// the decoded record, for encoded files
+      unsigned long long           serial;   /// the file record was decoded from, 0 if none
+      unsigned long long           next;     /// the offset following record in that file
+    };
+
+    explicit LSE_PositionalReader( const std::string& filename );
+    ~LSE_PositionalReader();
+
+    /** read the record at ofst and point the view at it, returning false
+	at the end of the events.  If next is given, it receives the offset
+	of the following record. */
+    bool read( unsigned long long ofst, Buffer& buf, LSE_EventView& view,
+	       unsigned long long* next = NULL ) const;
+
+    /** find the extent of the record at ofst without reading its EBF
+	payload: ctx receives its context, infotype and keystype the types
+	of its meta-info and keys, and next the offset of the following
+	record.  Returns false at the end of the events.  Not for files
+	written with LSEWriter::enableContextDelta(). */
+    bool probe( unsigned long long ofst, LSE_Context& ctx, LSE_Info::InfoType& infotype,
+		LSE_Keys::KeysType& keystype, unsigned long long& next ) const;
+
+    /// the same, copied into the objects used by LSEReader::read()
+    bool read( unsigned long long ofst, LSE_Context&, EBF_Data&,
+	       LSE_Info::InfoType&, LPA_Info&, LCI_ACD_Info&, LCI_CAL_Info&, LCI_TKR_Info&,
+	       LSE_Keys::KeysType&, LPA_Keys&, LCI_Keys&,
+	       unsigned long long* next = NULL ) const;
+
+    /** close the file, keeping what was read of its header and footer.
+	reopen() opens it again, and reads those again only if the file's
+	size, modification time or inode has changed.  Neither may be called
+	while a read is in progress. */
+    void close();
+    void reopen();
+    bool isOpen() const { return m_FILE != NULL; };
+
+    std::string name() const { return m_name; };
+    unsigned long long dataOffset() const { return m_start; };  /// offset of the first event
+    unsigned long long endOffset() const { return m_end; };     /// offset just past the last event
+
+    /// the block footer of a blocked (v10) file, NULL otherwise
+    const LSE_Footer* footer() const { return m_hdr.blocked() ? &m_footer : NULL; };
+
+    /// true if the records are stored as LSEReader::read( LSE_EventView& ) presents them
+    bool canonical() const { return !m_delta && m_htable == NULL; };
+
+    /** tell the kernel that [ofst, ofst+len) of the file will be read soon,
+	with posix_fadvise( WILLNEED ); returns false where that is not
+	available, or if the file is closed */
+    bool willNeed( unsigned long long ofst, unsigned long long len ) const;
+
+    /// the descriptor read from, for copying records as they are, e.g. by LSEWriter::copy()
+    int descriptor() const { return m_fd; };
+
+    // header accessors
+    unsigned runid() const { return m_hdr.m_runid; };
+    unsigned begSec() const { return m_hdr.m_secs_beg; };
+    unsigned endSec() const { return m_hdr.m_secs_end; };
+    unsigned long long evtcnt() const { return m_hdr.m_evtcnt; };
+    unsigned long long begGEM() const { return m_hdr.m_GEMseq_beg; };
+    unsigned long long endGEM() const { return m_hdr.m_GEMseq_end; };
+    unsigned mootKey() const { return m_meta.moot_key(); };
+    const char* mootAlias() const { return m_meta.moot_alias(); };
+    const LSEHeaderMeta& meta() const { return m_meta; };
+
+  private:
+    std::string        m_name;
+    LSEHeader          m_hdr;
+    LSEHeaderMeta      m_meta;
+    FILE*              m_FILE;
+    int                m_fd;
+    unsigned long long m_start;
+    unsigned long long m_end;
+    LSE_Footer         m_footer;
+    LSE_HandlerTable*  m_htable;
+    bool               m_delta;
+    unsigned long long m_serial;   // unique to each header read, to match Buffers against
+
+    // what the header was read from, to skip reading it again on reopen()
+    LSE_FileStamp      m_stamp;
+
+    void open();
+
+    size_t measure( const unsigned char*, size_t ) const;
+    void fill( std::vector< unsigned char >&, size_t have, size_t need, unsigned long long ofst ) const;
+
+    // not copyable
+    LSE_PositionalReader( const LSE_PositionalReader& );
+    LSE_PositionalReader& operator=( const LSE_PositionalReader& );
+  };
+
+}
+
+#endif
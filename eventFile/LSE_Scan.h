@@ -0,0 +1,51 @@
+/** -*- Mode: C++; -*-
+ * @class eventFile::LSE_EventVisitor
+ *
+ * @brief Callback interface for forEachEvent(), the parallel whole-file scan
+ *
+ * forEachEvent() splits an .evt file into event-aligned ranges of roughly
+ * equal size, one per worker thread, and hands every event to the visitor
+ * exactly once.  The ranges come from the file's LSE_Index when it is
+ * present, from the block footer of a blocked file, and from a length-only
+ * pass over a memory-mapped copy of the file otherwise.  Each worker has its
+ * own LSEReader, so visit() is called concurrently from up to nthreads
+ * threads; the worker number lets an implementation keep per-thread
+ * accumulators without locking.  Within one worker, events arrive in file
+ * order.
+ *
+ * An exception thrown by visit() stops the other workers and is rethrown
+ * (as std::runtime_error) from forEachEvent().  Not available on WIN32.
+ *
+ * @author agent <agent@local>
+ *
+ * $Header$
+ */
+
+#ifndef EVENTFILE_LSE_SCAN_HH
+#define EVENTFILE_LSE_SCAN_HH
+
+#include <string>
+
+#include "eventFile/LSEReader.h"
+
+namespace eventFile {
+
+  class LSE_EventView;
+
+  class LSE_EventVisitor {
+  public:
+    virtual ~LSE_EventVisitor() {};
+
+    /// called once per event; the view is valid only for the duration of the call
+    virtual void visit( const LSE_EventView& view, unsigned worker ) = 0;
+  };
+
+  /// visit every event of the file on nthreads workers (0 means one per
+  /// online CPU), returning the number of events visited
+  unsigned long long forEachEvent( const std::string& filename, unsigned nthreads,
+				   LSE_EventVisitor& visitor,
+				   LSEReader::IOMode mode = LSEReader::MMAP );
+
+}
+
+#endif
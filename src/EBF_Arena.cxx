@@ -0,0 +1,69 @@
+#include "eventFile/EBF_Arena.h"
+
+namespace eventFile {
+
+  // keep every allocation aligned for the 32-bit EBF words
+  static const size_t EBF_ARENA_ALIGN = 8;
+
+  EBF_Arena::EBF_Arena( size_t blocksize ) :
+    m_blocksize( blocksize ), m_blocks(), m_current( 0 ), m_offset( 0 ), m_generation( 1 )
+  {
+  }
+
+  EBF_Arena::~EBF_Arena()
+  {
+    std::vector<Block>::iterator it( m_blocks.begin() );
+    for ( ; it != m_blocks.end(); ++it ) {
+      delete [] it->data;
+    }
+  }
+
+  unsigned char* EBF_Arena::allocate( size_t nbytes )
+  {
+    nbytes = ( nbytes + EBF_ARENA_ALIGN - 1 ) & ~( EBF_ARENA_ALIGN - 1 );
+
+    // move on to the next block with enough room, creating one if needed
+    while ( m_current < m_blocks.size() && m_offset + nbytes > m_blocks[m_current].size ) {
+      ++m_current;
+      m_offset = 0;
+    }
+    if ( m_current == m_blocks.size() ) {
+      Block b;
+      b.size = ( nbytes > m_blocksize ) ? nbytes : m_blocksize;
+      b.data = new unsigned char[ b.size ];
+      m_blocks.push_back( b );
+      m_offset = 0;
+    }
+
+    unsigned char* p = m_blocks[m_current].data + m_offset;
+    m_offset += nbytes;
+    return p;
+  }
+
+  void EBF_Arena::reset()
+  {
+    m_current = 0;
+    m_offset = 0;
+    ++m_generation;
+  }
+
+  size_t EBF_Arena::used() const
+  {
+    size_t n( m_offset );
+    for ( size_t i = 0; i < m_current && i < m_blocks.size(); ++i ) {
+      n += m_blocks[i].size;
+    }
+    return n;
+  }
+
+  size_t EBF_Arena::capacity() const
+  {
+    size_t n(0);
+    std::vector<Block>::const_iterator it( m_blocks.begin() );
+    for ( ; it != m_blocks.end(); ++it ) {
+      n += it->size;
+    }
+    return n;
+  }
+
+}
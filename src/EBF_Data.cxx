@@ -2,11 +2,82 @@
 #include <stdexcept>
 #include <sstream>
 #include <cstring>
+#ifndef WIN32
+#include <sys/types.h>
+#include <sys/stat.h>
+#endif
 
 #include "eventFile/EBF_Data.h"
+#include "eventFile/EBF_Arena.h"
 
 namespace eventFile {
 
+  // heap-backed payloads grow in units of this many bytes
+  static const unsigned EBF_DATA_QUANTUM = 4096;
+
+  // lengths read from a file above this are checked against what is left of
+  // it before any storage is reserved for them
+  static const unsigned EBF_DATA_TRUSTED_LEN = 256 * 1024;
+
+  EBF_Data::EBF_Data() :
+    m_data( NULL ), m_len( 0 ), m_cap( 0 ), m_arena( NULL ), m_generation( 0 )
+  {
+  }
+
+  EBF_Data::EBF_Data( EBF_Arena& arena ) :
+    m_data( NULL ), m_len( 0 ), m_cap( 0 ), m_arena( &arena ), m_generation( 0 )
+  {
+  }
+
+  EBF_Data::EBF_Data( const EBF_Data& other ) :
+    m_data( NULL ), m_len( 0 ), m_cap( 0 ), m_arena( NULL ), m_generation( 0 )
+  {
+    assign( other.m_len, other.m_data );
+  }
+
+  EBF_Data& EBF_Data::operator=( const EBF_Data& other )
+  {
+    if ( this != &other ) {
+      assign( other.m_len, other.m_data );
+    }
+    return *this;
+  }
+
+  EBF_Data::~EBF_Data()
+  {
+    release();
+  }
+
+  void EBF_Data::release()
+  {
+    if ( !m_arena ) {
+      delete [] m_data;
+    }
+    m_data = NULL;
+    m_cap = 0;
+  }
+
+  void EBF_Data::reserve( unsigned nbytes )
+  {
+    // storage drawn from an arena that has since been reset is no longer ours
+    if ( m_arena && m_generation != m_arena->generation() ) {
+      m_data = NULL;
+      m_cap = 0;
+    }
+    if ( nbytes <= m_cap ) return;
+
+    // the existing content is always overwritten, so don't preserve it
+    release();
+    if ( m_arena ) {
+      m_data = m_arena->allocate( nbytes );
+      m_cap = nbytes;
+      m_generation = m_arena->generation();
+    } else {
+      m_cap = ( nbytes + EBF_DATA_QUANTUM - 1 ) / EBF_DATA_QUANTUM * EBF_DATA_QUANTUM;
+      m_data = new unsigned char[ m_cap ];
+    }
+  }
+
   void EBF_Data::write( FILE* fp ) const
   {
     size_t nitems(0);
@@ -21,6 +92,7 @@ namespace eventFile {
     }
 
     // write out the ebf blob itself
+    if ( m_len == 0 ) return;
     nitems = fwrite( m_data, m_len, 1, fp );
     if ( nitems != 1 ) {
       std::ostringstream ess;
@@ -34,8 +106,12 @@ namespace eventFile {
   {
     size_t nitems(0);
 
+    // nothing is held until a whole blob has been read
+    m_len = 0;
+
     // read in the length of the EBF blob
-    nitems = fread( &m_len, sizeof( m_len ), 1, fp );
+    unsigned len(0);
+    nitems = fread( &len, sizeof( len ), 1, fp );
     if ( nitems != 1 ) {
       std::ostringstream ess;
       ess << "EBF_Data::read: error reading length ";
@@ -43,22 +119,55 @@ namespace eventFile {
       throw std::runtime_error( ess.str() );
     }
 
+#ifndef WIN32
+    // a corrupt length must not size the buffer, so one longer than any event
+    // should be is held to the bytes left in the file
+    if ( len > EBF_DATA_TRUSTED_LEN ) {
+      struct stat stbuf;
+#ifdef _FILE_OFFSET_BITS
+      long long here = ftello( fp );
+#else
+      long long here = ftell( fp );
+#endif
+      if ( here >= 0 && fstat( fileno( fp ), &stbuf ) == 0 && S_ISREG( stbuf.st_mode )
+	   && static_cast< long long >( len ) > stbuf.st_size - here ) {
+	std::ostringstream ess;
+	ess << "EBF_Data::read: EBF length " << len << " exceeds the ";
+	ess << stbuf.st_size - here << " bytes left in the file";
+	throw std::runtime_error( ess.str() );
+      }
+    }
+#endif
+
     // read in the EBF blob itself
-    nitems = fread( m_data, m_len, 1, fp );
+    if ( len == 0 ) return;
+    reserve( len );
+    nitems = fread( m_data, len, 1, fp );
     if ( nitems != 1 ) {
       std::ostringstream ess;
       ess << "EBF_Data::read: error reading data ";
       ess << "(" << errno << "=" << strerror( errno ) << ")";
       throw std::runtime_error( ess.str() );
     }
+    m_len = len;
   }
 
   void EBF_Data::init( unsigned nbytes, const void* payload )
   {
+    reserve( nbytes + 8 );
     *( reinterpret_cast< int* >( &m_data[0] ) ) = 0x104f0010  ;
     *( reinterpret_cast< int* >( &m_data[4] ) ) = nbytes +  8 ;
     memcpy( &m_data[8], payload, nbytes );
     m_len = nbytes + 8;
   }
 
+  void EBF_Data::assign( unsigned nbytes, const void* ebf )
+  {
+    reserve( nbytes );
+    if ( nbytes > 0 ) {
+      memcpy( m_data, ebf, nbytes );
+    }
+    m_len = nbytes;
+  }
+
 }
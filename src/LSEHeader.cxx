@@ -1,6 +1,10 @@
 #include <errno.h>
 #include <string.h>
 
+#ifndef WIN32
+#include <pthread.h>
+#endif
+
 #include <sstream>
 #include <stdexcept>
 
@@ -8,6 +12,12 @@
 
 namespace eventFile {
 
+  // set once anything has filled the static MOOT key/alias
+#ifndef WIN32
+  static pthread_mutex_t s_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+  static bool s_written = false;
+
   LSEHeader::LSEHeader() :
     m_version( FormatVersion ),
     m_runid(0), m_secs_beg(0), m_secs_end(0), m_evtcnt(0), m_GEMseq_beg(0), m_GEMseq_end(0)
@@ -18,7 +28,25 @@ namespace eventFile {
     memset( m_dfi_dfierr, 0, LSEHEADER_MAX_APIDS*sizeof(unsigned) );
   }
 
-  void LSEHeader::read( FILE* fp )
+  LSEHeaderMeta::LSEHeaderMeta() :
+    m_moot_key( 0xFFFFFFFF )
+  {
+    memset( m_moot_alias, 0, LSEHEADER_ALIAS_LEN );
+    strncpy( m_moot_alias, "UNSET", LSEHEADER_ALIAS_LEN-1 );
+  }
+
+  void LSEHeaderMeta::set_moot_key( unsigned k )
+  {
+    m_moot_key = k;
+  }
+
+  void LSEHeaderMeta::set_moot_alias( const char* a )
+  {
+    memset( m_moot_alias, 0, LSEHEADER_ALIAS_LEN );
+    strncpy( m_moot_alias, a, LSEHEADER_ALIAS_LEN-1 );
+  }
+
+  void LSEHeader::read( FILE* fp, LSEHeaderMeta& meta )
   {
     // check for the correct file marker value
     unsigned marker( 0 );
@@ -40,31 +68,33 @@ namespace eventFile {
     }
 
     // check for a version mismatch
-    if ( m_version != FormatVersion ) {
+    if ( m_version != FormatVersion && m_version != BlockedFormatVersion ) {
       std::ostringstream ess;
       ess << "LSEHeader::read: unsupported format, file is v" << version();
       ess << " reader is v" << (FormatVersion & 0x000000FF);
+      ess << "/v" << (BlockedFormatVersion & 0x000000FF);
       throw std::runtime_error( ess.str() );
     }
 
-    // read the MOOT key and alias into static members
-    nitems = fread( &m_moot_key, sizeof(unsigned), 1, fp );
+    // read the MOOT key and alias into the caller's metadata
+    nitems = fread( &meta.m_moot_key, sizeof(unsigned), 1, fp );
     if ( nitems != 1 ) {
       std::ostringstream ess;
       ess << "LSEHeader::read: error reading MOOT key, ";
       ess << "(" << errno << ":'" << strerror( errno ) << "')";
       throw std::runtime_error( ess.str() );
     }
-    nitems = fread( m_moot_alias, LSEHEADER_ALIAS_LEN, 1, fp );
+    nitems = fread( meta.m_moot_alias, LSEHEADER_ALIAS_LEN, 1, fp );
     if ( nitems != 1 ) {
       std::ostringstream ess;
       ess << "LSEHeader::read: error reading MOOT alias, ";
       ess << "(" << errno << ":'" << strerror( errno ) << "')";
       throw std::runtime_error( ess.str() );
     }
+    meta.m_moot_alias[LSEHEADER_ALIAS_LEN-1] = '\0';
   }
 
-  void LSEHeader::write( FILE* fp )
+  void LSEHeader::write( FILE* fp, const LSEHeaderMeta& meta )
   {
     // write out the header-marker value 0xFAF32000
     unsigned marker = 0xFAF32000;
@@ -74,8 +104,43 @@ namespace eventFile {
     fwrite( this, sizeof( LSEHeader ), 1, fp );
 
     // write out the MOOT key and alias
-    fwrite( &m_moot_key, sizeof( unsigned ), 1, fp );
-    fwrite( m_moot_alias, LSEHEADER_ALIAS_LEN, 1, fp );
+    fwrite( &meta.m_moot_key, sizeof( unsigned ), 1, fp );
+    fwrite( meta.m_moot_alias, LSEHEADER_ALIAS_LEN, 1, fp );
+  }
+
+  void LSEHeader::read( FILE* fp )
+  {
+    // read into the static members
+    LSEHeaderMeta meta;
+    read( fp, meta );
+    m_moot_key = meta.m_moot_key;
+    memcpy( m_moot_alias, meta.m_moot_alias, LSEHEADER_ALIAS_LEN );
+    s_written = true;
+  }
+
+  void LSEHeader::publishOnce( const LSEHeaderMeta& meta )
+  {
+    // only the first file fills the statics, under the lock so that readers
+    // opened on several threads at once do not race on them
+#ifndef WIN32
+    pthread_mutex_lock( &s_mutex );
+#endif
+    if ( !s_written ) {
+      m_moot_key = meta.m_moot_key;
+      memcpy( m_moot_alias, meta.m_moot_alias, LSEHEADER_ALIAS_LEN );
+      s_written = true;
+    }
+#ifndef WIN32
+    pthread_mutex_unlock( &s_mutex );
+#endif
+  }
+
+  void LSEHeader::write( FILE* fp )
+  {
+    LSEHeaderMeta meta;
+    meta.m_moot_key = m_moot_key;
+    memcpy( meta.m_moot_alias, m_moot_alias, LSEHEADER_ALIAS_LEN );
+    write( fp, meta );
   }
 
   // define the mutable static members
@@ -95,11 +160,13 @@ namespace eventFile {
   void LSEHeader::set_moot_key( unsigned k )
   {
     m_moot_key = k;
+    s_written = true;
   }
 
   void LSEHeader::set_moot_alias( const char* a )
   {
     strncpy( m_moot_alias, a, LSEHEADER_ALIAS_LEN-1 );
+    s_written = true;
   }
     
 }
@@ -4,6 +4,13 @@
 #include <errno.h>
 #include <cstring>
 
+#ifndef WIN32
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+#include <algorithm>
+
 #include <sstream>
 #include <stdexcept>
 
@@ -16,11 +23,29 @@
 #include "eventFile/LSE_Info.h"
 #include "eventFile/LPA_Handler.h"
 #include "eventFile/EBF_Data.h"
+#include "eventFile/LSE_EventView.h"
+#include "eventFile/LSE_EventBatch.h"
+#include "eventFile/LSE_Index.h"
+#include "eventFile/LSE_EventFilter.h"
+
+#ifndef WIN32
+#include "LSE_Prefetcher.h"
+#endif
+#include "LSE_Inflater.h"
+#include "LSE_ContextCodec.h"
+#include "LSE_HandlerTable.h"
+#include "LSE_Uring.h"
 
 namespace eventFile {
 
-  LSEReader::LSEReader( const std::string& filename )
-    : m_name( filename ), m_hdr()
+  LSEReader::LSEReader( const std::string& filename, IOMode mode, unsigned depth, size_t chunksize )
+    : m_name( filename ), m_hdr(), m_meta(), m_mode( mode ), m_map( NULL ), m_maplen( 0 ), m_mappos( 0 ),
+      m_source( NULL ), m_depth( depth ), m_chunksize( chunksize ),
+      m_chunk( NULL ), m_chunklen( 0 ), m_chunkpos( 0 ), m_srcpos( 0 ),
+      m_start( 0 ), m_end( ~0ULL ), m_footer(), m_index( NULL ), m_indexTried( false ),
+      m_stamp(),
+      m_codec( NULL ), m_htable( NULL ), m_decoded(), m_stored( 0 ), m_decodedAt( ~0ULL ),
+      m_filter( NULL ), m_filterStats()
   {
 #ifdef HAVE_FACILITIES
     // expand any environment variables in the filename
@@ -49,17 +74,89 @@ namespace eventFile {
       throw std::runtime_error( ess.str() );
     }
 
-    // read in the file header
+    // read in the file header, noting what it was read from
     readHeader();
+    m_stamp.take( fileno( m_FILE ) );
+
+    start();
+  }
+
+  void LSEReader::start()
+  {
+    // map the file or start reading ahead if requested; the blocks of a
+    // compressed file are always inflated ahead
+    if ( m_footer.flags & LSE_Footer::COMPRESSED ) {
+      inflate();
+    } else if ( m_mode == MMAP ) {
+      map();
+    } else if ( m_mode == PREFETCH || m_mode == URING ) {
+      prefetch();
+    }
+    m_decodedAt = m_start;
+  }
+
+  void LSEReader::reopen()
+  {
+    if ( m_FILE ) return;
+    if ( ( m_FILE = fopen( m_name.c_str(), "rb" ) ) == NULL ) {
+      std::ostringstream ess;
+      ess << "LSEReader::reopen: error opening " << m_name;
+      ess << " (" << errno << "=" << strerror( errno ) << ")";
+      throw std::runtime_error( ess.str() );
+    }
+
+    try {
+      // the header, footer and index still hold if the file is unchanged
+      if ( m_stamp.take( fileno( m_FILE ) ) ) {
+#ifdef _FILE_OFFSET_BITS
+	fseeko( m_FILE, static_cast< off_t >( m_start ), SEEK_SET );
+#else
+	fseek( m_FILE, static_cast< long >( m_start ), SEEK_SET );
+#endif
+	if ( m_codec ) m_codec->reset();
+      } else {
+	delete m_index;
+	m_index = NULL;
+	m_indexTried = false;
+	delete m_codec;
+	m_codec = NULL;
+	delete m_htable;
+	m_htable = NULL;
+	m_footer = LSE_Footer();
+	m_end = ~0ULL;
+	readHeader();
+      }
+      start();
+    } catch ( std::runtime_error& ) {
+      m_stamp.clear();
+      close();
+      throw;
+    }
   }
 
   LSEReader::~LSEReader()
   {
     close();
+    delete m_index;
+    delete m_codec;
+    delete m_htable;
   }
 
   void LSEReader::close()
   {
+#ifndef WIN32
+    if ( m_source ) {
+      delete m_source;
+      m_source = NULL;
+      m_chunk = NULL;
+      m_chunklen = m_chunkpos = 0;
+    }
+    if ( m_map ) {
+      munmap( m_map, m_maplen );
+      m_map = NULL;
+      m_maplen = m_mappos = 0;
+    }
+#endif
     if ( m_FILE ) {
       fclose( m_FILE );
       m_FILE = NULL;
@@ -74,11 +171,49 @@ namespace eventFile {
     fseeko( m_FILE, ofst, SEEK_SET ); 
 
     // read in the header data
-    m_hdr.read( m_FILE );
+    m_hdr.read( m_FILE, m_meta );
+    LSEHeader::publishOnce( m_meta );
+    m_start = ftello( m_FILE );
+
+    // the events of a blocked file stop where its footer begins
+    if ( m_hdr.blocked() ) {
+      m_footer.read( m_FILE, m_name );
+      m_end = m_footer.offset;
+      if ( m_footer.flags & LSE_Footer::COMPRESSED ) {
+	m_end = m_footer.blocks.empty() ? m_start :
+	  m_footer.blocks.back().offset + m_footer.blocks.back().length;
+      }
+      if ( ( m_footer.flags & LSE_Footer::CONTEXT_DELTA ) && m_codec == NULL ) {
+	m_codec = new LSE_ContextCodec();
+      }
+      if ( ( m_footer.flags & LSE_Footer::HANDLER_TABLE ) && m_htable == NULL ) {
+	m_htable = new LSE_HandlerTable( m_footer.handlers );
+      }
+      fseeko( m_FILE, static_cast< off_t >( m_start ), SEEK_SET );
+    }
   }
 
   int LSEReader::seek( off_t ofst )
   {
+    if ( ofst < 0 ) return -1;
+    if ( m_codec ) return seekDecoded( ofst );
+    return reposition( ofst );
+  }
+
+  int LSEReader::reposition( unsigned long long ofst )
+  {
+    if ( m_mode == MMAP ) {
+      if ( ofst > m_maplen ) return -1;
+      m_mappos = ofst;
+      return 0;
+    }
+    if ( m_source ) {
+      m_source->restart( ofst );
+      m_srcpos = ofst;
+      m_chunk = NULL;
+      m_chunklen = m_chunkpos = 0;
+      return 0;
+    }
     return fseeko( m_FILE, ofst, SEEK_SET );
   }
 #else
@@ -89,25 +224,622 @@ namespace eventFile {
     fseek( m_FILE, ofst, SEEK_SET ); 
 
     // read in the header data
-    m_hdr.read( m_FILE );
+    m_hdr.read( m_FILE, m_meta );
+    LSEHeader::publishOnce( m_meta );
+    m_start = ftell( m_FILE );
+
+    // the events of a blocked file stop where its footer begins
+    if ( m_hdr.blocked() ) {
+      m_footer.read( m_FILE, m_name );
+      m_end = m_footer.offset;
+      if ( m_footer.flags & LSE_Footer::COMPRESSED ) {
+	m_end = m_footer.blocks.empty() ? m_start :
+	  m_footer.blocks.back().offset + m_footer.blocks.back().length;
+      }
+      if ( ( m_footer.flags & LSE_Footer::CONTEXT_DELTA ) && m_codec == NULL ) {
+	m_codec = new LSE_ContextCodec();
+      }
+      if ( ( m_footer.flags & LSE_Footer::HANDLER_TABLE ) && m_htable == NULL ) {
+	m_htable = new LSE_HandlerTable( m_footer.handlers );
+      }
+      fseek( m_FILE, static_cast< long >( m_start ), SEEK_SET );
+    }
   }
 
   int LSEReader::seek( int ofst )
   {
-    return fseek( m_FILE, ofst, SEEK_SET );
+    if ( ofst < 0 ) return -1;
+    if ( m_codec ) return seekDecoded( ofst );
+    return reposition( ofst );
+  }
+
+  int LSEReader::reposition( unsigned long long ofst )
+  {
+    return fseek( m_FILE, static_cast< long >( ofst ), SEEK_SET );
   }
 #endif
 
+  int LSEReader::seekDecoded( unsigned long long ofst )
+  {
+    // a context is stored against the one before it, so decoding must
+    // start from the full context at the front of the offset's block, or
+    // carry on from the last record decoded when that is ahead of it
+    size_t b = m_footer.find( ofst );
+    if ( b == m_footer.blocks.size() || m_footer.blocks[b].offset == ofst ) {
+      m_codec->reset();
+      m_decodedAt = ( b == m_footer.blocks.size() ) ? ~0ULL : ofst;
+      if ( reposition( ofst ) == 0 ) return 0;
+      m_decodedAt = ~0ULL;
+      return -1;
+    }
+    unsigned long long pos = m_decodedAt;
+    if ( pos == ~0ULL || pos < m_footer.blocks[b].offset || pos > ofst ) {
+      m_codec->reset();
+      m_decodedAt = ~0ULL;
+      pos = m_footer.blocks[b].offset;
+      if ( reposition( pos ) != 0 ) return -1;
+      m_decodedAt = pos;
+    }
+    const unsigned char* rec(NULL);
+    size_t len(0);
+    while ( pos < ofst ) {
+      if ( !fetchRecord( rec, len ) ) return -1;
+      pos += m_stored;
+    }
+    return ( pos == ofst ) ? 0 : -1;
+  }
+
+  bool LSEReader::loadIndex( const std::string& idxname )
+  {
+    m_indexTried = true;
+    delete m_index;
+    m_index = NULL;
+
+    // a missing index is not an error
+    std::string name = idxname.empty() ? LSE_Index::name( m_name ) : idxname;
+    FILE* fp = fopen( name.c_str(), "rb" );
+    if ( fp == NULL ) {
+      return false;
+    }
+    fclose( fp );
+
+    // but an unreadable one is
+    m_index = new LSE_Index( name );
+
+    // ignore an index left over from a different version of the file
+    if ( m_index->size() != m_hdr.m_evtcnt || m_index->runid() != m_hdr.m_runid ) {
+      delete m_index;
+      m_index = NULL;
+      return false;
+    }
+    return true;
+  }
+
+  bool LSEReader::seekSequence( unsigned long long seq )
+  {
+    if ( !m_indexTried ) loadIndex();
+    if ( m_index ) {
+      return seekEntry( m_index->lowerSequence( seq ) );
+    }
+    if ( m_hdr.blocked() ) {
+      // only the first block that reaches the target needs scanning
+      size_t b = m_footer.lowerSequence( seq );
+      if ( b == m_footer.blocks.size() ) {
+	seek( m_end );
+	return false;
+      }
+      return scanTo( false, seq, m_footer.blocks[b].offset );
+    }
+    return scanTo( false, seq, m_start );
+  }
+
+  bool LSEReader::seekTime( unsigned secs )
+  {
+    if ( !m_indexTried ) loadIndex();
+    if ( m_index ) {
+      return seekEntry( m_index->lowerTime( secs ) );
+    }
+    if ( m_hdr.blocked() ) {
+      size_t b = m_footer.lowerTime( secs );
+      if ( b == m_footer.blocks.size() ) {
+	seek( m_end );
+	return false;
+      }
+      return scanTo( true, secs, m_footer.blocks[b].offset );
+    }
+    return scanTo( true, secs, m_start );
+  }
+
+  bool LSEReader::seekLast()
+  {
+    if ( m_hdr.blocked() ) {
+      if ( m_footer.blocks.empty() ) return false;
+      seek( m_footer.lastEvent );
+      return true;
+    }
+    if ( !m_indexTried ) loadIndex();
+    if ( m_index ) {
+      if ( m_index->empty() ) return false;
+      seek( ( *m_index )[m_index->size()-1].offset );
+      return true;
+    }
+
+    // otherwise walk the record lengths
+    seek( m_start );
+    unsigned long long ofst = m_start;
+    unsigned long long last = ofst;
+    bool found = false;
+    const unsigned char* rec(NULL);
+    size_t len(0);
+    while ( fetchRecord( rec, len ) ) {
+      last = ofst;
+      ofst += m_stored;
+      found = true;
+    }
+    seek( found ? last : m_start );
+    return found;
+  }
+
+  bool LSEReader::seekEntry( size_t i )
+  {
+    // past the last entry leaves the reader at end of file
+    if ( i >= m_index->size() ) {
+      if ( i == 0 ) {
+	seek( m_start );
+      } else {
+	seek( ( *m_index )[i-1].offset + ( *m_index )[i-1].length );
+      }
+      return false;
+    }
+    seek( ( *m_index )[i].offset );
+    return true;
+  }
+
+  bool LSEReader::scanTo( bool bytime, unsigned long long target, unsigned long long from )
+  {
+    // walk the events, remembering where each one starts
+    seek( from );
+    unsigned long long ofst = from;
+    const unsigned char* rec(NULL);
+    size_t len(0);
+    LSE_EventView view;
+    while ( fetchRecord( rec, len ) ) {
+      view.parse( rec, len );
+      unsigned long long key = bytime ? view.ctx().current.timeSecs : view.ctx().scalers.sequence;
+      if ( key >= target ) {
+	seek( ofst );
+	return true;
+      }
+      ofst += m_stored;
+    }
+    return false;
+  }
+
+  void LSEReader::map()
+  {
+#ifndef WIN32
+    // map the entire file read-only
+    struct stat stbuf;
+    if ( fstat( fileno( m_FILE ), &stbuf ) != 0 ) {
+      std::ostringstream ess;
+      ess << "LSEReader::map: error getting size of " << m_name;
+      ess << " (" << errno << "=" << strerror( errno ) << ")";
+      throw std::runtime_error( ess.str() );
+    }
+    m_maplen = stbuf.st_size;
+    void* p = mmap( NULL, m_maplen, PROT_READ, MAP_SHARED, fileno( m_FILE ), 0 );
+    if ( p == MAP_FAILED ) {
+      std::ostringstream ess;
+      ess << "LSEReader::map: error mapping " << m_name;
+      ess << " (" << errno << "=" << strerror( errno ) << ")";
+      throw std::runtime_error( ess.str() );
+    }
+    m_map = static_cast<unsigned char*>( p );
+
+    // we expect to walk the file front to back
+    madvise( m_map, m_maplen, MADV_SEQUENTIAL );
+
+    // the first event follows the header
+    m_mappos = ftello( m_FILE );
+#else
+    std::ostringstream ess;
+    ess << "LSEReader::map: memory-mapped access to " << m_name;
+    ess << " not supported on Windows";
+    throw std::runtime_error( ess.str() );
+#endif
+  }
+
+  void LSEReader::prefetch()
+  {
+    m_srcpos = m_start;
+#ifndef WIN32
+    if ( m_mode == PREFETCH ) {
+      m_source = new LSE_Prefetcher( fileno( m_FILE ), ftello( m_FILE ), m_chunksize, m_depth );
+      return;
+    }
+#endif
+#ifdef HAVE_IO_URING
+    if ( m_mode == URING ) {
+      m_source = new LSE_UringReader( fileno( m_FILE ), ftello( m_FILE ), m_chunksize, m_depth );
+      return;
+    }
+#endif
+    std::ostringstream ess;
+    ess << "LSEReader::prefetch: " << ( m_mode == URING ? "io_uring" : "read-ahead" );
+    ess << " access to " << m_name << " not supported in this build";
+    throw std::runtime_error( ess.str() );
+  }
+
+  void LSEReader::inflate()
+  {
+    // offsets are positions in the uncompressed event stream, which begins
+    // where the header ends
+    m_mode = PREFETCH;
+    m_srcpos = m_start;
+#if defined( HAVE_ZLIB ) && !defined( WIN32 )
+    // one worker per read-ahead block beyond the one being consumed, up to
+    // the number of CPUs
+    unsigned nworkers = m_depth > 1 ? m_depth - 1 : 1;
+    long ncpu = sysconf( _SC_NPROCESSORS_ONLN );
+    if ( ncpu > 0 && nworkers > static_cast< unsigned >( ncpu ) ) nworkers = ncpu;
+    m_source = new LSE_Inflater( fileno( m_FILE ), m_footer, m_depth, nworkers );
+#else
+    std::ostringstream ess;
+    ess << "LSEReader::inflate: compressed file " << m_name;
+    ess << " not supported in this build";
+    throw std::runtime_error( ess.str() );
+#endif
+  }
+
+  LSEReader::PrefetchStats LSEReader::prefetchStats() const
+  {
+    if ( m_source ) {
+      return m_source->stats();
+    }
+    return PrefetchStats();
+  }
+
+  bool LSEReader::readChunked( const unsigned char*& rec, size_t& len )
+  {
+    size_t have(0);
+    for (;;) {
+      // move on to the next chunk when this one is used up
+      if ( m_chunkpos == m_chunklen ) {
+	bool more = m_source->next( m_chunk, m_chunklen );
+	if ( more ) {
+	  // don't hand out anything from beyond the events
+	  unsigned long long base = m_srcpos;
+	  m_srcpos += m_chunklen;
+	  if ( base >= m_end ) {
+	    more = false;
+	  } else if ( m_srcpos > m_end ) {
+	    m_chunklen = m_end - base;
+	  }
+	}
+	if ( !more ) {
+	  m_chunk = NULL;
+	  m_chunklen = m_chunkpos = 0;
+	  if ( have == 0 ) return false;
+	  std::ostringstream ess;
+	  ess << "LSEReader::read: truncated event at end of " << m_name;
+	  throw std::runtime_error( ess.str() );
+	}
+	m_chunkpos = 0;
+      }
+      const unsigned char* p = m_chunk + m_chunkpos;
+      size_t avail = m_chunklen - m_chunkpos;
+
+      // records lying wholly inside the chunk are handed out in place
+      if ( have == 0 ) {
+	size_t need = measure( p, avail );
+	if ( need <= avail ) {
+	  rec = p;
+	  len = need;
+	  m_chunkpos += need;
+	  return true;
+	}
+      }
+
+      // otherwise, assemble the record in the staging buffer
+      size_t need = measure( have ? &m_rec[0] : NULL, have );
+      size_t n = std::min( need - have, avail );
+      if ( m_rec.size() < need ) m_rec.resize( need );
+      memcpy( &m_rec[have], p, n );
+      have += n;
+      m_chunkpos += n;
+      if ( measure( &m_rec[0], have ) <= have ) {
+	rec = &m_rec[0];
+	len = have;
+	return true;
+      }
+    }
+  }
+
+  bool LSEReader::readRecord( const unsigned char*& rec, size_t& len, bool ebf )
+  {
+    // stdio reads stage the record around its EBF so that it can be filtered
+    if ( m_filter && m_mode == STDIO && m_codec == NULL && m_htable == NULL ) {
+      return readStaged( rec, len, ebf );
+    }
+
+    while ( fetchRecord( rec, len ) ) {
+      if ( m_filter == NULL ) return true;
+      LSE_EventView view;
+      view.parse( rec, len );
+      if ( m_filter->accept( view ) ) {
+	m_filterStats.accepted++;
+	return true;
+      }
+      m_filterStats.rejected++;
+      m_filterStats.skippedBytes += len;
+    }
+    return false;
+  }
+
+  void LSEReader::stage( size_t have, size_t need )
+  {
+    if ( m_rec.size() < need ) m_rec.resize( need );
+    size_t nitems = fread( &m_rec[have], need - have, 1, m_FILE );
+    if ( nitems != 1 ) {
+      std::ostringstream ess;
+      ess << "LSEReader::read: error reading event record from " << m_name;
+      ess << " (" << errno << "=" << strerror( errno ) << ")";
+      throw std::runtime_error( ess.str() );
+    }
+  }
+
+  bool LSEReader::pastEnd()
+  {
+    // only blocked files have anything after the events
+    if ( !m_hdr.blocked() ) return false;
+#ifdef _FILE_OFFSET_BITS
+    return static_cast< unsigned long long >( ftello( m_FILE ) ) >= m_end;
+#else
+    return static_cast< unsigned long long >( ftell( m_FILE ) ) >= m_end;
+#endif
+  }
+
+  bool LSEReader::readStaged( const unsigned char*& rec, size_t& len, bool ebf )
+  {
+    const size_t head = sizeof( LSE_Context ) + sizeof( unsigned );
+    while ( true ) {
+      if ( pastEnd() ) return false;
+
+      // the context and the EBF length word
+      if ( m_rec.size() < head ) m_rec.resize( head );
+      size_t nitems = fread( &m_rec[0], head, 1, m_FILE );
+      if ( nitems != 1 ) {
+	if ( feof( m_FILE ) ) return false;
+	std::ostringstream ess;
+	ess << "LSEReader::read: error reading LSE_Context from " << m_name;
+	ess << " (" << errno << "=" << strerror( errno ) << ")";
+	throw std::runtime_error( ess.str() );
+      }
+
+      // step over the EBF and pull in the meta-info and keys behind it,
+      // staged as if the EBF were empty
+      unsigned ebflen(0);
+      memcpy( &ebflen, &m_rec[sizeof( LSE_Context )], sizeof( unsigned ) );
+#ifdef _FILE_OFFSET_BITS
+      off_t ebfpos = ftello( m_FILE );
+#else
+      long ebfpos = ftell( m_FILE );
+#endif
+      skip( ebflen );
+      memset( &m_rec[sizeof( LSE_Context )], 0, sizeof( unsigned ) );
+      size_t have( head );
+      size_t need(0);
+      while ( ( need = LSE_EventView::measure( &m_rec[0], have ) ) > have ) {
+	stage( have, need );
+	have = need;
+      }
+
+      LSE_EventView view;
+      view.parse( &m_rec[0], have );
+      if ( !m_filter->accept( view ) ) {
+	m_filterStats.rejected++;
+	m_filterStats.skippedBytes += have + ebflen;
+	continue;
+      }
+      m_filterStats.accepted++;
+
+      // go back for the EBF of an accepted event if the caller wants it
+      if ( ebf && ebflen > 0 ) {
+	size_t meta = have - head;
+	m_rec.resize( have + ebflen );
+	memmove( &m_rec[head + ebflen], &m_rec[head], meta );
+	memcpy( &m_rec[sizeof( LSE_Context )], &ebflen, sizeof( unsigned ) );
+#ifdef _FILE_OFFSET_BITS
+	fseeko( m_FILE, ebfpos, SEEK_SET );
+#else
+	fseek( m_FILE, ebfpos, SEEK_SET );
+#endif
+	stage( head, head + ebflen );
+	skip( meta );
+	have += ebflen;
+      }
+      rec = &m_rec[0];
+      len = have;
+      return true;
+    }
+  }
+
+  size_t LSEReader::measure( const unsigned char* buf, size_t avail ) const
+  {
+    size_t hsize = m_htable ? LSE_HandlerTable::COMPACT_SIZE : sizeof( LPA_Handler );
+    if ( m_codec ) {
+      return LSE_ContextCodec::measure( buf, avail, hsize );
+    }
+    return LSE_EventView::measure( buf, avail, hsize );
+  }
+
+  bool LSEReader::fetchRecord( const unsigned char*& rec, size_t& len )
+  {
+    // the decoded position is lost if the fetch or the decoding throws
+    unsigned long long at = m_decodedAt;
+    m_decodedAt = ~0ULL;
+    if ( !fetchStored( rec, len ) ) {
+      m_decodedAt = at;
+      return false;
+    }
+
+    // rebuild the canonical record from an encoded one
+    m_stored = len;
+    if ( m_codec || m_htable ) {
+      len = decode( rec, len );
+      rec = &m_decoded[0];
+    }
+    if ( at != ~0ULL ) m_decodedAt = at + m_stored;
+    return true;
+  }
+
+  size_t LSEReader::decode( const unsigned char* rec, size_t len )
+  {
+    // the context, stored raw or as changes from the previous one
+    m_decoded.resize( sizeof( LSE_Context ) );
+    LSE_Context& ctx = *reinterpret_cast< LSE_Context* >( &m_decoded[0] );
+    size_t used = sizeof( LSE_Context );
+    if ( m_codec ) {
+      used = m_codec->decode( rec, len, ctx );
+    } else {
+      memcpy( static_cast< void* >( &ctx ), rec, sizeof( LSE_Context ) );
+    }
+
+    // then the rest, with table-coded handlers expanded
+    if ( m_htable ) {
+      m_htable->expand( rec + used, len - used, m_decoded );
+    } else {
+      m_decoded.insert( m_decoded.end(), rec + used, rec + len );
+    }
+    return m_decoded.size();
+  }
+
+  bool LSEReader::fetchStored( const unsigned char*& rec, size_t& len )
+  {
+    // in the read-ahead modes the record comes out of the chunks
+    if ( m_source ) {
+      return readChunked( rec, len );
+    }
+
+    // in MMAP mode the record is already in memory
+    if ( m_mode == MMAP ) {
+      size_t end = std::min( static_cast< unsigned long long >( m_maplen ), m_end );
+      if ( m_mappos >= end ) return false;
+      rec = m_map + m_mappos;
+      len = measure( rec, end - m_mappos );
+      if ( len > end - m_mappos ) {
+	std::ostringstream ess;
+	ess << "LSEReader::read: truncated event at offset " << m_mappos;
+	ess << " of " << m_name;
+	throw std::runtime_error( ess.str() );
+      }
+      m_mappos += len;
+      return true;
+    }
+
+    // otherwise, pull in the record piecewise until it is complete
+    if ( pastEnd() ) return false;
+    size_t have(0);
+    size_t need(0);
+    while ( ( need = measure( m_rec.empty() ? NULL : &m_rec[0], have ) ) > have ) {
+      if ( m_rec.size() < need ) m_rec.resize( need );
+      size_t nitems = fread( &m_rec[have], need - have, 1, m_FILE );
+      if ( nitems != 1 ) {
+	if ( have == 0 && feof( m_FILE ) ) {
+	  return false;
+	}
+	std::ostringstream ess;
+	ess << "LSEReader::read: error reading event record from " << m_name;
+	ess << " (" << errno << "=" << strerror( errno ) << ")";
+	throw std::runtime_error( ess.str() );
+      }
+      have = need;
+    }
+    rec = &m_rec[0];
+    len = have;
+    return true;
+  }
+
+  bool LSEReader::read( LSE_EventView& view )
+  {
+    return readView( view, true );
+  }
+
+  bool LSEReader::readView( LSE_EventView& view, bool ebf )
+  {
+    const unsigned char* rec(NULL);
+    size_t len(0);
+    if ( !readRecord( rec, len, ebf ) ) {
+      return false;
+    }
+    view.parse( rec, len );
+    view.bind( &m_meta );
+    return true;
+  }
+
+  size_t LSEReader::readBatch( LSE_EventBatch& batch, size_t n )
+  {
+    batch.clear();
+    LSE_EventView view;
+    while ( batch.size() < n && read( view ) ) {
+      batch.append( view );
+    }
+    return batch.size();
+  }
+
+  void LSEReader::unpack( const LSE_EventView& view, LSE_Context& ctx, EBF_Data& ebf, LSE_Info::InfoType& infotype,
+			  LPA_Info& pinfo, LCI_ACD_Info& ainfo, LCI_CAL_Info& cinfo, LCI_TKR_Info& tinfo,
+			  LSE_Keys::KeysType& ktype, LPA_Keys& pakeys, LCI_Keys& cikeys )
+  {
+    ctx = view.ctx();
+    view.copy( ebf );
+    unpack( view, infotype, pinfo, ainfo, cinfo, tinfo, ktype, pakeys, cikeys );
+  }
+
+  void LSEReader::unpack( const LSE_EventView& view, LSE_Info::InfoType& infotype,
+			  LPA_Info& pinfo, LCI_ACD_Info& ainfo, LCI_CAL_Info& cinfo, LCI_TKR_Info& tinfo,
+			  LSE_Keys::KeysType& ktype, LPA_Keys& pakeys, LCI_Keys& cikeys )
+  {
+    infotype = view.infotype();
+    switch ( infotype ) {
+    case LSE_Info::LPA:
+      view.copy( pinfo );
+      break;
+    case LSE_Info::LCI_ACD:
+      view.copy( ainfo );
+      break;
+    case LSE_Info::LCI_CAL:
+      view.copy( cinfo );
+      break;
+    case LSE_Info::LCI_TKR:
+      view.copy( tinfo );
+      break;
+    default:
+      break;
+    }
+
+    ktype = view.keystype();
+    switch ( ktype ) {
+    case LSE_Keys::LPA:
+      view.copy( pakeys );
+      break;
+    case LSE_Keys::LCI:
+      view.copy( cikeys );
+      break;
+    default:
+      break;
+    }
+  }
+
   bool LSEReader::read( LSE_Context& ctx, EBF_Data& ebf )
   {
-    unsigned char buf[ 128 * 1024 ];
     size_t nitems(0);
 
-    // see if we're at the end of the file
-    if ( feof( m_FILE ) ) return false;
+    // see if we're at the end of the events
+    if ( feof( m_FILE ) || pastEnd() ) return false;
 
     // read the context data as a bag-o-bytes
-    nitems = fread( buf, sizeof( LSE_Context ), 1, m_FILE );
+    nitems = fread( static_cast<void*>( &ctx ), sizeof( LSE_Context ), 1, m_FILE );
     if ( nitems != 1 ) {
       if ( feof( m_FILE ) ) {
 	return false;
@@ -119,16 +851,127 @@ namespace eventFile {
       }
     }
 
-    // populate the supplied context object
-    ctx = *( reinterpret_cast< LSE_Context* >( buf ) );
-
     // read in the EBF data
     ebf.read( m_FILE );
 
     return true;
   }
 
-  void LSEReader::read( unsigned char* buf, size_t& len )
+  bool LSEReader::readSkipEBF( LSE_Context& ctx )
+  {
+    size_t nitems(0);
+
+    // see if we're at the end of the events
+    if ( feof( m_FILE ) || pastEnd() ) return false;
+
+    // read the context data as a bag-o-bytes
+    nitems = fread( static_cast<void*>( &ctx ), sizeof( LSE_Context ), 1, m_FILE );
+    if ( nitems != 1 ) {
+      if ( feof( m_FILE ) ) {
+	return false;
+      } else {
+	std::ostringstream ess;
+	ess << "LSEReader::read: error reading LSE_Context from " << m_name;
+	ess << " (" << errno << "=" << strerror( errno ) << ")";
+	throw std::runtime_error( ess.str() );
+      }
+    }
+
+    // step over the EBF data using its length word
+    unsigned len(0);
+    nitems = fread( &len, sizeof( unsigned ), 1, m_FILE );
+    if ( nitems != 1 ) {
+      std::ostringstream ess;
+      ess << "LSEReader::read: error reading EBF length from " << m_name;
+      ess << " (" << errno << "=" << strerror( errno ) << ")";
+      throw std::runtime_error( ess.str() );
+    }
+    skip( len );
+
+    return true;
+  }
+
+  void LSEReader::skip( size_t nbytes )
+  {
+    // stdio repositions within its buffer without a system call when it can
+#ifdef _FILE_OFFSET_BITS
+    int err = fseeko( m_FILE, static_cast<off_t>( nbytes ), SEEK_CUR );
+#else
+    int err = fseek( m_FILE, static_cast<long>( nbytes ), SEEK_CUR );
+#endif
+    if ( err != 0 ) {
+      std::ostringstream ess;
+      ess << "LSEReader::skip: error skipping " << nbytes << " bytes in " << m_name;
+      ess << " (" << errno << "=" << strerror( errno ) << ")";
+      throw std::runtime_error( ess.str() );
+    }
+  }
+
+  void LSEReader::skipMeta()
+  {
+    // the meta-info: a typeid followed by type-dependent content
+    int itype(0);
+    size_t nitems = fread( &itype, sizeof( int ), 1, m_FILE );
+    if ( nitems != 1 ) {
+      std::ostringstream ess;
+      ess << "LSEReader::read: error reading LSE_Info typeid from " << m_name;
+      ess << " (" << errno << "=" << strerror( errno ) << ")";
+      throw std::runtime_error( ess.str() );
+    }
+    switch ( itype ) {
+    case LSE_Info::LPA: {
+      skip( sizeof( LPA_Info ) - sizeof( std::vector< LPA_Handler > ) );
+      unsigned nhandlers(0);
+      nitems = fread( &nhandlers, sizeof( unsigned ), 1, m_FILE );
+      if ( nitems != 1 ) {
+	std::ostringstream ess;
+	ess << "LSEReader::read: error reading LPA_Handler count from " << m_name;
+	ess << " (" << errno << "=" << strerror( errno ) << ")";
+	throw std::runtime_error( ess.str() );
+      }
+      skip( nhandlers * sizeof( LPA_Handler ) );
+      break;
+    }
+    case LSE_Info::LCI_ACD:
+    case LSE_Info::LCI_CAL:
+    case LSE_Info::LCI_TKR: {
+      uint32_t flen(0);
+      nitems = fread( &flen, sizeof flen, 1, m_FILE );
+      if ( nitems != 1 ) {
+	std::ostringstream ess;
+	ess << "LSEReader::read: error reading LSE_Info size from " << m_name;
+	ess << " (" << errno << "=" << strerror( errno ) << ")";
+	throw std::runtime_error( ess.str() );
+      }
+      skip( flen );
+      break;
+    }
+    default:
+      break;
+    }
+
+    // the translated keys: a typeid and a fixed number of key words
+    int ktype(0);
+    nitems = fread( &ktype, sizeof( int ), 1, m_FILE );
+    if ( nitems != 1 ) {
+      std::ostringstream ess;
+      ess << "LSEReader::read: error reading LSE_Keys typeid from " << m_name;
+      ess << " (" << errno << "=" << strerror( errno ) << ")";
+      throw std::runtime_error( ess.str() );
+    }
+    switch ( ktype ) {
+    case LSE_Keys::LPA:
+      skip( 4 * sizeof( unsigned ) );
+      break;
+    case LSE_Keys::LCI:
+      skip( 3 * sizeof( unsigned ) );
+      break;
+    default:
+      break;
+    }
+  }
+
+  void LSEReader::read( std::vector< unsigned char >& buf, size_t& len )
   {
     // read in the LSE_Info size
     int nitems(0);
@@ -140,10 +983,17 @@ namespace eventFile {
       ess << " (" << errno << "=" << strerror( errno ) << ")";
       throw std::runtime_error( ess.str() );
     }
+    if ( flen > LSE_INFO_MAX_LCI ) {
+      std::ostringstream ess;
+      ess << "LSEReader::read: LSE_Info length " << flen << " exceeds " << LSE_INFO_MAX_LCI;
+      ess << " in " << m_name;
+      throw std::runtime_error( ess.str() );
+    }
     len = flen;
+    if ( buf.size() < len ) buf.resize( len );
 
     // read in the LSE_Info content
-    nitems = fread( buf, len, 1, m_FILE );
+    nitems = fread( &buf[0], len, 1, m_FILE );
     if ( nitems != 1 ) {
       std::ostringstream ess;
       ess << "LSEReader::read: error reading LSE_Info content from " << m_name;
@@ -256,9 +1106,12 @@ namespace eventFile {
     }
     infotype = static_cast<LSE_Info::InfoType>( itype );
 
-    // read the LSE_Info object type id
-    unsigned char buf[ 128 * 1024 ];
+    // LCI_Info content is staged in the record buffer, which is kept at
+    // least as large as a context (and so any of the LCI_Info structs); a
+    // block shorter than its struct leaves the rest zero
     size_t len(0);
+    if ( m_rec.size() < sizeof( LSE_Context ) ) m_rec.resize( sizeof( LSE_Context ) );
+    memset( &m_rec[0], 0, sizeof( LSE_Context ) );
 
     // assign to the proper type of object
     switch ( infotype ) {
@@ -266,16 +1119,16 @@ namespace eventFile {
       pinfo.read( m_FILE );
       break;
     case LSE_Info::LCI_ACD:
-      read( &buf[0], len );
-      ainfo = *reinterpret_cast<LCI_ACD_Info*>( buf );
+      read( m_rec, len );
+      ainfo = *reinterpret_cast<LCI_ACD_Info*>( &m_rec[0] );
       break;
     case LSE_Info::LCI_CAL:
-      read( &buf[0], len );
-      cinfo = *reinterpret_cast<LCI_CAL_Info*>( buf );
+      read( m_rec, len );
+      cinfo = *reinterpret_cast<LCI_CAL_Info*>( &m_rec[0] );
       break;
     case LSE_Info::LCI_TKR:
-      read( &buf[0], len );
-      tinfo = *reinterpret_cast<LCI_TKR_Info*>( buf );
+      read( m_rec, len );
+      tinfo = *reinterpret_cast<LCI_TKR_Info*>( &m_rec[0] );
       break;
     default:
       break;
@@ -286,6 +1139,16 @@ namespace eventFile {
 			LPA_Info& pinfo, LCI_ACD_Info& ainfo, LCI_CAL_Info& cinfo, LCI_TKR_Info& tinfo,
 			LSE_Keys::KeysType& ktype, LPA_Keys& pakeys, LCI_Keys& cikeys )
   {
+    // mapped, filtered and encoded files are parsed in place and copied out once
+    if ( m_mode != STDIO || m_filter || m_codec || m_htable ) {
+      LSE_EventView view;
+      if ( !read( view ) ) {
+	return false;
+      }
+      unpack( view, ctx, ebf, infotype, pinfo, ainfo, cinfo, tinfo, ktype, pakeys, cikeys );
+      return true;
+    }
+
     // read the context and EBF 
     if ( !read( ctx, ebf ) ) {
       return false;
@@ -300,4 +1163,45 @@ namespace eventFile {
     return true;
   }
 
+  bool LSEReader::read( LSE_Context& ctx, LSE_Info::InfoType& infotype,
+			LPA_Info& pinfo, LCI_ACD_Info& ainfo, LCI_CAL_Info& cinfo, LCI_TKR_Info& tinfo,
+			LSE_Keys::KeysType& ktype, LPA_Keys& pakeys, LCI_Keys& cikeys )
+  {
+    // other modes already have the record in memory; just don't copy the EBF
+    if ( m_mode != STDIO || m_filter || m_codec || m_htable ) {
+      LSE_EventView view;
+      if ( !readView( view, false ) ) {
+	return false;
+      }
+      ctx = view.ctx();
+      unpack( view, infotype, pinfo, ainfo, cinfo, tinfo, ktype, pakeys, cikeys );
+      return true;
+    }
+
+    if ( !readSkipEBF( ctx ) ) {
+      return false;
+    }
+    readInfo( infotype, pinfo, ainfo, cinfo, tinfo );
+    readKeys( ktype, pakeys, cikeys );
+    return true;
+  }
+
+  bool LSEReader::readContext( LSE_Context& ctx )
+  {
+    if ( m_mode != STDIO || m_filter || m_codec || m_htable ) {
+      LSE_EventView view;
+      if ( !readView( view, false ) ) {
+	return false;
+      }
+      ctx = view.ctx();
+      return true;
+    }
+
+    if ( !readSkipEBF( ctx ) ) {
+      return false;
+    }
+    skipMeta();
+    return true;
+  }
+
 }
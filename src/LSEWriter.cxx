@@ -15,13 +15,19 @@
 #else
 
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/types.h>
 
 #endif
 
+#include <algorithm>
 #include <sstream>
 #include <stdexcept>
 
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
 #include "eventFile/LSEWriter.h"
 
 #include "eventFile/LSE_Context.h"
@@ -29,13 +35,42 @@
 #include "eventFile/LPA_Handler.h"
 #include "eventFile/EBF_Data.h"
 #include "eventFile/LSE_Keys.h"
+#include "eventFile/LSE_EventView.h"
+#include "eventFile/LSE_PositionalReader.h"
 
 #include "facilities/Util.h"
 
+#include "LSE_Uring.h"
+#include "LSE_StagedWriter.h"
+#include "LSE_WriteQueue.h"
+#include "LSE_ContextCodec.h"
+#include "LSE_HandlerTable.h"
+
 namespace eventFile {
 
-  LSEWriter::LSEWriter( const std::string& filename, unsigned runid )
-    : m_name( filename ), m_hdr()
+#ifndef WIN32
+  typedef LSE_WriteQueue::Producer ProducerLock;
+
+  // bytes LSEWriter::copy() reads at a time where the kernel cannot copy them
+  static const size_t LSEWRITER_COPY_CHUNK = 1024*1024;
+#else
+  struct ProducerLock {
+    explicit ProducerLock( LSE_WriteQueue* ) {}
+  };
+#endif
+
+  // note the first of the errors met by close()
+  static void keepFirst( std::string& error, const std::string& what )
+  {
+    if ( error.empty() ) error = what;
+  }
+
+  LSEWriter::LSEWriter( const std::string& filename, unsigned runid, IOMode mode,
+			unsigned depth, size_t bufsize )
+    : m_name( filename ), m_hdr(), m_meta(), m_mode( mode ), m_uring( NULL ), m_staged( NULL ), m_prealloc( false ),
+      m_idxFILE( NULL ),
+      m_colFILE( NULL ), m_blockEvents( 0 ), m_footer(), m_zlevel( -1 ), m_logical( 0 ),
+      m_ctxcodec( NULL ), m_htable( NULL ), m_queue( NULL ), m_astats()
   {
     // stash the runid in the header
     m_hdr.m_runid = runid;
@@ -52,8 +87,8 @@ namespace eventFile {
     }
 
     // set the MOOT key/alias values
-    m_hdr.set_moot_key( mootKey );
-    m_hdr.set_moot_alias( mootAlias );
+    m_meta.set_moot_key( mootKey );
+    m_meta.set_moot_alias( mootAlias );
 
     // expand any environment variables in the filename
     facilities::Util::expandEnvVar( &m_name );
@@ -68,30 +103,417 @@ namespace eventFile {
 
     // write the file header
     writeHeader();
+
+    // events follow the header through the io_uring if requested
+    if ( m_mode == URING ) {
+#ifdef HAVE_IO_URING
+      fflush( m_FILE );
+      try {
+	m_uring = new LSE_UringWriter( fileno( m_FILE ), ftello( m_FILE ), bufsize, depth );
+      } catch ( std::runtime_error& ) {
+	fclose( m_FILE );
+	m_FILE = NULL;
+	throw;
+      }
+#else
+      (void) depth;
+      fclose( m_FILE );
+      m_FILE = NULL;
+      std::ostringstream ess;
+      ess << "LSEWriter::LSEWriter: io_uring output to " << m_name;
+      ess << " not supported in this build";
+      throw std::runtime_error( ess.str() );
+#endif
+    }
+
+    // or through the staging buffer
+    if ( m_mode == STAGED ) {
+#ifndef WIN32
+      fflush( m_FILE );
+      m_staged = new LSE_StagedWriter( fileno( m_FILE ), ftello( m_FILE ), bufsize );
+#else
+      fclose( m_FILE );
+      m_FILE = NULL;
+      std::ostringstream ess;
+      ess << "LSEWriter::LSEWriter: staged output to " << m_name;
+      ess << " not supported in this build";
+      throw std::runtime_error( ess.str() );
+#endif
+    }
+
+    // write the sidecars too if the environment asks for them
+    try {
+      if ( getenv( "LSEWRITER_INDEX" ) ) enableIndex();
+      if ( getenv( "LSEWRITER_COLUMNS" ) ) enableColumns();
+      const char* blockbuf = getenv( "LSEWRITER_BLOCK" );
+      if ( blockbuf ) enableBlocks( strtoul( blockbuf, NULL, 0 ) );
+      const char* zbuf = getenv( "LSEWRITER_COMPRESS" );
+      if ( zbuf ) enableCompression( strtol( zbuf, NULL, 0 ) );
+      if ( getenv( "LSEWRITER_CTXDELTA" ) ) enableContextDelta();
+      if ( getenv( "LSEWRITER_HANDLERS" ) ) enableHandlerTable();
+      const char* pbuf = getenv( "LSEWRITER_PREALLOC" );
+      if ( pbuf ) preallocate( strtoull( pbuf, NULL, 0 ) );
+      const char* qbuf = getenv( "LSEWRITER_ASYNC" );
+      if ( qbuf ) enableAsync( strtoul( qbuf, NULL, 0 ) );
+    } catch ( std::runtime_error& ) {
+      // no destructor runs for a throwing constructor, so free what it would;
+      // close() takes the queue, and its own errors would hide this one
+      try {
+	close();
+      } catch ( std::exception& ) {
+      }
+      delete m_ctxcodec;
+      delete m_htable;
+      throw;
+    }
+  }
+
+  void LSEWriter::enableIndex( const std::string& idxname )
+  {
+    if ( m_idxFILE ) return;
+    flush();
+    if ( m_hdr.m_evtcnt != 0ULL ) {
+      std::ostringstream ess;
+      ess << "LSEWriter::enableIndex: " << m_name << " already has events";
+      throw std::runtime_error( ess.str() );
+    }
+
+    m_idxname = idxname.empty() ? LSE_Index::name( m_name ) : idxname;
+    facilities::Util::expandEnvVar( &m_idxname );
+    if ( ( m_idxFILE = fopen( m_idxname.c_str(), "wb" ) ) == NULL ) {
+      std::ostringstream ess;
+      ess << "LSEWriter::enableIndex: error opening " << m_idxname;
+      ess << " (" << errno << "=" << strerror( errno ) << ")";
+      throw std::runtime_error( ess.str() );
+    }
+
+    // the entry count is filled in on close
+    m_idxhdr = LSE_IndexHeader();
+    m_idxhdr.runid = m_hdr.m_runid;
+    m_idxhdr.write( m_idxFILE, m_idxname );
   }
 
   LSEWriter::~LSEWriter()
   {
-    close();
+    // call close() first to see its errors
+    try {
+      close();
+    } catch ( std::exception& ) {
+    }
+    delete m_ctxcodec;
+    delete m_htable;
+  }
+
+  void LSEWriter::enableColumns( const std::string& colname )
+  {
+    if ( m_colFILE ) return;
+    flush();
+    if ( m_hdr.m_evtcnt != 0ULL ) {
+      std::ostringstream ess;
+      ess << "LSEWriter::enableColumns: " << m_name << " already has events";
+      throw std::runtime_error( ess.str() );
+    }
+
+    m_colname = colname.empty() ? LSE_ContextColumns::name( m_name ) : colname;
+    facilities::Util::expandEnvVar( &m_colname );
+    if ( ( m_colFILE = fopen( m_colname.c_str(), "wb" ) ) == NULL ) {
+      std::ostringstream ess;
+      ess << "LSEWriter::enableColumns: error opening " << m_colname;
+      ess << " (" << errno << "=" << strerror( errno ) << ")";
+      throw std::runtime_error( ess.str() );
+    }
+
+    // the event count is filled in on close
+    m_colhdr = LSE_ColumnsHeader();
+    m_colhdr.runid = m_hdr.m_runid;
+    m_colhdr.write( m_colFILE, m_colname );
+    m_cols.clear();
+    m_cols.reserve( LSE_COLUMNS_BLOCK );
+  }
+
+  void LSEWriter::enableBlocks( unsigned nevents )
+  {
+    flush();
+    if ( m_hdr.m_evtcnt != 0ULL ) {
+      std::ostringstream ess;
+      ess << "LSEWriter::enableBlocks: " << m_name << " already has events";
+      throw std::runtime_error( ess.str() );
+    }
+    m_blockEvents = nevents;
+    m_block.nevents = 0;
+
+    // mark the file v10 now, so that one left unfinished is refused rather
+    // than read as v9 events
+    if ( m_blockEvents ) {
+      m_hdr.set_blocked();
+      writeHeader();
+      fflush( m_FILE );
+    }
+    m_footer = LSE_Footer();
+    if ( m_zlevel >= 0 ) m_footer.flags |= LSE_Footer::COMPRESSED;
+    if ( m_ctxcodec ) m_footer.flags |= LSE_Footer::CONTEXT_DELTA;
+    if ( m_htable ) m_footer.flags |= LSE_Footer::HANDLER_TABLE;
+  }
+
+  void LSEWriter::enableHandlerTable()
+  {
+    if ( m_htable ) return;
+    flush();
+    if ( m_hdr.m_evtcnt != 0ULL ) {
+      std::ostringstream ess;
+      ess << "LSEWriter::enableHandlerTable: " << m_name << " already has events";
+      throw std::runtime_error( ess.str() );
+    }
+    if ( m_blockEvents == 0 ) enableBlocks( LSEWRITER_DEFAULT_BLOCK );
+    m_htable = new LSE_HandlerTable();
+    m_footer.flags |= LSE_Footer::HANDLER_TABLE;
+  }
+
+  void LSEWriter::enableContextDelta()
+  {
+    if ( m_ctxcodec ) return;
+    flush();
+    if ( m_hdr.m_evtcnt != 0ULL ) {
+      std::ostringstream ess;
+      ess << "LSEWriter::enableContextDelta: " << m_name << " already has events";
+      throw std::runtime_error( ess.str() );
+    }
+    if ( m_blockEvents == 0 ) enableBlocks( LSEWRITER_DEFAULT_BLOCK );
+    m_ctxcodec = new LSE_ContextCodec();
+    m_footer.flags |= LSE_Footer::CONTEXT_DELTA;
+  }
+
+  void LSEWriter::enableCompression( int level )
+  {
+    flush();
+    if ( m_hdr.m_evtcnt != 0ULL ) {
+      std::ostringstream ess;
+      ess << "LSEWriter::enableCompression: " << m_name << " already has events";
+      throw std::runtime_error( ess.str() );
+    }
+#ifdef HAVE_ZLIB
+    if ( level < 0 || level > 9 ) {
+      std::ostringstream ess;
+      ess << "LSEWriter::enableCompression: bad zlib level " << level << " for " << m_name;
+      throw std::runtime_error( ess.str() );
+    }
+    if ( m_blockEvents == 0 ) enableBlocks( LSEWRITER_DEFAULT_BLOCK );
+    m_zlevel = level;
+    m_footer.flags |= LSE_Footer::COMPRESSED;
+    m_frame.clear();
+
+    // offsets in the event stream carry on from the end of the header
+    m_logical = position();
+#else
+    (void) level;
+    std::ostringstream ess;
+    ess << "LSEWriter::enableCompression: compressed output to " << m_name;
+    ess << " not supported in this build";
+    throw std::runtime_error( ess.str() );
+#endif
+  }
+
+  void LSEWriter::enableAsync( unsigned depth )
+  {
+    if ( m_queue ) return;
+#ifndef WIN32
+    m_queue = new LSE_WriteQueue( *this, depth );
+#else
+    (void) depth;
+    std::ostringstream ess;
+    ess << "LSEWriter::enableAsync: asynchronous output to " << m_name;
+    ess << " not supported in this build";
+    throw std::runtime_error( ess.str() );
+#endif
+  }
+
+  void LSEWriter::flush()
+  {
+#ifndef WIN32
+    if ( m_queue ) {
+      m_queue->drain();
+    }
+#endif
+  }
+
+  bool LSEWriter::preallocate( unsigned long long nbytes )
+  {
+    flush();
+    if ( !m_FILE || nbytes == 0 ) return false;
+#ifdef FALLOC_FL_KEEP_SIZE
+    // keep the file size, so that SEEK_END still finds the end of the events
+    off_t ofst = position();
+    if ( fallocate( fileno( m_FILE ), FALLOC_FL_KEEP_SIZE, ofst, nbytes ) != 0 ) {
+      return false;
+    }
+    m_prealloc = true;
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  LSEWriter::AsyncStats LSEWriter::asyncStats() const
+  {
+#ifndef WIN32
+    if ( m_queue ) {
+      return m_queue->stats();
+    }
+#endif
+    return m_astats;
   }
 
   void LSEWriter::close()
   {
+    // every step is taken even after one fails, so that the file is
+    // finished and nothing is left open; the first error is thrown last
+    std::string error;
+#ifndef WIN32
+    if ( m_queue ) {
+      // let the writer thread finish the queued events first
+      LSE_WriteQueue* queue = m_queue;
+      m_queue = NULL;
+      try {
+	queue->stop();
+      } catch ( std::runtime_error& e ) {
+	keepFirst( error, e.what() );
+      }
+      m_astats = queue->stats();
+      delete queue;
+    }
+#endif
+    if ( m_zlevel >= 0 && m_block.nevents ) {
+      // deflate the last partial block while the output is still open
+      m_footer.blocks.push_back( m_block );
+      m_block.nevents = 0;
+      try {
+	writeFrame();
+      } catch ( std::runtime_error& e ) {
+	keepFirst( error, e.what() );
+      }
+    }
+#ifdef HAVE_IO_URING
+    if ( m_uring ) {
+      LSE_UringWriter* uring = m_uring;
+      m_uring = NULL;
+      try {
+	uring->flush();
+      } catch ( std::runtime_error& e ) {
+	keepFirst( error, e.what() );
+      }
+      delete uring;
+    }
+#endif
+#ifndef WIN32
+    if ( m_staged ) {
+      LSE_StagedWriter* staged = m_staged;
+      m_staged = NULL;
+      try {
+	staged->flush();
+      } catch ( std::runtime_error& e ) {
+	keepFirst( error, e.what() );
+      }
+      delete staged;
+    }
+#endif
+    if ( m_idxFILE ) {
+      // rewrite the index header with the final count
+      FILE* fp = m_idxFILE;
+      m_idxFILE = NULL;
+      int err = fflush( fp );
+      if ( err == 0 ) {
+	rewind( fp );
+	m_idxhdr.write( fp, m_idxname );
+      }
+      if ( fclose( fp ) != 0 || err != 0 ) {
+	std::ostringstream ess;
+	ess << "LSEWriter::close: error writing index " << m_idxname;
+	ess << " (" << errno << "=" << strerror( errno ) << ")";
+	keepFirst( error, ess.str() );
+      }
+    }
+    if ( m_colFILE ) {
+      // write out the last partial block and the final count
+      FILE* fp = m_colFILE;
+      m_colFILE = NULL;
+      try {
+	if ( !m_cols.empty() ) m_cols.writeBlock( fp, m_colname );
+	m_cols.clear();
+	if ( fflush( fp ) != 0 ) {
+	  std::ostringstream ess;
+	  ess << "LSEWriter::close: error writing columns " << m_colname;
+	  ess << " (" << errno << "=" << strerror( errno ) << ")";
+	  throw std::runtime_error( ess.str() );
+	}
+	rewind( fp );
+	m_colhdr.write( fp, m_colname );
+      } catch ( std::runtime_error& e ) {
+	keepFirst( error, e.what() );
+      }
+      if ( fclose( fp ) != 0 ) {
+	std::ostringstream ess;
+	ess << "LSEWriter::close: error writing columns " << m_colname;
+	ess << " (" << errno << "=" << strerror( errno ) << ")";
+	keepFirst( error, ess.str() );
+      }
+    }
+    if ( m_FILE && m_blockEvents && m_hdr.m_evtcnt != 0ULL ) {
+      // finish the last block and append the footer behind the events,
+      // wherever the io_uring or staged writer left the stdio position
+      if ( m_block.nevents ) {
+	m_footer.blocks.push_back( m_block );
+	m_block.nevents = 0;
+      }
+      m_footer.blockEvents = m_blockEvents;
+      if ( m_htable ) m_footer.handlers = m_htable->configs();
+#ifdef _FILE_OFFSET_BITS
+      fseeko( m_FILE, 0, SEEK_END );
+#else
+      fseek( m_FILE, 0, SEEK_END );
+#endif
+      try {
+	m_footer.write( m_FILE, m_name );
+      } catch ( std::runtime_error& e ) {
+	keepFirst( error, e.what() );
+      }
+    }
     if ( m_FILE ) {
       writeHeader();
       if ( m_hdr.m_evtcnt == 0ULL ) {
 	off_t zero(0);
 	ftruncate( fileno( m_FILE ), zero );
+      } else if ( m_prealloc ) {
+	// give back the reserved space past the end of the file; truncating to
+	// the size the file already has may leave it allocated, so step past
+	// the end and back
+	off_t end = position();
+	if ( ftruncate( fileno( m_FILE ), end + 1 ) == 0 ) {
+	  ftruncate( fileno( m_FILE ), end );
+	}
+      }
+      int err = ferror( m_FILE );
+      if ( fclose( m_FILE ) != 0 || err != 0 ) {
+	std::ostringstream ess;
+	ess << "LSEWriter::close: error writing " << m_name;
+	ess << " (" << errno << "=" << strerror( errno ) << ")";
+	keepFirst( error, ess.str() );
       }
-      fclose( m_FILE );
       m_FILE = NULL;
     }
+
+    if ( !error.empty() ) {
+      throw std::runtime_error( error );
+    }
   }
 
 #ifdef _FILE_OFFSET_BITS
   off_t LSEWriter::tell()
   {
-    return ftello( m_FILE );
+    flush();
+    if ( m_zlevel >= 0 ) {
+      return m_logical;
+    }
+    return position();
   }
 
   void LSEWriter::writeHeader()
@@ -101,7 +523,7 @@ namespace eventFile {
     fseeko( m_FILE, ofst, SEEK_SET );
 
     // write out the header data
-    m_hdr.write( m_FILE );
+    m_hdr.write( m_FILE, m_meta );
 
     // return the location to the end of the file
     fseeko( m_FILE, ofst, SEEK_END );
@@ -109,7 +531,11 @@ namespace eventFile {
 #else
   long LSEWriter::tell()
   {
-    return ftell( m_FILE );
+    flush();
+    if ( m_zlevel >= 0 ) {
+      return m_logical;
+    }
+    return position();
   }
 
   void LSEWriter::writeHeader()
@@ -119,154 +545,412 @@ namespace eventFile {
     fseek( m_FILE, ofst, SEEK_SET );
 
     // write out the header data
-    m_hdr.write( m_FILE );
+    m_hdr.write( m_FILE, m_meta );
 
     // return the location to the end of the file
     fseek( m_FILE, ofst, SEEK_END );
   }
 #endif
 
-  void LSEWriter::write( const LSE_Context& ctx, const EBF_Data& ebf )
+  unsigned long long LSEWriter::position()
   {
-    size_t nitems(0);
-    nitems = fwrite( reinterpret_cast<const void*>( &ctx ), sizeof( LSE_Context ), 1, m_FILE );
-    if ( nitems != 1 ) {
-      std::ostringstream ess;
-      ess << "LPA_File::write: error writing LSE_Context to " << m_name;
-      ess << " (" << errno << "=" << strerror( errno ) << ")";
-      throw std::runtime_error( ess.str() );
+#ifdef HAVE_IO_URING
+    if ( m_uring ) {
+      return m_uring->tell();
     }
-    ebf.write( m_FILE );
-
-    // capture header information
-    if ( m_hdr.m_evtcnt == 0ULL ) {
-      m_hdr.m_secs_beg = ctx.current.timeSecs;
-      m_hdr.m_GEMseq_beg = ctx.scalers.sequence;
+#endif
+#ifndef WIN32
+    if ( m_staged ) {
+      return m_staged->tell();
     }
-    m_hdr.m_evtcnt++;
-    m_hdr.m_secs_end = ctx.current.timeSecs;
-    m_hdr.m_GEMseq_end = ctx.scalers.sequence;
+#endif
+#ifdef _FILE_OFFSET_BITS
+    return ftello( m_FILE );
+#else
+    return ftell( m_FILE );
+#endif
   }
-  
-  void LSEWriter::write( int itype, const void* buf, size_t len )
+
+  void LSEWriter::output( const unsigned char* buf, size_t len )
   {
-    // write the object type id to the file
-    size_t nitems(0);
-    nitems = fwrite( &itype, sizeof( int ), 1, m_FILE );
-    if ( nitems != 1 ) {
-      std::ostringstream ess;
-      ess << "LSEWriter::write: error writing LSE_Info typeid  to " << m_name;
-      ess << " for type = " << itype << " size = " << len;
-      ess << " (" << errno << "=" << strerror( errno ) << ")";
-      throw std::runtime_error( ess.str() );
+#ifdef HAVE_IO_URING
+    if ( m_uring ) {
+      m_uring->append( buf, len );
+      return;
     }
-
-    // write the object size to the file
-    uint32_t const flen(static_cast<uint32_t>(len));
-    nitems = fwrite( &flen, sizeof flen, 1, m_FILE );
-    if ( nitems != 1 ) {
-      std::ostringstream ess;
-      ess << "LSEWriter::write: error writing LSE_Info size  to " << m_name;
-      ess << " for type = " << itype << " size = " << len;
-      ess << " (" << errno << "=" << strerror( errno ) << ")";
-      throw std::runtime_error( ess.str() );
+#endif
+#ifndef WIN32
+    if ( m_staged ) {
+      m_staged->append( buf, len );
+      return;
     }
-
-    // write the object content to the file
-    nitems = fwrite( buf, len, 1, m_FILE );
+#endif
+    size_t nitems = fwrite( buf, len, 1, m_FILE );
     if ( nitems != 1 ) {
       std::ostringstream ess;
-      ess << "LSEWriter::write: error writing LSE_Info content to " << m_name;
-      ess << " for type = " << itype << " size = " << len;
+      ess << "LSEWriter::write: error writing " << len << " bytes to " << m_name;
       ess << " (" << errno << "=" << strerror( errno ) << ")";
       throw std::runtime_error( ess.str() );
     }
   }
 
-  void LSEWriter::write( const LPA_Keys& keys )
+  void LSEWriter::writeFrame()
   {
-    // write the object type id to the file
-    size_t nitems(0);
-    int itype = LSE_Keys::LPA;
-    nitems = fwrite( &itype, sizeof( int ), 1, m_FILE );
-    if ( nitems != 1 ) {
+#ifdef HAVE_ZLIB
+    // the raw and deflated lengths, then the zlib stream
+    uLongf zlen = compressBound( m_frame.size() );
+    m_zbuf.resize( 2 * sizeof( uint32_t ) + zlen );
+    int err = compress2( &m_zbuf[2*sizeof( uint32_t )], &zlen, &m_frame[0], m_frame.size(), m_zlevel );
+    if ( err != Z_OK ) {
       std::ostringstream ess;
-      ess << "LSEWriter::write: error writing LPA_Keys typeid  to " << m_name;
-      ess << " (" << errno << "=" << strerror( errno ) << ")";
+      ess << "LSEWriter::write: error compressing " << m_frame.size() << " byte block for " << m_name;
+      ess << " (zlib " << err << ")";
       throw std::runtime_error( ess.str() );
     }
+    uint32_t lens[2];
+    lens[0] = m_frame.size();
+    lens[1] = zlen;
+    memcpy( &m_zbuf[0], lens, sizeof( lens ) );
+
+    m_footer.frames.push_back( position() );
+    output( &m_zbuf[0], sizeof( lens ) + zlen );
+    m_frame.clear();
+#endif
+  }
+
+  // append raw bytes to the record being serialized
+  static inline void append( std::vector< unsigned char >& rec, const void* buf, size_t len )
+  {
+    const unsigned char* p = static_cast< const unsigned char* >( buf );
+    rec.insert( rec.end(), p, p + len );
+  }
+
+  void LSEWriter::pack( const LSE_Context& ctx, const EBF_Data& ebf )
+  {
+    // start a new record with the context and the EBF blob
+    m_rec.clear();
+    append( m_rec, &ctx, sizeof( LSE_Context ) );
+    unsigned len = ebf.size();
+    append( m_rec, &len, sizeof( len ) );
+    append( m_rec, ebf.data(), len );
+  }
+  
+  void LSEWriter::pack( int itype, const void* buf, size_t len )
+  {
+    // the object type id, size and content
+    uint32_t const flen(static_cast<uint32_t>(len));
+    append( m_rec, &itype, sizeof( int ) );
+    append( m_rec, &flen, sizeof flen );
+    append( m_rec, buf, len );
+  }
 
-    // write the two LSE keys and the LPA_db key
+  void LSEWriter::pack( const LPA_Keys& keys )
+  {
+    // the object type id, the two LSE keys, SBS and the LPA_db key
+    int itype = LSE_Keys::LPA;
     unsigned ukeys[4];
     ukeys[0] = keys.LATC_master;
     ukeys[1] = keys.LATC_ignore;
     ukeys[2] = keys.SBS;
     ukeys[3] = keys.LPA_db;
-    nitems = fwrite( ukeys, sizeof( ukeys ), 1, m_FILE );
-    if ( nitems != 1 ) {
-      std::ostringstream ess;
-      ess << "LSEWriter::write: error writing LPA_Keys content to " << m_name;
-      ess << " (" << errno << "=" << strerror( errno ) << ")";
-      throw std::runtime_error( ess.str() );
-    }
+    append( m_rec, &itype, sizeof( int ) );
+    append( m_rec, ukeys, sizeof( ukeys ) );
   }
 
-  void LSEWriter::write( const LCI_Keys& keys )
+  void LSEWriter::pack( const LCI_Keys& keys )
   {
-    // write the object type id to the file
-    size_t nitems(0);
+    // the object type id and the three unsigned keys
     int itype = LSE_Keys::LCI;
-    nitems = fwrite( &itype, sizeof( int ), 1, m_FILE );
-    if ( nitems != 1 ) {
-      std::ostringstream ess;
-      ess << "LSEWriter::write: error writing LCI_Keys typeid  to " << m_name;
-      ess << " (" << errno << "=" << strerror( errno ) << ")";
-      throw std::runtime_error( ess.str() );
-    }
-
-    // write the three unsigned keys to the file
     unsigned ukeys[3];
     ukeys[0] = keys.LATC_master;
     ukeys[1] = keys.LATC_ignore;
     ukeys[2] = keys.LCI_script;
-    nitems = fwrite( ukeys, sizeof( ukeys ), 1, m_FILE );
-    if ( nitems != 1 ) {
-      std::ostringstream ess;
-      ess << "LSEWriter::write: error writing LCI_Keys content to " << m_name;
-      ess << " (" << errno << "=" << strerror( errno ) << ")";
-      throw std::runtime_error( ess.str() );
+    append( m_rec, &itype, sizeof( int ) );
+    append( m_rec, ukeys, sizeof( ukeys ) );
+  }
+
+  void LSEWriter::encodeContext( std::vector< unsigned char >& rec, const LSE_Context& ctx )
+  {
+    // each block starts from a full context
+    if ( m_block.nevents == 0 ) m_ctxcodec->reset();
+
+    // replace the raw context at the front of the record
+    m_enc.clear();
+    m_ctxcodec->encode( ctx, m_enc );
+    m_enc.insert( m_enc.end(), rec.begin() + sizeof( LSE_Context ), rec.end() );
+    rec.swap( m_enc );
+  }
+
+  void LSEWriter::submit( const LSE_Context& ctx, int itype, int ktype )
+  {
+#ifndef WIN32
+    if ( m_queue ) {
+      m_queue->push( m_rec, ctx, itype, ktype );
+      return;
+    }
+#endif
+    commit( m_rec, ctx, itype, ktype );
+  }
+
+  void LSEWriter::commit( std::vector< unsigned char >& rec, const LSE_Context& ctx, int itype, int ktype )
+  {
+    if ( m_ctxcodec ) {
+      encodeContext( rec, ctx );
+    }
+
+    // note where the event starts for the index and block footer; not
+    // through tell(), which would wait for the writer thread running this
+    unsigned long long ofst(0);
+    if ( m_idxFILE || m_blockEvents ) {
+      ofst = ( m_zlevel >= 0 ) ? m_logical : position();
+    }
+    LSE_IndexEntry entry;
+    if ( m_idxFILE ) {
+      entry.offset   = ofst;
+      entry.sequence = ctx.scalers.sequence;
+      entry.length   = rec.size();
+      entry.timeSecs = ctx.current.timeSecs;
+      entry.infotype = itype;
+      entry.keystype = ktype;
+    }
+
+    // write out the serialized event, or gather it into its block's frame
+    if ( m_zlevel >= 0 ) {
+      m_frame.insert( m_frame.end(), rec.begin(), rec.end() );
+      m_logical += rec.size();
+    } else {
+      output( &rec[0], rec.size() );
+    }
+
+    // capture header information
+    if ( m_hdr.m_evtcnt == 0ULL ) {
+      m_hdr.m_secs_beg = ctx.current.timeSecs;
+      m_hdr.m_GEMseq_beg = ctx.scalers.sequence;
+    }
+    m_hdr.m_evtcnt++;
+    m_hdr.m_secs_end = ctx.current.timeSecs;
+    m_hdr.m_GEMseq_end = ctx.scalers.sequence;
+
+    // and its index entry
+    if ( m_idxFILE ) {
+      if ( fwrite( &entry, sizeof( entry ), 1, m_idxFILE ) != 1 ) {
+	std::ostringstream ess;
+	ess << "LSEWriter::write: error writing index entry to " << m_idxname;
+	ess << " (" << errno << "=" << strerror( errno ) << ")";
+	throw std::runtime_error( ess.str() );
+      }
+      m_idxhdr.count++;
+    }
+
+    // and its context fields, a block at a time
+    if ( m_colFILE ) {
+      m_cols.append( ctx );
+      m_colhdr.count++;
+      if ( m_cols.size() == LSE_COLUMNS_BLOCK ) {
+	m_cols.writeBlock( m_colFILE, m_colname );
+	m_cols.clear();
+      }
+    }
+
+    // and its block's zone map
+    if ( m_blockEvents ) {
+      addToBlock( ctx, itype, ofst, rec.size() );
+    }
+  }
+
+  void LSEWriter::addToBlock( const LSE_Context& ctx, int itype, unsigned long long ofst, size_t len )
+  {
+    LSE_BlockInfo& b = m_block;
+    unsigned long long seq = ctx.scalers.sequence;
+    unsigned secs = ctx.current.timeSecs;
+    if ( b.nevents == 0 ) {
+      b.offset = ofst;
+      b.minSequence = b.maxSequence = seq;
+      b.minSecs = b.maxSecs = secs;
+      b.infotypes = 0;
+    } else {
+      if ( seq < b.minSequence ) b.minSequence = seq;
+      if ( seq > b.maxSequence ) b.maxSequence = seq;
+      if ( secs < b.minSecs ) b.minSecs = secs;
+      if ( secs > b.maxSecs ) b.maxSecs = secs;
+    }
+    b.infotypes |= 1u << ( itype + 1 );
+    b.nevents++;
+    b.length = ofst + len - b.offset;
+    m_footer.lastEvent = ofst;
+
+    if ( b.nevents == m_blockEvents ) {
+      m_footer.blocks.push_back( b );
+      b.nevents = 0;
+      if ( m_zlevel >= 0 ) writeFrame();
     }
   }
 
   void LSEWriter::write( const LSE_Context& ctx, const EBF_Data& ebf, const LPA_Info& info, const LPA_Keys& keys )
   {
-    write( ctx, ebf );
-    info.write( m_FILE );
-    write( keys );
+    ProducerLock lock( m_queue );
+    pack( ctx, ebf );
+    if ( m_htable ) {
+      m_htable->write( info, m_rec );
+    } else {
+      info.write( m_rec );
+    }
+    pack( keys );
+    submit( ctx, LSE_Info::LPA, LSE_Keys::LPA );
   }
 
   void LSEWriter::write( const LSE_Context& ctx, const EBF_Data& ebf, const LCI_ACD_Info& info, const LCI_Keys& keys )
   {
-    write( ctx, ebf );
+    ProducerLock lock( m_queue );
+    pack( ctx, ebf );
     int itype = LSE_Info::LCI_ACD;
-    write( itype, &info, sizeof( info ) );
-    write( keys );
+    pack( itype, &info, sizeof( info ) );
+    pack( keys );
+    submit( ctx, itype, LSE_Keys::LCI );
   }
 
   void LSEWriter::write( const LSE_Context& ctx, const EBF_Data& ebf, const LCI_CAL_Info& info, const LCI_Keys& keys )
   {
-    write( ctx, ebf );
+    ProducerLock lock( m_queue );
+    pack( ctx, ebf );
     int itype = LSE_Info::LCI_CAL;
-    write( itype, &info, sizeof( info ) );
-    write( keys );
+    pack( itype, &info, sizeof( info ) );
+    pack( keys );
+    submit( ctx, itype, LSE_Keys::LCI );
   }
 
   void LSEWriter::write( const LSE_Context& ctx, const EBF_Data& ebf, const LCI_TKR_Info& info, const LCI_Keys& keys )
   {
-    write( ctx, ebf );
+    ProducerLock lock( m_queue );
+    pack( ctx, ebf );
     int itype = LSE_Info::LCI_TKR;
-    write( itype, &info, sizeof( info ) );
-    write( keys );
+    pack( itype, &info, sizeof( info ) );
+    pack( keys );
+    submit( ctx, itype, LSE_Keys::LCI );
+  }
+
+  void LSEWriter::write( const LSE_EventView& view )
+  {
+    ProducerLock lock( m_queue );
+    if ( m_htable && view.infotype() == LSE_Info::LPA ) {
+      // the handlers still go through the table
+      m_rec.assign( view.record(), view.ebf() + view.ebfSize() );
+      LPA_Info info;
+      view.copy( info );
+      m_htable->write( info, m_rec );
+      LPA_Keys keys;
+      view.copy( keys );
+      pack( keys );
+    } else {
+      m_rec.assign( view.record(), view.record() + view.size() );
+    }
+    submit( view.ctx(), view.infotype(), view.keystype() );
+  }
+
+  bool LSEWriter::plain() const
+  {
+    // nothing but the header looks at the records
+    return m_FILE && !m_uring && !m_queue && !m_idxFILE && !m_colFILE && m_blockEvents == 0;
+  }
+
+#ifndef WIN32
+  // move up to len bytes from in at ofst to out at pos inside the kernel,
+  // returning how many were moved: fewer where copy_file_range() cannot be
+  // used between these files, none where it is not available
+#ifdef HAVE_COPY_FILE_RANGE
+  static unsigned long long kernelCopy( int in, unsigned long long ofst, int out, unsigned long long pos,
+					unsigned long long len, const std::string& name )
+  {
+    unsigned long long done(0);
+    while ( done < len ) {
+      loff_t from = ofst + done;
+      loff_t to = pos + done;
+      ssize_t n = copy_file_range( in, &from, out, &to, len - done, 0 );
+      if ( n < 0 ) {
+	if ( errno == EINTR ) continue;
+	if ( errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP ) break;
+	std::ostringstream ess;
+	ess << "LSEWriter::copy: error copying " << len - done << " bytes to " << name;
+	ess << " (" << errno << "=" << strerror( errno ) << ")";
+	throw std::runtime_error( ess.str() );
+      }
+      if ( n == 0 ) break;
+      done += n;
+    }
+    return done;
+  }
+#else
+  static unsigned long long kernelCopy( int, unsigned long long, int, unsigned long long,
+					unsigned long long, const std::string& )
+  {
+    return 0;
+  }
+#endif
+#endif
+
+  void LSEWriter::copy( const LSE_PositionalReader& src, unsigned long long begin, unsigned long long end,
+			unsigned long long nevents, const LSE_Context& first, const LSE_Context& last )
+  {
+#ifndef WIN32
+    if ( begin >= end || nevents == 0ULL ) return;
+    if ( !plain() || !src.canonical() ) {
+      // the records must be looked at one by one
+      LSE_PositionalReader::Buffer buf;
+      LSE_EventView view;
+      unsigned long long ofst( begin );
+      while ( ofst < end && src.read( ofst, buf, view, &ofst ) ) {
+	write( view );
+      }
+      return;
+    }
+
+    // bring the file up to date, then have the kernel append the records
+    if ( m_staged ) {
+      m_staged->flush();
+    } else if ( fflush( m_FILE ) != 0 ) {
+      std::ostringstream ess;
+      ess << "LSEWriter::copy: error writing to " << m_name;
+      ess << " (" << errno << "=" << strerror( errno ) << ")";
+      throw std::runtime_error( ess.str() );
+    }
+    unsigned long long pos = position();
+    unsigned long long len = end - begin;
+    unsigned long long done = kernelCopy( src.descriptor(), begin, fileno( m_FILE ), pos, len, m_name );
+    if ( m_staged ) {
+      m_staged->skip( done );
+    } else {
+      fseeko( m_FILE, pos + done, SEEK_SET );
+    }
+
+    // and whatever it could not through a buffer
+    while ( done < len ) {
+      m_rec.resize( std::min< unsigned long long >( len - done, LSEWRITER_COPY_CHUNK ) );
+      ssize_t n = pread( src.descriptor(), &m_rec[0], m_rec.size(), begin + done );
+      if ( n < 0 && errno == EINTR ) continue;
+      if ( n <= 0 ) {
+	std::ostringstream ess;
+	ess << "LSEWriter::copy: error reading " << src.name() << " at offset " << begin + done;
+	if ( n < 0 ) ess << " (" << errno << "=" << strerror( errno ) << ")";
+	throw std::runtime_error( ess.str() );
+      }
+      output( &m_rec[0], n );
+      done += n;
+    }
+
+    // capture header information
+    if ( m_hdr.m_evtcnt == 0ULL ) {
+      m_hdr.m_secs_beg = first.current.timeSecs;
+      m_hdr.m_GEMseq_beg = first.scalers.sequence;
+    }
+    m_hdr.m_evtcnt += nevents;
+    m_hdr.m_secs_end = last.current.timeSecs;
+    m_hdr.m_GEMseq_end = last.scalers.sequence;
+#else
+    std::ostringstream ess;
+    ess << "LSEWriter::copy: copying records to " << m_name;
+    ess << " not supported in this build";
+    throw std::runtime_error( ess.str() );
+#endif
   }
 
 }
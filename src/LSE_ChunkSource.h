@@ -0,0 +1,39 @@
+// -*- mode: c++ -*-
+/** @file LSE_ChunkSource.h
+ *  @brief Defines class LSE_ChunkSource, the interface LSEReader uses to pull large chunks of a file
+ */
+
+#ifndef EVENTFILE_LSE_CHUNKSOURCE_H
+#define EVENTFILE_LSE_CHUNKSOURCE_H
+
+#include <sys/types.h>
+#include <stddef.h>
+
+#include "eventFile/LSEReader.h"
+
+namespace eventFile {
+
+  /**
+   * @brief Supplies consecutive chunks of a file to a single consumer
+   *
+   * A chunk handed out by next() stays valid until the following call to
+   * next() or restart().  Implementations read ahead of the consumer in
+   * whatever way suits them (an I/O thread, an io_uring submission queue)
+   * and account for the time the consumer spends waiting.
+   */
+  class LSE_ChunkSource {
+  public:
+    virtual ~LSE_ChunkSource() {};
+
+    /// release the held chunk and wait for the next one; false at end of file
+    virtual bool next( const unsigned char*& data, size_t& len ) = 0;
+
+    /// discard everything read ahead and continue from a new offset
+    virtual void restart( off_t ofst ) = 0;
+
+    virtual LSEReader::PrefetchStats stats() const = 0;
+  };
+
+}
+
+#endif // EVENTFILE_LSE_CHUNKSOURCE_H
@@ -59,6 +59,14 @@ namespace eventFile {
   }
 
   void LSE_Context::dump() const
+  {
+    LSEHeaderMeta meta;
+    meta.set_moot_key( mootKey() );
+    meta.set_moot_alias( mootAlias() );
+    dump( meta );
+  }
+
+  void LSE_Context::dump( const LSEHeaderMeta& meta ) const
   {
     ccsds.dump(    " ccsds:     ", "\n" );
     current.dump(  " current:   ", "\n" );
@@ -67,8 +75,8 @@ namespace eventFile {
     run.dump(      " run:       ", "\n" );
     open.dump(     " open:      ", "\n" );
     close.dump(    " close:     ", "\n" );
-    printf(        " mootKey:   %10d (0x%08x)\n", mootKey(), mootKey() );
-    printf(        " mootAlias: %s\n", mootAlias() );
+    printf(        " mootKey:   %10d (0x%08x)\n", meta.moot_key(), meta.moot_key() );
+    printf(        " mootAlias: %s\n", meta.moot_alias() );
   }
 
   unsigned LSE_Context::mootKey() const
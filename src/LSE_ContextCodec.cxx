@@ -0,0 +1,179 @@
+#include <inttypes.h>
+#include <cstring>
+
+#include <sstream>
+#include <stdexcept>
+
+#include "eventFile/LSE_EventView.h"
+#include "eventFile/LPA_Handler.h"
+
+#include "LSE_ContextCodec.h"
+
+namespace eventFile {
+
+  // the sections of the context, in mask-bit order
+  static const unsigned NSECTIONS = 7;
+  static const unsigned SCALERS = 3;
+  static const unsigned char ALL_SECTIONS = 0x7F;
+  static const unsigned char SCALER_DELTA = 0x80;
+
+  // byte ranges of the sections, padding included, so that a copy of every
+  // section reproduces the context exactly
+  static void sections( size_t begin[NSECTIONS+1] )
+  {
+    LSE_Context c;
+    const unsigned char* base = reinterpret_cast< const unsigned char* >( &c );
+    begin[0] = 0;
+    begin[1] = reinterpret_cast< const unsigned char* >( &c.current ) - base;
+    begin[2] = reinterpret_cast< const unsigned char* >( &c.previous ) - base;
+    begin[3] = reinterpret_cast< const unsigned char* >( &c.scalers ) - base;
+    begin[4] = reinterpret_cast< const unsigned char* >( &c.run ) - base;
+    begin[5] = reinterpret_cast< const unsigned char* >( &c.open ) - base;
+    begin[6] = reinterpret_cast< const unsigned char* >( &c.close ) - base;
+    begin[7] = sizeof( LSE_Context );
+  }
+
+  // the scaler counters, in encoding order
+  static unsigned long long* counters( FromScalers& s, unsigned i )
+  {
+    switch ( i ) {
+    case 0: return &s.elapsed;
+    case 1: return &s.livetime;
+    case 2: return &s.prescaled;
+    case 3: return &s.discarded;
+    case 4: return &s.sequence;
+    default: return &s.deadzone;
+    }
+  }
+
+  static const unsigned NCOUNTERS = 6;
+
+  static void putVarint( std::vector< unsigned char >& out, unsigned long long v )
+  {
+    while ( v >= 0x80 ) {
+      out.push_back( static_cast< unsigned char >( v | 0x80 ) );
+      v >>= 7;
+    }
+    out.push_back( static_cast< unsigned char >( v ) );
+  }
+
+  static bool getVarint( const unsigned char*& p, const unsigned char* end, unsigned long long& v )
+  {
+    v = 0;
+    for ( unsigned shift = 0; p < end && shift < 64; shift += 7 ) {
+      unsigned char b = *p++;
+      v |= static_cast< unsigned long long >( b & 0x7F ) << shift;
+      if ( ( b & 0x80 ) == 0 ) return true;
+    }
+    return false;
+  }
+
+  static void corrupt( const char* why )
+  {
+    std::ostringstream ess;
+    ess << "LSE_ContextCodec::decode: " << why;
+    throw std::runtime_error( ess.str() );
+  }
+
+  LSE_ContextCodec::LSE_ContextCodec() :
+    m_valid( false )
+  {
+    memset( static_cast< void* >( &m_prev ), 0, sizeof( LSE_Context ) );
+  }
+
+  void LSE_ContextCodec::encode( const LSE_Context& ctx, std::vector< unsigned char >& out )
+  {
+    size_t begin[NSECTIONS+1];
+    sections( begin );
+    const unsigned char* cur = reinterpret_cast< const unsigned char* >( &ctx );
+    const unsigned char* prev = reinterpret_cast< const unsigned char* >( &m_prev );
+
+    // room for the length word and the mask
+    size_t at = out.size();
+    out.resize( at + sizeof( uint32_t ) + 1 );
+    unsigned char mask(0);
+
+    for ( unsigned i = 0; i < NSECTIONS; ++i ) {
+      size_t n = begin[i+1] - begin[i];
+      if ( m_valid && memcmp( cur + begin[i], prev + begin[i], n ) == 0 ) continue;
+
+      // counters that only moved forward are stored as increments
+      if ( i == SCALERS && m_valid ) {
+	FromScalers s( ctx.scalers ), p( m_prev.scalers );
+	bool forward( true );
+	for ( unsigned k = 0; k < NCOUNTERS; ++k ) {
+	  if ( *counters( s, k ) < *counters( p, k ) ) forward = false;
+	}
+	if ( forward ) {
+	  for ( unsigned k = 0; k < NCOUNTERS; ++k ) {
+	    putVarint( out, *counters( s, k ) - *counters( p, k ) );
+	  }
+	  mask |= SCALER_DELTA;
+	  continue;
+	}
+      }
+      out.insert( out.end(), cur + begin[i], cur + begin[i+1] );
+      mask |= 1 << i;
+    }
+
+    uint32_t len = out.size() - at - sizeof( uint32_t );
+    memcpy( &out[at], &len, sizeof( len ) );
+    out[at + sizeof( uint32_t )] = mask;
+    memcpy( static_cast< void* >( &m_prev ), &ctx, sizeof( LSE_Context ) );
+    m_valid = true;
+  }
+
+  size_t LSE_ContextCodec::measure( const unsigned char* buf, size_t avail, size_t handlerSize )
+  {
+    // the length word and the encoded context, then the canonical body
+    if ( avail < sizeof( uint32_t ) ) return 2 * sizeof( uint32_t );
+    uint32_t enclen;
+    memcpy( &enclen, buf, sizeof( enclen ) );
+    size_t head = sizeof( uint32_t ) + enclen;
+    if ( avail < head ) return head + sizeof( uint32_t );
+    return head + LSE_EventView::measureBody( buf + head, avail - head, handlerSize );
+  }
+
+  size_t LSE_ContextCodec::decode( const unsigned char* rec, size_t len, LSE_Context& ctx )
+  {
+    uint32_t enclen(0);
+    if ( len > sizeof( uint32_t ) ) memcpy( &enclen, rec, sizeof( enclen ) );
+    if ( enclen == 0 || len < sizeof( uint32_t ) + enclen ) corrupt( "truncated context" );
+    const unsigned char* p = rec + sizeof( uint32_t );
+    const unsigned char* end = p + enclen;
+    unsigned char mask = *p++;
+
+    // without history, every section must be present
+    unsigned char present = mask & ALL_SECTIONS;
+    if ( mask & SCALER_DELTA ) present |= 1 << SCALERS;
+    if ( !m_valid && present != ALL_SECTIONS ) corrupt( "no key frame before a context delta" );
+
+    unsigned char* c = reinterpret_cast< unsigned char* >( &ctx );
+    memcpy( c, &m_prev, sizeof( LSE_Context ) );
+
+    size_t begin[NSECTIONS+1];
+    sections( begin );
+    for ( unsigned i = 0; i < NSECTIONS; ++i ) {
+      if ( mask & ( 1 << i ) ) {
+	size_t n = begin[i+1] - begin[i];
+	if ( static_cast< size_t >( end - p ) < n ) corrupt( "truncated context section" );
+	memcpy( c + begin[i], p, n );
+	p += n;
+      } else if ( i == SCALERS && ( mask & SCALER_DELTA ) ) {
+	FromScalers s( m_prev.scalers );
+	for ( unsigned k = 0; k < NCOUNTERS; ++k ) {
+	  unsigned long long d;
+	  if ( !getVarint( p, end, d ) ) corrupt( "truncated scaler increment" );
+	  *counters( s, k ) += d;
+	}
+	memcpy( c + begin[SCALERS], &s, sizeof( FromScalers ) );
+      }
+    }
+    if ( p != end ) corrupt( "context length mismatch" );
+
+    memcpy( static_cast< void* >( &m_prev ), c, sizeof( LSE_Context ) );
+    m_valid = true;
+    return end - rec;
+  }
+
+}
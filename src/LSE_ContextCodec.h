@@ -0,0 +1,58 @@
+// -*- mode: c++ -*-
+/** @file LSE_ContextCodec.h
+ *  @brief Defines class LSE_ContextCodec, the context encoding of CONTEXT_DELTA event files
+ */
+
+#ifndef EVENTFILE_LSE_CONTEXTCODEC_H
+#define EVENTFILE_LSE_CONTEXTCODEC_H
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "eventFile/LSE_Context.h"
+
+namespace eventFile {
+
+  /**
+   * @brief Stores each LSE_Context as its changes from the previous one
+   *
+   * An encoded record holds the length of the encoded context (a 32-bit
+   * word), the encoded context, and then the rest of the record as it
+   * would follow a raw context.  The encoded context is a mask byte naming the
+   * sections (ccsds, current, previous, scalers, run, open, close) that
+   * differ from the previous event's, followed by those sections: raw, or,
+   * for scalers whose counters have all moved forward, as LEB128 varint
+   * increments.  A key frame carries every section and needs no history.
+   *
+   * The writer and the reader each keep one codec and must reset() it at
+   * the same records, the start of each block.
+   */
+  class LSE_ContextCodec {
+  public:
+    LSE_ContextCodec();
+
+    /// forget the previous context, so the next encoding is a key frame
+    void reset() { m_valid = false; };
+
+    /// take ctx as the previous context, e.g. one decoded earlier
+    void resume( const LSE_Context& ctx ) { m_prev = ctx; m_valid = true; };
+
+    /// append the length word and the encoded context to out
+    void encode( const LSE_Context& ctx, std::vector< unsigned char >& out );
+
+    /// LSE_EventView::measure() for an encoded record
+    static size_t measure( const unsigned char* buf, size_t avail, size_t handlerSize );
+
+    /// rebuild the context at the front of an encoded record, returning
+    /// the number of record bytes it took up
+    size_t decode( const unsigned char* rec, size_t len, LSE_Context& ctx );
+
+  private:
+    LSE_Context m_prev;
+    bool        m_valid;
+  };
+
+}
+
+#endif // EVENTFILE_LSE_CONTEXTCODEC_H
@@ -0,0 +1,206 @@
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <sstream>
+#include <stdexcept>
+
+#ifdef HAVE_FACILITIES
+#include "facilities/Util.h"
+#endif
+
+#include "eventFile/LSE_ContextColumns.h"
+#include "eventFile/LSE_Context.h"
+
+namespace eventFile {
+
+  LSE_ColumnsHeader::LSE_ColumnsHeader() :
+    marker( LSE_COLUMNS_MARKER ), version( LSE_COLUMNS_VERSION ),
+    ncolumns( LSE_ContextColumns::NCOLUMNS ), runid( 0 ), count( 0 )
+  {
+  }
+
+  void LSE_ColumnsHeader::read( FILE* fp, const std::string& name )
+  {
+    size_t nitems = fread( this, sizeof( LSE_ColumnsHeader ), 1, fp );
+    if ( nitems != 1 ) {
+      std::ostringstream ess;
+      ess << "LSE_ColumnsHeader::read: error reading header from " << name;
+      ess << " (" << errno << "=" << strerror( errno ) << ")";
+      throw std::runtime_error( ess.str() );
+    }
+    if ( marker != LSE_COLUMNS_MARKER ) {
+      std::ostringstream ess;
+      ess << "LSE_ColumnsHeader::read: " << name << " is not an LSE columns file";
+      throw std::runtime_error( ess.str() );
+    }
+    if ( version != LSE_COLUMNS_VERSION || ncolumns != LSE_ContextColumns::NCOLUMNS ) {
+      std::ostringstream ess;
+      ess << "LSE_ColumnsHeader::read: unsupported columns format in " << name;
+      ess << ", file is v" << version << " with " << ncolumns << " columns";
+      throw std::runtime_error( ess.str() );
+    }
+  }
+
+  void LSE_ColumnsHeader::write( FILE* fp, const std::string& name )
+  {
+    size_t nitems = fwrite( this, sizeof( LSE_ColumnsHeader ), 1, fp );
+    if ( nitems != 1 ) {
+      std::ostringstream ess;
+      ess << "LSE_ColumnsHeader::write: error writing header to " << name;
+      ess << " (" << errno << "=" << strerror( errno ) << ")";
+      throw std::runtime_error( ess.str() );
+    }
+  }
+
+  void LSE_ContextColumns::clear()
+  {
+    elapsed.clear();
+    livetime.clear();
+    prescaled.clear();
+    discarded.clear();
+    sequence.clear();
+    deadzone.clear();
+    utc.clear();
+    timeSecs.clear();
+    tics.clear();
+    hacks.clear();
+  }
+
+  void LSE_ContextColumns::reserve( size_t nevents )
+  {
+    elapsed.reserve( nevents );
+    livetime.reserve( nevents );
+    prescaled.reserve( nevents );
+    discarded.reserve( nevents );
+    sequence.reserve( nevents );
+    deadzone.reserve( nevents );
+    utc.reserve( nevents );
+    timeSecs.reserve( nevents );
+    tics.reserve( nevents );
+    hacks.reserve( nevents );
+  }
+
+  void LSE_ContextColumns::append( const LSE_Context& ctx )
+  {
+    elapsed.push_back( ctx.scalers.elapsed );
+    livetime.push_back( ctx.scalers.livetime );
+    prescaled.push_back( ctx.scalers.prescaled );
+    discarded.push_back( ctx.scalers.discarded );
+    sequence.push_back( ctx.scalers.sequence );
+    deadzone.push_back( ctx.scalers.deadzone );
+    utc.push_back( ctx.ccsds.utc );
+    timeSecs.push_back( ctx.current.timeSecs );
+    tics.push_back( ctx.current.timeHack.tics );
+    hacks.push_back( ctx.current.timeHack.hacks );
+  }
+
+  // write or read the tail of one column
+  template < class T >
+  static void writeColumn( FILE* fp, const std::vector< T >& col, const std::string& name )
+  {
+    if ( col.empty() ) return;
+    if ( fwrite( &col[0], sizeof( T ), col.size(), fp ) != col.size() ) {
+      std::ostringstream ess;
+      ess << "LSE_ContextColumns::writeBlock: error writing to " << name;
+      ess << " (" << errno << "=" << strerror( errno ) << ")";
+      throw std::runtime_error( ess.str() );
+    }
+  }
+
+  template < class T >
+  static void readColumn( FILE* fp, std::vector< T >& col, unsigned n, const std::string& name )
+  {
+    size_t have = col.size();
+    col.resize( have + n );
+    if ( fread( &col[have], sizeof( T ), n, fp ) != n ) {
+      std::ostringstream ess;
+      ess << "LSE_ContextColumns::readBlock: " << name << " truncated";
+      throw std::runtime_error( ess.str() );
+    }
+  }
+
+  void LSE_ContextColumns::writeBlock( FILE* fp, const std::string& name ) const
+  {
+    // the block length, then each column in turn
+    unsigned n = size();
+    if ( fwrite( &n, sizeof( unsigned ), 1, fp ) != 1 ) {
+      std::ostringstream ess;
+      ess << "LSE_ContextColumns::writeBlock: error writing to " << name;
+      ess << " (" << errno << "=" << strerror( errno ) << ")";
+      throw std::runtime_error( ess.str() );
+    }
+    writeColumn( fp, elapsed, name );
+    writeColumn( fp, livetime, name );
+    writeColumn( fp, prescaled, name );
+    writeColumn( fp, discarded, name );
+    writeColumn( fp, sequence, name );
+    writeColumn( fp, deadzone, name );
+    writeColumn( fp, utc, name );
+    writeColumn( fp, timeSecs, name );
+    writeColumn( fp, tics, name );
+    writeColumn( fp, hacks, name );
+  }
+
+  bool LSE_ContextColumns::readBlock( FILE* fp, const std::string& name )
+  {
+    unsigned n(0);
+    if ( fread( &n, sizeof( unsigned ), 1, fp ) != 1 ) {
+      if ( feof( fp ) ) return false;
+      std::ostringstream ess;
+      ess << "LSE_ContextColumns::readBlock: error reading from " << name;
+      ess << " (" << errno << "=" << strerror( errno ) << ")";
+      throw std::runtime_error( ess.str() );
+    }
+    if ( n == 0 ) return true;
+    readColumn( fp, elapsed, n, name );
+    readColumn( fp, livetime, n, name );
+    readColumn( fp, prescaled, n, name );
+    readColumn( fp, discarded, n, name );
+    readColumn( fp, sequence, n, name );
+    readColumn( fp, deadzone, n, name );
+    readColumn( fp, utc, n, name );
+    readColumn( fp, timeSecs, n, name );
+    readColumn( fp, tics, n, name );
+    readColumn( fp, hacks, n, name );
+    return true;
+  }
+
+  LSE_ColumnsHeader LSE_ContextColumns::load( const std::string& filename )
+  {
+    std::string name( filename );
+#ifdef HAVE_FACILITIES
+    // expand any environment variables in the filename
+    facilities::Util::expandEnvVar( &name );
+#endif
+
+    FILE* fp = fopen( name.c_str(), "rb" );
+    if ( fp == NULL ) {
+      std::ostringstream ess;
+      ess << "LSE_ContextColumns::load: error opening " << name;
+      ess << " (" << errno << "=" << strerror( errno ) << ")";
+      throw std::runtime_error( ess.str() );
+    }
+
+    LSE_ColumnsHeader hdr;
+    try {
+      hdr.read( fp, name );
+      clear();
+      reserve( hdr.count );
+      while ( readBlock( fp, name ) ) {}
+    } catch ( std::runtime_error& ) {
+      fclose( fp );
+      throw;
+    }
+    fclose( fp );
+
+    if ( size() != hdr.count ) {
+      std::ostringstream ess;
+      ess << "LSE_ContextColumns::load: " << name << " holds " << size();
+      ess << " events, header says " << hdr.count;
+      throw std::runtime_error( ess.str() );
+    }
+    return hdr;
+  }
+
+}
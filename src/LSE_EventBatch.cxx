@@ -0,0 +1,44 @@
+#include "eventFile/LSE_EventBatch.h"
+#include "eventFile/LSE_EventView.h"
+#include "eventFile/LSE_Context.h"
+
+namespace eventFile {
+
+  void LSE_EventBatch::clear()
+  {
+    sequence.clear();
+    timeSecs.clear();
+    livetime.clear();
+    infotype.clear();
+    keystype.clear();
+    ebfOffset.clear();
+    ebfLength.clear();
+    payload.clear();
+  }
+
+  void LSE_EventBatch::reserve( size_t nevents, size_t nbytes )
+  {
+    sequence.reserve( nevents );
+    timeSecs.reserve( nevents );
+    livetime.reserve( nevents );
+    infotype.reserve( nevents );
+    keystype.reserve( nevents );
+    ebfOffset.reserve( nevents );
+    ebfLength.reserve( nevents );
+    payload.reserve( nbytes );
+  }
+
+  void LSE_EventBatch::append( const LSE_EventView& view )
+  {
+    const LSE_Context& ctx = view.ctx();
+    sequence.push_back( ctx.scalers.sequence );
+    timeSecs.push_back( ctx.current.timeSecs );
+    livetime.push_back( ctx.scalers.livetime );
+    infotype.push_back( view.infotype() );
+    keystype.push_back( view.keystype() );
+    ebfOffset.push_back( payload.size() );
+    ebfLength.push_back( view.ebfSize() );
+    payload.insert( payload.end(), view.ebf(), view.ebf() + view.ebfSize() );
+  }
+
+}
@@ -0,0 +1,209 @@
+// the fetcher relies on POSIX threads
+#ifndef WIN32
+
+#include <unistd.h>
+#include <sys/time.h>
+#include <cstring>
+
+#include <exception>
+#include <sstream>
+#include <stdexcept>
+
+#include "eventFile/LSE_EventFetcher.h"
+
+namespace eventFile {
+
+  // wall-clock seconds, for the wait-time accounting
+  static double now()
+  {
+    struct timeval tv;
+    gettimeofday( &tv, NULL );
+    return tv.tv_sec + 1.0e-6 * tv.tv_usec;
+  }
+
+  LSE_EventFetcher::LSE_EventFetcher( unsigned nthreads, unsigned depth ) :
+    m_slots(), m_head( 0 ), m_count( 0 ), m_take( 0 ), m_queued( 0 ), m_held( false ),
+    m_stop( false ), m_threads(), m_stats()
+  {
+    if ( nthreads == 0 ) {
+      long ncpu = sysconf( _SC_NPROCESSORS_ONLN );
+      nthreads = ( ncpu > 0 ) ? ncpu : 1;
+    }
+    if ( depth < 1 ) depth = 1;
+    m_slots.resize( depth );
+
+    pthread_mutex_init( &m_mutex, NULL );
+    pthread_cond_init( &m_queuedCond, NULL );
+    pthread_cond_init( &m_doneCond, NULL );
+    pthread_cond_init( &m_freedCond, NULL );
+
+    for ( unsigned i = 0; i < nthreads; ++i ) {
+      pthread_t t;
+      int err = pthread_create( &t, NULL, &LSE_EventFetcher::run, this );
+      if ( err != 0 ) {
+	shutdown();
+	std::ostringstream ess;
+	ess << "LSE_EventFetcher::LSE_EventFetcher: error starting reader thread " << i;
+	ess << " (" << err << "=" << strerror( err ) << ")";
+	throw std::runtime_error( ess.str() );
+      }
+      m_threads.push_back( t );
+    }
+  }
+
+  LSE_EventFetcher::~LSE_EventFetcher()
+  {
+    shutdown();
+  }
+
+  void LSE_EventFetcher::shutdown()
+  {
+    // let the reads in progress finish, and drop the ones still queued
+    pthread_mutex_lock( &m_mutex );
+    m_stop = true;
+    pthread_cond_broadcast( &m_queuedCond );
+    pthread_mutex_unlock( &m_mutex );
+    for ( size_t i = 0; i < m_threads.size(); ++i ) {
+      pthread_join( m_threads[i], NULL );
+    }
+    m_threads.clear();
+    pthread_cond_destroy( &m_freedCond );
+    pthread_cond_destroy( &m_doneCond );
+    pthread_cond_destroy( &m_queuedCond );
+    pthread_mutex_destroy( &m_mutex );
+  }
+
+  void* LSE_EventFetcher::run( void* arg )
+  {
+    static_cast< LSE_EventFetcher* >( arg )->loop();
+    return NULL;
+  }
+
+  void LSE_EventFetcher::loop()
+  {
+    pthread_mutex_lock( &m_mutex );
+    for (;;) {
+      while ( m_queued == 0 && !m_stop ) {
+	pthread_cond_wait( &m_queuedCond, &m_mutex );
+      }
+      if ( m_stop ) break;
+
+      // requests are taken in order; the caller leaves a slot alone until it is done
+      Slot& slot = m_slots[m_take];
+      m_take = ( m_take + 1 ) % m_slots.size();
+      --m_queued;
+      slot.state = READING;
+      pthread_mutex_unlock( &m_mutex );
+
+      slot.error.clear();
+      try {
+	if ( slot.extentOnly ) {
+	  slot.found = slot.src->probe( slot.ofst, slot.ctx, slot.infotype, slot.keystype, slot.end );
+	} else {
+	  slot.found = slot.src->read( slot.ofst, slot.buf, slot.view, &slot.end );
+	}
+      } catch ( std::exception& e ) {
+	slot.error = e.what();
+      }
+
+      pthread_mutex_lock( &m_mutex );
+      slot.state = DONE;
+      pthread_cond_broadcast( &m_doneCond );
+    }
+    pthread_mutex_unlock( &m_mutex );
+  }
+
+  void LSE_EventFetcher::release()
+  {
+    // called with the mutex held
+    if ( m_held ) {
+      m_held = false;
+      m_head = ( m_head + 1 ) % m_slots.size();
+      --m_count;
+      pthread_cond_signal( &m_freedCond );
+    }
+  }
+
+  void LSE_EventFetcher::request( const LSE_PositionalReader& src, unsigned long long ofst, bool extentOnly )
+  {
+    pthread_mutex_lock( &m_mutex );
+    release();
+    while ( m_count == m_slots.size() ) {
+      pthread_cond_wait( &m_freedCond, &m_mutex );
+    }
+
+    Slot& slot = m_slots[ ( m_head + m_count ) % m_slots.size() ];
+    slot.src        = &src;
+    slot.ofst       = ofst;
+    slot.extentOnly = extentOnly;
+    slot.state      = QUEUED;
+    ++m_count;
+    ++m_queued;
+    m_stats.requests++;
+    pthread_cond_signal( &m_queuedCond );
+    pthread_mutex_unlock( &m_mutex );
+  }
+
+  LSE_EventFetcher::Slot& LSE_EventFetcher::oldest( bool extentOnly )
+  {
+    pthread_mutex_lock( &m_mutex );
+    release();
+    if ( m_count == 0 || m_slots[m_head].extentOnly != extentOnly ) {
+      pthread_mutex_unlock( &m_mutex );
+      std::ostringstream ess;
+      ess << "LSE_EventFetcher::next: no outstanding request for ";
+      ess << ( extentOnly ? "an extent" : "a record" );
+      throw std::runtime_error( ess.str() );
+    }
+
+    // wait for the read, charging the time to the caller
+    Slot& slot = m_slots[m_head];
+    if ( slot.state != DONE ) {
+      double t0 = now();
+      while ( slot.state != DONE ) {
+	pthread_cond_wait( &m_doneCond, &m_mutex );
+      }
+      m_stats.waits++;
+      m_stats.waitTime += now() - t0;
+    }
+    m_held = true;
+    pthread_mutex_unlock( &m_mutex );
+
+    if ( !slot.error.empty() ) {
+      throw std::runtime_error( slot.error );
+    }
+    return slot;
+  }
+
+  bool LSE_EventFetcher::next( LSE_EventView& view, unsigned long long& end )
+  {
+    Slot& slot = oldest( false );
+    if ( !slot.found ) return false;
+    view = slot.view;
+    end = slot.end;
+    return true;
+  }
+
+  bool LSE_EventFetcher::next( LSE_Context& ctx, LSE_Info::InfoType& infotype, LSE_Keys::KeysType& keystype,
+			       unsigned long long& end )
+  {
+    Slot& slot = oldest( true );
+    if ( !slot.found ) return false;
+    ctx = slot.ctx;
+    infotype = slot.infotype;
+    keystype = slot.keystype;
+    end = slot.end;
+    return true;
+  }
+
+  LSE_EventFetcher::Stats LSE_EventFetcher::stats() const
+  {
+    pthread_mutex_lock( &m_mutex );
+    Stats s( m_stats );
+    pthread_mutex_unlock( &m_mutex );
+    return s;
+  }
+
+}
+
+#endif // WIN32
@@ -0,0 +1,26 @@
+#include <stdio.h>
+
+#include "eventFile/LSE_EventFilter.h"
+#include "eventFile/LSE_EventView.h"
+
+namespace eventFile {
+
+  bool LSE_InfoTypeFilter::accept( const LSE_EventView& view )
+  {
+    return view.infotype() == m_itype;
+  }
+
+  bool LSE_HandlerFilter::accept( const LSE_EventView& view )
+  {
+    if ( view.infotype() != LSE_Info::LPA ) return false;
+
+    // look for the handler among those that reported for the event
+    const LPA_Handler* h = view.handlers();
+    for ( unsigned i = 0; i < view.nhandlers(); ++i ) {
+      if ( h[i].id != m_id ) continue;
+      return h[i].state == m_state && ( m_anyPrescaler || h[i].prescaler == m_prescaler );
+    }
+    return false;
+  }
+
+}
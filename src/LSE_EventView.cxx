@@ -0,0 +1,243 @@
+#include <inttypes.h>
+#include <cstring>
+
+#include <algorithm>
+#include <vector>
+#include <sstream>
+#include <stdexcept>
+
+#include "eventFile/LSE_EventView.h"
+#include "eventFile/LSE_Context.h"
+#include "eventFile/LSEHeader.h"
+#include "eventFile/LPA_Handler.h"
+#include "eventFile/EBF_Data.h"
+
+namespace eventFile {
+
+  // size of the part of LPA_Info that LPA_Info::write() dumps as a block
+  static const size_t LPA_FIXED_SIZE = sizeof( LPA_Info ) - sizeof( std::vector< LPA_Handler > );
+
+  // fetch a possibly-unaligned 32-bit word from a record
+  static inline uint32_t word( const unsigned char* p )
+  {
+    uint32_t w;
+    memcpy( &w, p, sizeof w );
+    return w;
+  }
+
+  // copy a stored LCI_Info block, which may be shorter than the struct
+  template< class T > static void copyInfo( T& info, const unsigned char* src, size_t len )
+  {
+    size_t n = std::min( len, sizeof( T ) );
+    memcpy( static_cast<void*>( &info ), src, n );
+    memset( reinterpret_cast<unsigned char*>( &info ) + n, 0, sizeof( T ) - n );
+  }
+
+  LSE_EventView::LSE_EventView() :
+    m_rec( NULL ), m_len( 0 ), m_ebf( NULL ), m_ebflen( 0 ),
+    m_itype( LSE_Info::NONE ), m_info( NULL ), m_nhandlers( 0 ), m_infolen( 0 ),
+    m_ktype( LSE_Keys::NONE ), m_keys( NULL ), m_meta( NULL )
+  {
+  }
+
+  unsigned LSE_EventView::mootKey() const
+  {
+    return m_meta ? m_meta->moot_key() : LSEHeader::moot_key();
+  }
+
+  const char* LSE_EventView::mootAlias() const
+  {
+    return m_meta ? m_meta->moot_alias() : LSEHeader::moot_alias();
+  }
+
+  size_t LSE_EventView::measure( const unsigned char* buf, size_t avail )
+  {
+    return measure( buf, avail, sizeof( LPA_Handler ) );
+  }
+
+  size_t LSE_EventView::measure( const unsigned char* buf, size_t avail, size_t handlerSize )
+  {
+    // the context, then everything behind it
+    const size_t head = sizeof( LSE_Context );
+    if ( avail < head ) return head + sizeof( uint32_t );
+    return head + measureBody( buf + head, avail - head, handlerSize );
+  }
+
+  size_t LSE_EventView::measureBody( const unsigned char* buf, size_t avail, size_t handlerSize,
+				     LSE_Info::InfoType* infotype, LSE_Keys::KeysType* keystype )
+  {
+    // the EBF length word
+    size_t need = sizeof( uint32_t );
+    if ( avail < need ) return need;
+
+    // the EBF payload and the LSE_Info typeid
+    need += word( buf ) + sizeof( int );
+    if ( avail < need ) return need;
+
+    // the LSE_Info content
+    int itype = static_cast<int>( word( buf + need - sizeof( int ) ) );
+    if ( infotype ) *infotype = static_cast< LSE_Info::InfoType >( itype );
+    switch ( itype ) {
+    case LSE_Info::LPA:
+      need += LPA_FIXED_SIZE + sizeof( unsigned );
+      if ( avail < need ) return need;
+      need += word( buf + need - sizeof( unsigned ) ) * handlerSize;
+      break;
+    case LSE_Info::LCI_ACD:
+    case LSE_Info::LCI_CAL:
+    case LSE_Info::LCI_TKR:
+      need += sizeof( uint32_t );
+      if ( avail < need ) return need;
+      if ( word( buf + need - sizeof( uint32_t ) ) > LSE_INFO_MAX_LCI ) {
+	std::ostringstream ess;
+	ess << "LSE_EventView::measure: LCI_Info length " << word( buf + need - sizeof( uint32_t ) );
+	ess << " exceeds " << LSE_INFO_MAX_LCI;
+	throw std::runtime_error( ess.str() );
+      }
+      need += word( buf + need - sizeof( uint32_t ) );
+      break;
+    default:
+      break;
+    }
+
+    // the LSE_Keys typeid and key values
+    need += sizeof( int );
+    if ( avail < need ) return need;
+    int ktype = static_cast<int>( word( buf + need - sizeof( int ) ) );
+    if ( keystype ) *keystype = static_cast< LSE_Keys::KeysType >( ktype );
+    switch ( ktype ) {
+    case LSE_Keys::LPA:
+      need += 4 * sizeof( unsigned );
+      break;
+    case LSE_Keys::LCI:
+      need += 3 * sizeof( unsigned );
+      break;
+    default:
+      std::ostringstream ess;
+      ess << "LSE_EventView::measure: unknown LSE_Keys typeid " << ktype;
+      throw std::runtime_error( ess.str() );
+    }
+    return need;
+  }
+
+  size_t LSE_EventView::parse( const unsigned char* buf, size_t avail )
+  {
+    size_t len = measure( buf, avail );
+    if ( len > avail ) return 0;
+
+    // locate the EBF payload
+    const unsigned char* p = buf + sizeof( LSE_Context );
+    m_ebflen = word( p );
+    m_ebf = p + sizeof( uint32_t );
+    p = m_ebf + m_ebflen;
+
+    // locate the LSE_Info content
+    m_itype = static_cast<LSE_Info::InfoType>( word( p ) );
+    p += sizeof( int );
+    m_info = NULL;
+    m_nhandlers = 0;
+    m_infolen = 0;
+    switch ( m_itype ) {
+    case LSE_Info::LPA:
+      m_info = p;
+      m_nhandlers = word( p + LPA_FIXED_SIZE );
+      p += LPA_FIXED_SIZE + sizeof( unsigned ) + m_nhandlers * sizeof( LPA_Handler );
+      break;
+    case LSE_Info::LCI_ACD:
+    case LSE_Info::LCI_CAL:
+    case LSE_Info::LCI_TKR:
+      m_info = p + sizeof( uint32_t );
+      m_infolen = word( p );
+      p = m_info + m_infolen;
+      break;
+    default:
+      break;
+    }
+
+    // locate the key values
+    m_ktype = static_cast<LSE_Keys::KeysType>( word( p ) );
+    m_keys = p + sizeof( int );
+
+    m_rec = buf;
+    m_len = len;
+    return len;
+  }
+
+  const LPA_Handler* LSE_EventView::handlers() const
+  {
+    if ( m_itype != LSE_Info::LPA || m_nhandlers == 0 ) return NULL;
+    return reinterpret_cast< const LPA_Handler* >( m_info + LPA_FIXED_SIZE + sizeof( unsigned ) );
+  }
+
+  const LCI_ACD_Info* LSE_EventView::ainfo() const
+  {
+    return ( m_itype == LSE_Info::LCI_ACD && m_infolen >= sizeof( LCI_ACD_Info ) ) ? reinterpret_cast< const LCI_ACD_Info* >( m_info ) : NULL;
+  }
+
+  const LCI_CAL_Info* LSE_EventView::cinfo() const
+  {
+    return ( m_itype == LSE_Info::LCI_CAL && m_infolen >= sizeof( LCI_CAL_Info ) ) ? reinterpret_cast< const LCI_CAL_Info* >( m_info ) : NULL;
+  }
+
+  const LCI_TKR_Info* LSE_EventView::tinfo() const
+  {
+    return ( m_itype == LSE_Info::LCI_TKR && m_infolen >= sizeof( LCI_TKR_Info ) ) ? reinterpret_cast< const LCI_TKR_Info* >( m_info ) : NULL;
+  }
+
+  unsigned LSE_EventView::LATC_master() const
+  {
+    return word( m_keys );
+  }
+
+  unsigned LSE_EventView::LATC_ignore() const
+  {
+    return word( m_keys + sizeof( unsigned ) );
+  }
+
+  void LSE_EventView::copy( EBF_Data& ebf ) const
+  {
+    ebf.assign( m_ebflen, m_ebf );
+  }
+
+  void LSE_EventView::copy( LPA_Info& pinfo ) const
+  {
+    memcpy( static_cast<void*>( &pinfo ), m_info, LPA_FIXED_SIZE );
+    if ( pinfo.handlers.size() != m_nhandlers ) {
+      pinfo.handlers.resize( m_nhandlers );
+    }
+    if ( m_nhandlers > 0 ) {
+      memcpy( static_cast<void*>( &pinfo.handlers[0] ), handlers(), m_nhandlers * sizeof( LPA_Handler ) );
+    }
+  }
+
+  void LSE_EventView::copy( LCI_ACD_Info& ainfo ) const
+  {
+    copyInfo( ainfo, m_info, m_infolen );
+  }
+
+  void LSE_EventView::copy( LCI_CAL_Info& cinfo ) const
+  {
+    copyInfo( cinfo, m_info, m_infolen );
+  }
+
+  void LSE_EventView::copy( LCI_TKR_Info& tinfo ) const
+  {
+    copyInfo( tinfo, m_info, m_infolen );
+  }
+
+  void LSE_EventView::copy( LPA_Keys& pakeys ) const
+  {
+    pakeys.LATC_master = word( m_keys );
+    pakeys.LATC_ignore = word( m_keys + sizeof( unsigned ) );
+    pakeys.SBS         = word( m_keys + 2 * sizeof( unsigned ) );
+    pakeys.LPA_db      = word( m_keys + 3 * sizeof( unsigned ) );
+  }
+
+  void LSE_EventView::copy( LCI_Keys& cikeys ) const
+  {
+    cikeys.LATC_master = word( m_keys );
+    cikeys.LATC_ignore = word( m_keys + sizeof( unsigned ) );
+    cikeys.LCI_script  = word( m_keys + 2 * sizeof( unsigned ) );
+  }
+
+}
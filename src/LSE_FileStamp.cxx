@@ -0,0 +1,53 @@
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "eventFile/LSE_FileStamp.h"
+
+namespace eventFile {
+
+#ifndef WIN32
+  // the nanoseconds of the modification time, where struct stat has them
+  static inline long mtimeNsec( const struct stat& stbuf )
+  {
+#ifdef HAVE_ST_MTIM
+    return stbuf.st_mtim.tv_nsec;
+#else
+    (void) stbuf;
+    return 0;
+#endif
+  }
+#endif
+
+  LSE_FileStamp::LSE_FileStamp() :
+    m_valid( false ), m_dev( 0 ), m_ino( 0 ), m_size( 0 ), m_mtime( 0 ), m_mtimeNsec( 0 )
+  {
+  }
+
+  bool LSE_FileStamp::take( int fd )
+  {
+#ifndef WIN32
+    struct stat stbuf;
+    if ( fstat( fd, &stbuf ) != 0 ) {
+      m_valid = false;
+      return false;
+    }
+    bool same = m_valid
+      && m_dev == static_cast< unsigned long long >( stbuf.st_dev )
+      && m_ino == static_cast< unsigned long long >( stbuf.st_ino )
+      && m_size == static_cast< unsigned long long >( stbuf.st_size )
+      && m_mtime == static_cast< long long >( stbuf.st_mtime )
+      && m_mtimeNsec == mtimeNsec( stbuf );
+    m_valid = true;
+    m_dev = stbuf.st_dev;
+    m_ino = stbuf.st_ino;
+    m_size = stbuf.st_size;
+    m_mtime = stbuf.st_mtime;
+    m_mtimeNsec = mtimeNsec( stbuf );
+    return same;
+#else
+    m_valid = false;
+    return false;
+#endif
+  }
+
+}
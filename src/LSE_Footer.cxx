@@ -0,0 +1,186 @@
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <sys/types.h>
+
+#include <sstream>
+#include <stdexcept>
+
+#include "eventFile/LSE_Footer.h"
+
+namespace eventFile {
+
+  LSE_Footer::LSE_Footer() :
+    blocks(), frames(), handlers(), offset( 0 ), lastEvent( 0 ), flags( 0 ), blockEvents( 0 )
+  {
+  }
+
+  void LSE_Footer::read( FILE* fp, const std::string& name )
+  {
+    // the trailer is the last thing in the file
+    LSE_Trailer trailer;
+#ifdef _FILE_OFFSET_BITS
+    off_t back = sizeof( LSE_Trailer );
+    int err = fseeko( fp, -back, SEEK_END );
+    unsigned long long at = ftello( fp );
+#else
+    long back = sizeof( LSE_Trailer );
+    int err = fseek( fp, -back, SEEK_END );
+    unsigned long long at = ftell( fp );
+#endif
+    if ( err != 0 || fread( &trailer, sizeof( LSE_Trailer ), 1, fp ) != 1 ) {
+      std::ostringstream ess;
+      ess << "LSE_Footer::read: error reading trailer from " << name;
+      ess << " (" << errno << "=" << strerror( errno ) << ")";
+      throw std::runtime_error( ess.str() );
+    }
+    // a v10 file without one was never finished, and its records cannot be
+    // read as v9 events
+    if ( trailer.marker != LSE_FOOTER_MARKER ) {
+      std::ostringstream ess;
+      ess << "LSE_Footer::read: " << name << " has no block footer; its writer did not finish it";
+      throw std::runtime_error( ess.str() );
+    }
+    if ( trailer.footer > at || trailer.nblocks > ( at - trailer.footer ) / sizeof( LSE_BlockInfo ) ) {
+      std::ostringstream ess;
+      ess << "LSE_Footer::read: " << name << " has a corrupt trailer";
+      throw std::runtime_error( ess.str() );
+    }
+
+    offset      = trailer.footer;
+    lastEvent   = trailer.lastEvent;
+    flags       = trailer.flags;
+    blockEvents = trailer.blockEvents;
+
+    // then the block table it points to
+#ifdef _FILE_OFFSET_BITS
+    err = fseeko( fp, static_cast< off_t >( offset ), SEEK_SET );
+#else
+    err = fseek( fp, static_cast< long >( offset ), SEEK_SET );
+#endif
+    blocks.resize( trailer.nblocks );
+    if ( err != 0 || trailer.nblocks > 0 ) {
+      if ( err != 0 || fread( &blocks[0], sizeof( LSE_BlockInfo ), blocks.size(), fp ) != blocks.size() ) {
+	std::ostringstream ess;
+	ess << "LSE_Footer::read: error reading " << trailer.nblocks << " block entries from " << name;
+	ess << " (" << errno << "=" << strerror( errno ) << ")";
+	throw std::runtime_error( ess.str() );
+      }
+    }
+
+    // and the frame table behind it
+    frames.clear();
+    if ( ( flags & COMPRESSED ) && trailer.nblocks > 0 ) {
+      frames.resize( trailer.nblocks );
+      if ( fread( &frames[0], sizeof( unsigned long long ), frames.size(), fp ) != frames.size() ) {
+	std::ostringstream ess;
+	ess << "LSE_Footer::read: error reading " << trailer.nblocks << " frame offsets from " << name;
+	ess << " (" << errno << "=" << strerror( errno ) << ")";
+	throw std::runtime_error( ess.str() );
+      }
+    }
+
+    // and the handler-config table
+    handlers.clear();
+    if ( flags & HANDLER_TABLE ) {
+      unsigned nconfigs(0);
+      bool ok = fread( &nconfigs, sizeof( unsigned ), 1, fp ) == 1;
+      if ( ok && nconfigs > 0 ) {
+	handlers.resize( nconfigs );
+	ok = fread( &handlers[0], sizeof( LSE_HandlerConfig ), nconfigs, fp ) == nconfigs;
+      }
+      if ( !ok ) {
+	std::ostringstream ess;
+	ess << "LSE_Footer::read: error reading handler-config table from " << name;
+	ess << " (" << errno << "=" << strerror( errno ) << ")";
+	throw std::runtime_error( ess.str() );
+      }
+    }
+  }
+
+  void LSE_Footer::write( FILE* fp, const std::string& name )
+  {
+#ifdef _FILE_OFFSET_BITS
+    offset = ftello( fp );
+#else
+    offset = ftell( fp );
+#endif
+
+    LSE_Trailer trailer;
+    trailer.footer      = offset;
+    trailer.lastEvent   = lastEvent;
+    trailer.flags       = flags;
+    trailer.blockEvents = blockEvents;
+    trailer.nblocks     = blocks.size();
+    trailer.marker      = LSE_FOOTER_MARKER;
+
+    bool ok = true;
+    if ( !blocks.empty() ) {
+      ok = fwrite( &blocks[0], sizeof( LSE_BlockInfo ), blocks.size(), fp ) == blocks.size();
+    }
+    if ( ok && ( flags & COMPRESSED ) && !frames.empty() ) {
+      ok = fwrite( &frames[0], sizeof( unsigned long long ), frames.size(), fp ) == frames.size();
+    }
+    if ( ok && ( flags & HANDLER_TABLE ) ) {
+      unsigned nconfigs = handlers.size();
+      ok = fwrite( &nconfigs, sizeof( unsigned ), 1, fp ) == 1;
+      if ( ok && nconfigs > 0 ) {
+	ok = fwrite( &handlers[0], sizeof( LSE_HandlerConfig ), nconfigs, fp ) == nconfigs;
+      }
+    }
+    if ( !ok || fwrite( &trailer, sizeof( LSE_Trailer ), 1, fp ) != 1 ) {
+      std::ostringstream ess;
+      ess << "LSE_Footer::write: error writing footer to " << name;
+      ess << " (" << errno << "=" << strerror( errno ) << ")";
+      throw std::runtime_error( ess.str() );
+    }
+  }
+
+  size_t LSE_Footer::lowerSequence( unsigned long long seq ) const
+  {
+    // blocks are in file order, so their maxima increase with the index
+    size_t lo( 0 ), hi( blocks.size() );
+    while ( lo < hi ) {
+      size_t mid = lo + ( hi - lo ) / 2;
+      if ( blocks[mid].maxSequence < seq ) {
+	lo = mid + 1;
+      } else {
+	hi = mid;
+      }
+    }
+    return lo;
+  }
+
+  size_t LSE_Footer::lowerTime( unsigned secs ) const
+  {
+    size_t lo( 0 ), hi( blocks.size() );
+    while ( lo < hi ) {
+      size_t mid = lo + ( hi - lo ) / 2;
+      if ( blocks[mid].maxSecs < secs ) {
+	lo = mid + 1;
+      } else {
+	hi = mid;
+      }
+    }
+    return lo;
+  }
+
+  size_t LSE_Footer::find( unsigned long long ofst ) const
+  {
+    // the last block starting at or before the offset
+    size_t lo( 0 ), hi( blocks.size() );
+    while ( lo < hi ) {
+      size_t mid = lo + ( hi - lo ) / 2;
+      if ( blocks[mid].offset <= ofst ) {
+	lo = mid + 1;
+      } else {
+	hi = mid;
+      }
+    }
+    if ( lo == 0 || ofst >= blocks[lo-1].offset + blocks[lo-1].length ) {
+      return blocks.size();
+    }
+    return lo - 1;
+  }
+
+}
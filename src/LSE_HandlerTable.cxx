@@ -0,0 +1,172 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <cstring>
+
+#include <sstream>
+#include <stdexcept>
+
+#include "eventFile/LSE_Info.h"
+#include "eventFile/LPA_Handler.h"
+
+#include "LSE_HandlerTable.h"
+
+namespace eventFile {
+
+  // size of the part of LPA_Info that LPA_Info::write() dumps as a block
+  static const size_t LPA_FIXED_SIZE = sizeof( LPA_Info ) - sizeof( std::vector< LPA_Handler > );
+
+  // the compact handler: table index, has flag, state, prescaler, RSD
+  static const size_t RSD_SIZE = sizeof( RsdUnion );
+  const size_t LSE_HandlerTable::COMPACT_SIZE = sizeof( uint16_t ) + 1 + 2 * sizeof( int32_t ) + RSD_SIZE;
+
+  static inline uint32_t word( const unsigned char* p )
+  {
+    uint32_t w;
+    memcpy( &w, p, sizeof w );
+    return w;
+  }
+
+  static inline void append( std::vector< unsigned char >& rec, const void* buf, size_t len )
+  {
+    const unsigned char* p = static_cast< const unsigned char* >( buf );
+    rec.insert( rec.end(), p, p + len );
+  }
+
+  // throw unless the record body holds need bytes, for the given part of it
+  static void checkRoom( size_t need, size_t len, const char* what )
+  {
+    if ( need > len ) {
+      std::ostringstream ess;
+      ess << "LSE_HandlerTable::expand: " << what << " needs " << need;
+      ess << " bytes of a " << len << "-byte record";
+      throw std::runtime_error( ess.str() );
+    }
+  }
+
+  bool LSE_HandlerConfigLess::operator()( const LSE_HandlerConfig& a, const LSE_HandlerConfig& b ) const
+  {
+    if ( a.type != b.type ) return a.type < b.type;
+    if ( a.masterKey != b.masterKey ) return a.masterKey < b.masterKey;
+    if ( a.cfgKey != b.cfgKey ) return a.cfgKey < b.cfgKey;
+    if ( a.cfgId != b.cfgId ) return a.cfgId < b.cfgId;
+    if ( a.version != b.version ) return a.version < b.version;
+    return a.id < b.id;
+  }
+
+  LSE_HandlerTable::LSE_HandlerTable() :
+    m_configs(), m_lookup()
+  {
+  }
+
+  LSE_HandlerTable::LSE_HandlerTable( const std::vector< LSE_HandlerConfig >& configs ) :
+    m_configs( configs ), m_lookup()
+  {
+  }
+
+  void LSE_HandlerTable::write( const LPA_Info& info, std::vector< unsigned char >& rec )
+  {
+    // the object type id, the "fixed" part of the structure and the handler count
+    int itype = LSE_Info::LPA;
+    append( rec, &itype, sizeof( int ) );
+    append( rec, &info, LPA_FIXED_SIZE );
+    unsigned nhandlers = info.handlers.size();
+    append( rec, &nhandlers, sizeof( unsigned ) );
+
+    for ( unsigned i = 0; i < nhandlers; ++i ) {
+      const LPA_Handler& h = info.handlers[i];
+
+      // find or add the handler's configuration
+      LSE_HandlerConfig cfg;
+      cfg.type      = h.type;
+      cfg.masterKey = h.masterKey;
+      cfg.cfgKey    = h.cfgKey;
+      cfg.cfgId     = h.cfgId;
+      cfg.version   = h.version;
+      cfg.id        = h.id;
+      std::map< LSE_HandlerConfig, unsigned, LSE_HandlerConfigLess >::iterator it = m_lookup.find( cfg );
+      if ( it == m_lookup.end() ) {
+	if ( m_configs.size() > 0xFFFF ) {
+	  std::ostringstream ess;
+	  ess << "LSE_HandlerTable::write: more than " << 0x10000 << " handler configurations";
+	  throw std::runtime_error( ess.str() );
+	}
+	it = m_lookup.insert( std::make_pair( cfg, static_cast< unsigned >( m_configs.size() ) ) ).first;
+	m_configs.push_back( cfg );
+      }
+
+      // and store the per-event fields against it
+      uint16_t index = it->second;
+      unsigned char has = h.has ? 1 : 0;
+      int32_t state = h.state;
+      int32_t prescaler = h.prescaler;
+      append( rec, &index, sizeof( index ) );
+      append( rec, &has, 1 );
+      append( rec, &state, sizeof( state ) );
+      append( rec, &prescaler, sizeof( prescaler ) );
+      append( rec, &h.rsd, RSD_SIZE );
+    }
+  }
+
+  void LSE_HandlerTable::expand( const unsigned char* body, size_t len, std::vector< unsigned char >& out ) const
+  {
+    // only LPA meta-info is different from the canonical layout
+    checkRoom( sizeof( uint32_t ), len, "the EBF length" );
+    size_t pos = sizeof( uint32_t ) + static_cast< size_t >( word( body ) );
+    checkRoom( pos + sizeof( int ), len, "the meta-info type" );
+    int itype = static_cast< int >( word( body + pos ) );
+    pos += sizeof( int );
+    if ( itype != LSE_Info::LPA ) {
+      out.insert( out.end(), body, body + len );
+      return;
+    }
+
+    // everything up to the handlers as it is
+    checkRoom( pos + LPA_FIXED_SIZE + sizeof( unsigned ), len, "the LPA_Info" );
+    unsigned nhandlers = word( body + pos + LPA_FIXED_SIZE );
+    pos += LPA_FIXED_SIZE + sizeof( unsigned );
+    if ( nhandlers > ( len - pos ) / COMPACT_SIZE ) {
+      std::ostringstream ess;
+      ess << "LSE_HandlerTable::expand: " << nhandlers << " handlers do not fit in the ";
+      ess << len - pos << " bytes left of the record";
+      throw std::runtime_error( ess.str() );
+    }
+    out.insert( out.end(), body, body + pos );
+
+    // the handlers rebuilt in place
+    size_t at = out.size();
+    out.resize( at + nhandlers * sizeof( LPA_Handler ) );
+    for ( unsigned i = 0; i < nhandlers; ++i, pos += COMPACT_SIZE ) {
+      const unsigned char* p = body + pos;
+      uint16_t index;
+      int32_t state, prescaler;
+      memcpy( &index, p, sizeof( index ) );
+      memcpy( &state, p + sizeof( index ) + 1, sizeof( state ) );
+      memcpy( &prescaler, p + sizeof( index ) + 1 + sizeof( state ), sizeof( prescaler ) );
+      if ( index >= m_configs.size() ) {
+	std::ostringstream ess;
+	ess << "LSE_HandlerTable::expand: handler config " << index << " not in the table of ";
+	ess << m_configs.size();
+	throw std::runtime_error( ess.str() );
+      }
+      const LSE_HandlerConfig& cfg = m_configs[index];
+
+      LPA_Handler h;
+      memset( static_cast< void* >( &h ), 0, sizeof( LPA_Handler ) );
+      h.type      = static_cast< LPA_Handler::HandlerType >( cfg.type );
+      h.masterKey = cfg.masterKey;
+      h.cfgKey    = cfg.cfgKey;
+      h.cfgId     = cfg.cfgId;
+      h.state     = static_cast< LPA_Handler::RsdState >( state );
+      h.prescaler = static_cast< LPA_Handler::LeakedPrescaler >( prescaler );
+      h.version   = cfg.version;
+      h.id        = static_cast< LPA_Handler::HandlerId >( cfg.id );
+      h.has       = p[sizeof( index )] != 0;
+      memcpy( &h.rsd, p + COMPACT_SIZE - RSD_SIZE, RSD_SIZE );
+      memcpy( &out[at + i * sizeof( LPA_Handler )], &h, sizeof( LPA_Handler ) );
+    }
+
+    // and the keys behind them
+    out.insert( out.end(), body + pos, body + len );
+  }
+
+}
@@ -0,0 +1,60 @@
+// -*- mode: c++ -*-
+/** @file LSE_HandlerTable.h
+ *  @brief Defines class LSE_HandlerTable, the handler encoding of HANDLER_TABLE event files
+ */
+
+#ifndef EVENTFILE_LSE_HANDLERTABLE_H
+#define EVENTFILE_LSE_HANDLERTABLE_H
+
+#include <stddef.h>
+
+#include <map>
+#include <vector>
+
+#include "eventFile/LSE_Footer.h"
+
+namespace eventFile {
+
+  struct LPA_Info;
+
+  /// ordering of configurations for the writer's lookup
+  struct LSE_HandlerConfigLess {
+    bool operator()( const LSE_HandlerConfig& a, const LSE_HandlerConfig& b ) const;
+  };
+
+  /**
+   * @brief Stores LPA handlers as references to a table of configurations
+   *
+   * The type, master/config keys, config id, RSD version and handler id of
+   * an LPA_Handler stay fixed for a run or mode, so the writer collects the
+   * distinct combinations in a table that goes into the file footer once.
+   * Each handler of a record is then COMPACT_SIZE bytes: the 16-bit table
+   * index, the has flag (one byte), state and prescaler (32 bits each) and
+   * the raw RSD union.  Everything else in the record is unchanged.
+   */
+  class LSE_HandlerTable {
+  public:
+    static const size_t COMPACT_SIZE;
+
+    /// an empty table, for writing
+    LSE_HandlerTable();
+
+    /// the table read from a footer, for reading
+    explicit LSE_HandlerTable( const std::vector< LSE_HandlerConfig >& configs );
+
+    const std::vector< LSE_HandlerConfig >& configs() const { return m_configs; };
+
+    /// append the meta-info typeid and the compact form of the LPA meta-info
+    void write( const LPA_Info& info, std::vector< unsigned char >& rec );
+
+    /// append the canonical form of a record body (EBF length word onwards)
+    void expand( const unsigned char* body, size_t len, std::vector< unsigned char >& out ) const;
+
+  private:
+    std::vector< LSE_HandlerConfig > m_configs;
+    std::map< LSE_HandlerConfig, unsigned, LSE_HandlerConfigLess > m_lookup;
+  };
+
+}
+
+#endif // EVENTFILE_LSE_HANDLERTABLE_H
@@ -0,0 +1,116 @@
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef HAVE_FACILITIES
+#include "facilities/Util.h"
+#endif
+
+#include "eventFile/LSE_Index.h"
+
+namespace eventFile {
+
+  LSE_IndexHeader::LSE_IndexHeader() :
+    marker( LSE_INDEX_MARKER ), version( LSE_INDEX_VERSION ),
+    entrysize( sizeof( LSE_IndexEntry ) ), runid( 0 ), count( 0 )
+  {
+  }
+
+  void LSE_IndexHeader::read( FILE* fp, const std::string& name )
+  {
+    size_t nitems = fread( this, sizeof( LSE_IndexHeader ), 1, fp );
+    if ( nitems != 1 ) {
+      std::ostringstream ess;
+      ess << "LSE_IndexHeader::read: error reading header from " << name;
+      ess << " (" << errno << "=" << strerror( errno ) << ")";
+      throw std::runtime_error( ess.str() );
+    }
+
+    // check the marker, version and entry layout
+    if ( marker != LSE_INDEX_MARKER ) {
+      std::ostringstream ess;
+      ess << "LSE_IndexHeader::read: " << name << " is not an LSE index";
+      throw std::runtime_error( ess.str() );
+    }
+    if ( version != LSE_INDEX_VERSION || entrysize != sizeof( LSE_IndexEntry ) ) {
+      std::ostringstream ess;
+      ess << "LSE_IndexHeader::read: unsupported index format in " << name;
+      ess << ", file is v" << version << " with " << entrysize << "-byte entries";
+      throw std::runtime_error( ess.str() );
+    }
+  }
+
+  void LSE_IndexHeader::write( FILE* fp, const std::string& name )
+  {
+    size_t nitems = fwrite( this, sizeof( LSE_IndexHeader ), 1, fp );
+    if ( nitems != 1 ) {
+      std::ostringstream ess;
+      ess << "LSE_IndexHeader::write: error writing header to " << name;
+      ess << " (" << errno << "=" << strerror( errno ) << ")";
+      throw std::runtime_error( ess.str() );
+    }
+  }
+
+  LSE_Index::LSE_Index( const std::string& filename )
+    : m_name( filename ), m_hdr(), m_entries()
+  {
+#ifdef HAVE_FACILITIES
+    // expand any environment variables in the filename
+    facilities::Util::expandEnvVar( &m_name );
+#endif
+
+    FILE* fp = fopen( m_name.c_str(), "rb" );
+    if ( fp == NULL ) {
+      std::ostringstream ess;
+      ess << "LSE_Index::LSE_Index: error opening " << m_name;
+      ess << " (" << errno << "=" << strerror( errno ) << ")";
+      throw std::runtime_error( ess.str() );
+    }
+
+    try {
+      m_hdr.read( fp, m_name );
+
+      // pull in all the entries with one read
+      m_entries.resize( m_hdr.count );
+      if ( m_hdr.count > 0 ) {
+	size_t nitems = fread( &m_entries[0], sizeof( LSE_IndexEntry ), m_entries.size(), fp );
+	if ( nitems != m_entries.size() ) {
+	  std::ostringstream ess;
+	  ess << "LSE_Index::LSE_Index: " << m_name << " truncated, read " << nitems;
+	  ess << " of " << m_hdr.count << " entries";
+	  throw std::runtime_error( ess.str() );
+	}
+      }
+    } catch ( std::runtime_error& ) {
+      fclose( fp );
+      throw;
+    }
+    fclose( fp );
+  }
+
+  // orderings for the binary searches
+  static bool bySequence( const LSE_IndexEntry& e, unsigned long long seq )
+  {
+    return e.sequence < seq;
+  }
+
+  static bool byTime( const LSE_IndexEntry& e, unsigned secs )
+  {
+    return e.timeSecs < secs;
+  }
+
+  size_t LSE_Index::lowerSequence( unsigned long long seq ) const
+  {
+    return std::lower_bound( m_entries.begin(), m_entries.end(), seq, bySequence ) - m_entries.begin();
+  }
+
+  size_t LSE_Index::lowerTime( unsigned secs ) const
+  {
+    return std::lower_bound( m_entries.begin(), m_entries.end(), secs, byTime ) - m_entries.begin();
+  }
+
+}
@@ -0,0 +1,260 @@
+// decompression relies on zlib, POSIX threads and pread()
+#if defined( HAVE_ZLIB ) && !defined( WIN32 )
+
+#include <errno.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <cstring>
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+#include <zlib.h>
+
+#include "eventFile/LSE_Footer.h"
+
+#include "LSE_Inflater.h"
+
+namespace eventFile {
+
+  // wall-clock seconds, for the stall accounting
+  static double now()
+  {
+    struct timeval tv;
+    gettimeofday( &tv, NULL );
+    return tv.tv_sec + 1.0e-6 * tv.tv_usec;
+  }
+
+  LSE_Inflater::LSE_Inflater( int fd, const LSE_Footer& footer, unsigned depth, unsigned nworkers ) :
+    m_fd( fd ), m_footer( footer ), m_slots(), m_next( 0 ), m_take( 0 ), m_skip( 0 ),
+    m_held( false ), m_stop( false ), m_generation( 0 ), m_threads(), m_stats()
+  {
+    if ( m_footer.frames.size() != m_footer.blocks.size() ) {
+      std::ostringstream ess;
+      ess << "LSE_Inflater::LSE_Inflater: footer lists " << m_footer.frames.size();
+      ess << " frames for " << m_footer.blocks.size() << " blocks";
+      throw std::runtime_error( ess.str() );
+    }
+
+    // one block is held by the consumer, so each worker needs a slot of its own
+    if ( nworkers < 1 ) nworkers = 1;
+    if ( depth < nworkers + 1 ) depth = nworkers + 1;
+    m_slots.resize( depth );
+    for ( unsigned i = 0; i < depth; ++i ) {
+      m_slots[i].block = 0;
+      m_slots[i].state = EMPTY;
+      m_slots[i].err   = 0;
+    }
+
+    pthread_mutex_init( &m_mutex, NULL );
+    pthread_cond_init( &m_filled, NULL );
+    pthread_cond_init( &m_freed, NULL );
+
+    for ( unsigned i = 0; i < nworkers; ++i ) {
+      pthread_t thread;
+      int err = pthread_create( &thread, NULL, &LSE_Inflater::run, this );
+      if ( err != 0 ) {
+	shutdown();
+	std::ostringstream ess;
+	ess << "LSE_Inflater::LSE_Inflater: error starting worker thread";
+	ess << " (" << err << "=" << strerror( err ) << ")";
+	throw std::runtime_error( ess.str() );
+      }
+      m_threads.push_back( thread );
+    }
+  }
+
+  LSE_Inflater::~LSE_Inflater()
+  {
+    shutdown();
+  }
+
+  void LSE_Inflater::shutdown()
+  {
+    pthread_mutex_lock( &m_mutex );
+    m_stop = true;
+    pthread_cond_broadcast( &m_freed );
+    pthread_mutex_unlock( &m_mutex );
+    for ( size_t i = 0; i < m_threads.size(); ++i ) {
+      pthread_join( m_threads[i], NULL );
+    }
+    m_threads.clear();
+
+    pthread_cond_destroy( &m_freed );
+    pthread_cond_destroy( &m_filled );
+    pthread_mutex_destroy( &m_mutex );
+  }
+
+  void* LSE_Inflater::run( void* arg )
+  {
+    static_cast< LSE_Inflater* >( arg )->loop();
+    return NULL;
+  }
+
+  void LSE_Inflater::loop()
+  {
+    pthread_mutex_lock( &m_mutex );
+    while ( !m_stop ) {
+
+      // claim the next block once its slot in the ring is free
+      size_t block = m_next;
+      Slot& slot = m_slots[ block % m_slots.size() ];
+      if ( block >= m_footer.blocks.size() || slot.state != EMPTY ) {
+	pthread_cond_wait( &m_freed, &m_mutex );
+	continue;
+      }
+      slot.state = FILLING;
+      slot.block = block;
+      m_next++;
+      unsigned generation = m_generation;
+      pthread_mutex_unlock( &m_mutex );
+
+      int err = inflate( slot, block );
+
+      pthread_mutex_lock( &m_mutex );
+
+      // a restart while we were working makes this block useless
+      if ( generation != m_generation ) {
+	slot.state = EMPTY;
+	pthread_cond_broadcast( &m_freed );
+	continue;
+      }
+
+      slot.err = err;
+      slot.state = FULL;
+      if ( err == 0 ) {
+	m_stats.chunks++;
+	m_stats.bytes += slot.data.size();
+      }
+      pthread_cond_broadcast( &m_filled );
+    }
+    pthread_mutex_unlock( &m_mutex );
+  }
+
+  int LSE_Inflater::inflate( Slot& slot, size_t block )
+  {
+    // a frame runs up to the next one, or to the footer
+    unsigned long long begin = m_footer.frames[block];
+    unsigned long long end = ( block + 1 < m_footer.frames.size() ) ? m_footer.frames[block+1] : m_footer.offset;
+    if ( end < begin + 2 * sizeof( uint32_t ) ) return -1;
+    size_t flen = end - begin;
+    slot.frame.resize( flen );
+
+    size_t len(0);
+    while ( len < flen ) {
+      ssize_t n = pread( m_fd, &slot.frame[len], flen - len, begin + len );
+      if ( n < 0 ) {
+	if ( errno == EINTR ) continue;
+	return errno;
+      }
+      if ( n == 0 ) return -1;
+      len += n;
+    }
+
+    // the raw and deflated lengths, then the zlib stream
+    uint32_t lens[2];
+    memcpy( lens, &slot.frame[0], sizeof( lens ) );
+    if ( lens[0] != m_footer.blocks[block].length || lens[1] > flen - sizeof( lens ) ) return -1;
+    slot.data.resize( lens[0] );
+    uLongf rawlen = lens[0];
+    if ( uncompress( &slot.data[0], &rawlen, &slot.frame[sizeof( lens )], lens[1] ) != Z_OK ||
+	 rawlen != lens[0] ) {
+      return -1;
+    }
+    return 0;
+  }
+
+  void LSE_Inflater::release()
+  {
+    // caller holds the mutex
+    if ( m_held ) {
+      m_slots[ ( m_take - 1 ) % m_slots.size() ].state = EMPTY;
+      m_held = false;
+      pthread_cond_broadcast( &m_freed );
+    }
+  }
+
+  bool LSE_Inflater::next( const unsigned char*& data, size_t& len )
+  {
+    pthread_mutex_lock( &m_mutex );
+    release();
+    if ( m_take >= m_footer.blocks.size() ) {
+      pthread_mutex_unlock( &m_mutex );
+      return false;
+    }
+
+    // wait for the workers if they haven't kept up
+    Slot& slot = m_slots[ m_take % m_slots.size() ];
+    if ( slot.state != FULL || slot.block != m_take ) {
+      double t0 = now();
+      while ( slot.state != FULL || slot.block != m_take ) {
+	pthread_cond_wait( &m_filled, &m_mutex );
+      }
+      m_stats.stalls++;
+      m_stats.stallTime += now() - t0;
+    }
+
+    if ( slot.err ) {
+      int err = slot.err;
+      size_t block = m_take;
+      pthread_mutex_unlock( &m_mutex );
+      std::ostringstream ess;
+      ess << "LSE_Inflater::next: error inflating block " << block;
+      if ( err > 0 ) {
+	ess << " (" << err << "=" << strerror( err ) << ")";
+      } else {
+	ess << " (corrupt frame)";
+      }
+      throw std::runtime_error( ess.str() );
+    }
+
+    size_t skip = std::min( m_skip, slot.data.size() );
+    data = slot.data.empty() ? NULL : &slot.data[0] + skip;
+    len  = slot.data.size() - skip;
+    m_skip = 0;
+    m_take++;
+    m_held = true;
+    pthread_mutex_unlock( &m_mutex );
+    return true;
+  }
+
+  void LSE_Inflater::restart( off_t ofst )
+  {
+    pthread_mutex_lock( &m_mutex );
+    for ( size_t i = 0; i < m_slots.size(); ++i ) {
+      if ( m_slots[i].state == FULL ) {
+	m_slots[i].state = EMPTY;
+      }
+    }
+    m_held = false;
+
+    // continue from the block holding the offset; anything before the
+    // first event starts with it
+    const std::vector< LSE_BlockInfo >& blocks = m_footer.blocks;
+    unsigned long long pos = ofst;
+    size_t block = m_footer.find( pos );
+    m_skip = 0;
+    if ( block < blocks.size() ) {
+      m_skip = pos - blocks[block].offset;
+    } else if ( !blocks.empty() && pos < blocks[0].offset ) {
+      block = 0;
+    }
+    m_take = m_next = block;
+    m_generation++;
+    pthread_cond_broadcast( &m_freed );
+    pthread_mutex_unlock( &m_mutex );
+  }
+
+  LSEReader::PrefetchStats LSE_Inflater::stats() const
+  {
+    pthread_mutex_lock( &m_mutex );
+    LSEReader::PrefetchStats s( m_stats );
+    pthread_mutex_unlock( &m_mutex );
+    return s;
+  }
+
+}
+
+#endif // HAVE_ZLIB && !WIN32
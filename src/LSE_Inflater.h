@@ -0,0 +1,80 @@
+// -*- mode: c++ -*-
+/** @file LSE_Inflater.h
+ *  @brief Defines class LSE_Inflater, the decompressing chunk source for COMPRESSED event files
+ */
+
+#ifndef EVENTFILE_LSE_INFLATER_H
+#define EVENTFILE_LSE_INFLATER_H
+
+#include <sys/types.h>
+#include <pthread.h>
+
+#include <vector>
+
+#include "LSE_ChunkSource.h"
+
+namespace eventFile {
+
+  struct LSE_Footer;
+
+  /**
+   * @brief Inflates the blocks of a compressed file ahead of its consumer
+   *
+   * Each chunk handed out is one block of records, decompressed.  A pool of
+   * worker threads reads and inflates the frames of the next blocks in
+   * parallel while the consumer works through the block it holds, so
+   * decompression overlaps with consumption.  Offsets are positions in the
+   * uncompressed event stream, as recorded in the footer; after restart()
+   * the first chunk begins at the requested offset within its block.  Only
+   * one consumer thread may use the object, and the footer must outlive it.
+   */
+  class LSE_Inflater : public LSE_ChunkSource {
+  public:
+    LSE_Inflater( int fd, const LSE_Footer& footer, unsigned depth, unsigned nworkers );
+    ~LSE_Inflater();
+
+    bool next( const unsigned char*& data, size_t& len );
+    void restart( off_t ofst );
+    LSEReader::PrefetchStats stats() const;
+
+  private:
+    enum SlotState { EMPTY, FILLING, FULL };
+    struct Slot {
+      std::vector< unsigned char > frame;  // the compressed frame as read
+      std::vector< unsigned char > data;   // the inflated block
+      size_t    block;
+      SlotState state;
+      int       err;       // errno, or -1 for a corrupt frame
+    };
+
+    int                 m_fd;
+    const LSE_Footer&   m_footer;
+    std::vector<Slot>   m_slots;
+    size_t              m_next;      // next block a worker will claim
+    size_t              m_take;      // next block the consumer will take
+    size_t              m_skip;      // bytes to skip in the first block after a restart
+    bool                m_held;      // consumer holds the slot of block m_take-1
+    bool                m_stop;
+    unsigned            m_generation;
+
+    std::vector<pthread_t> m_threads;
+    mutable pthread_mutex_t m_mutex;
+    pthread_cond_t      m_filled;
+    pthread_cond_t      m_freed;
+
+    LSEReader::PrefetchStats m_stats;
+
+    static void* run( void* );
+    void loop();
+    void release();
+    int inflate( Slot&, size_t block );
+    void shutdown();
+
+    // not copyable
+    LSE_Inflater( const LSE_Inflater& );
+    LSE_Inflater& operator=( const LSE_Inflater& );
+  };
+
+}
+
+#endif // EVENTFILE_LSE_INFLATER_H
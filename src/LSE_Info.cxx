@@ -33,51 +33,27 @@ namespace eventFile {
     }
   }
 
-  void LPA_Info::write( FILE* fp ) const
+  void LPA_Info::write( std::vector< unsigned char >& rec ) const
   {
-    // write the object type id to the file
-    size_t nitems(0);
+    // append the object type id to the record
     int itype = LSE_Info::LPA;
-    nitems = fwrite( &itype, sizeof( int ), 1, fp );
-    if ( nitems != 1 ) {
-      std::ostringstream ess;
-      ess << "LPA_Info::write: error writing LPA_Info typeid ";
-      ess << " (" << errno << "=" << strerror( errno ) << ")";
-      throw std::runtime_error( ess.str() );
-    }
+    const unsigned char* p = reinterpret_cast< const unsigned char* >( &itype );
+    rec.insert( rec.end(), p, p + sizeof( int ) );
 
-    // write the "fixed" part of the structure to the file
+    // append the "fixed" part of the structure
     size_t fixedsize = sizeof( LPA_Info ) - sizeof( std::vector< LPA_Handler > );
-    nitems = fwrite( this, fixedsize, 1, fp );
-    if ( nitems != 1 ) {
-      std::ostringstream ess;
-      ess << "LPA_Info::write: error writing fixed LPA_Info content ";
-      ess << " (" << errno << "=" << strerror( errno ) << ")";
-      throw std::runtime_error( ess.str() );
-    }
+    p = reinterpret_cast< const unsigned char* >( this );
+    rec.insert( rec.end(), p, p + fixedsize );
 
-    // write the number of LPA_Handler instances to the file
+    // append the number of LPA_Handler instances
     unsigned nhandlers = handlers.size();
-    nitems = fwrite( &nhandlers, sizeof( unsigned ), 1, fp );
-    if ( nitems != 1 ) {
-      std::ostringstream ess;
-      ess << "LSEWriter::write: error writing LPA_Info nhandlers  ";
-      ess << " (" << errno << "=" << strerror( errno ) << ")";
-      throw std::runtime_error( ess.str() );
-    }
+    p = reinterpret_cast< const unsigned char* >( &nhandlers );
+    rec.insert( rec.end(), p, p + sizeof( unsigned ) );
 
-    // if there are no handlers, then we're done
-    if ( nhandlers == 0 ) {
-      return;
-    }
-
-    // write each LPA_Handler to the file
-    nitems = fwrite( &(handlers[0]), nhandlers * sizeof( LPA_Handler ), 1, fp );
-    if ( nitems != 1 ) {
-      std::ostringstream ess;
-      ess << "LPA_Info::write: error writing LPA_Handler content ";
-      ess << " (" << errno << "=" << strerror( errno ) << ")";
-      throw std::runtime_error( ess.str() );
+    // append each LPA_Handler
+    if ( nhandlers > 0 ) {
+      p = reinterpret_cast< const unsigned char* >( &handlers[0] );
+      rec.insert( rec.end(), p, p + nhandlers * sizeof( LPA_Handler ) );
     }
   }
 
@@ -104,13 +80,17 @@ namespace eventFile {
       throw std::runtime_error( ess.str() );
     }
 
+    // reuse the handler storage from the previous event
+    if ( handlers.size() != nhandlers ) {
+      handlers.resize( nhandlers );
+    }
+
     // if there are no handlers, then we're done
     if ( nhandlers == 0 ) {
       return;
     }
 
     // read the handler instances from the file
-    handlers.resize( nhandlers );
     nitems = fread( &(handlers[0]), nhandlers * sizeof( LPA_Handler ), 1, fp );
     if ( nitems != 1 ) {
       std::ostringstream ess;
@@ -0,0 +1,347 @@
+// positional reads rely on pread()
+#ifndef WIN32
+
+#include <errno.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <cstring>
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef HAVE_FACILITIES
+#include "facilities/Util.h"
+#endif
+
+#include "eventFile/LSE_PositionalReader.h"
+#include "eventFile/LSE_Context.h"
+#include "eventFile/LSE_Info.h"
+#include "eventFile/LPA_Handler.h"
+#include "eventFile/EBF_Data.h"
+#include "eventFile/LSE_EventView.h"
+
+#include "LSE_ContextCodec.h"
+#include "LSE_HandlerTable.h"
+
+namespace eventFile {
+
+  // the last serial handed out to a file's contents
+  static unsigned long long s_serial = 0;
+
+  // bytes read behind the EBF payload, enough for the info and keys of most events
+  static const size_t LSE_POSITIONAL_TAIL = 1024;
+
+  LSE_PositionalReader::LSE_PositionalReader( const std::string& filename )
+    : m_name( filename ), m_hdr(), m_meta(), m_FILE( NULL ), m_fd( -1 ), m_start( 0 ), m_end( 0 ),
+      m_footer(), m_htable( NULL ), m_delta( false ), m_serial( 0 ), m_stamp()
+  {
+#ifdef HAVE_FACILITIES
+    // expand any environment variables in the filename
+    facilities::Util::expandEnvVar( &m_name );
+#endif
+
+    open();
+  }
+
+  LSE_PositionalReader::~LSE_PositionalReader()
+  {
+    close();
+    delete m_htable;
+  }
+
+  void LSE_PositionalReader::open()
+  {
+    // open the specified file
+    if ( ( m_FILE = fopen( m_name.c_str(), "rb" ) ) == NULL ) {
+      std::ostringstream ess;
+      ess << "LSE_PositionalReader::open: error opening " << m_name;
+      ess << " (" << errno << "=" << strerror( errno ) << ")";
+      throw std::runtime_error( ess.str() );
+    }
+    m_fd = fileno( m_FILE );
+
+    // the header and footer are read through stdio once, here, and again
+    // only if a reopened file has changed; everything after that is pread()
+    try {
+      struct stat stbuf;
+      if ( fstat( m_fd, &stbuf ) != 0 ) {
+	std::ostringstream ess;
+	ess << "LSE_PositionalReader::open: error getting size of " << m_name;
+	ess << " (" << errno << "=" << strerror( errno ) << ")";
+	throw std::runtime_error( ess.str() );
+      }
+      if ( m_stamp.take( m_fd ) ) return;
+      delete m_htable;
+      m_htable = NULL;
+      m_delta = false;
+      m_footer = LSE_Footer();
+
+      m_serial = __atomic_add_fetch( &s_serial, 1, __ATOMIC_RELAXED );
+      m_hdr.read( m_FILE, m_meta );
+      m_start = ftello( m_FILE );
+      m_end = stbuf.st_size;
+      if ( m_hdr.blocked() ) {
+	m_footer.read( m_FILE, m_name );
+	m_end = m_footer.offset;
+	if ( m_footer.flags & LSE_Footer::COMPRESSED ) {
+	  std::ostringstream ess;
+	  ess << "LSE_PositionalReader::open: " << m_name;
+	  ess << " is compressed; read it with LSEReader";
+	  throw std::runtime_error( ess.str() );
+	}
+	m_delta = ( m_footer.flags & LSE_Footer::CONTEXT_DELTA ) != 0;
+	if ( m_footer.flags & LSE_Footer::HANDLER_TABLE ) {
+	  m_htable = new LSE_HandlerTable( m_footer.handlers );
+	}
+      }
+    } catch ( std::runtime_error& ) {
+      m_stamp.clear();
+      fclose( m_FILE );
+      m_FILE = NULL;
+      m_fd = -1;
+      throw;
+    }
+  }
+
+  void LSE_PositionalReader::close()
+  {
+    if ( m_FILE ) {
+      fclose( m_FILE );
+      m_FILE = NULL;
+      m_fd = -1;
+    }
+  }
+
+  void LSE_PositionalReader::reopen()
+  {
+    if ( !m_FILE ) open();
+  }
+
+  size_t LSE_PositionalReader::measure( const unsigned char* buf, size_t avail ) const
+  {
+    size_t hsize = m_htable ? LSE_HandlerTable::COMPACT_SIZE : sizeof( LPA_Handler );
+    if ( m_delta ) {
+      return LSE_ContextCodec::measure( buf, avail, hsize );
+    }
+    return LSE_EventView::measure( buf, avail, hsize );
+  }
+
+  void LSE_PositionalReader::fill( std::vector< unsigned char >& v, size_t have, size_t need,
+				   unsigned long long ofst ) const
+  {
+    // bring in bytes [have, need) of the span starting at ofst
+    if ( v.size() < need ) v.resize( need );
+    while ( have < need ) {
+      ssize_t n = pread( m_fd, &v[have], need - have, ofst + have );
+      if ( n < 0 ) {
+	if ( errno == EINTR ) continue;
+	std::ostringstream ess;
+	ess << "LSE_PositionalReader::read: error reading " << m_name << " at offset " << ofst + have;
+	ess << " (" << errno << "=" << strerror( errno ) << ")";
+	throw std::runtime_error( ess.str() );
+      }
+      if ( n == 0 ) {
+	std::ostringstream ess;
+	ess << "LSE_PositionalReader::read: " << m_name << " truncated at offset " << ofst + have;
+	throw std::runtime_error( ess.str() );
+      }
+      have += n;
+    }
+  }
+
+  bool LSE_PositionalReader::read( unsigned long long ofst, Buffer& buf, LSE_EventView& view,
+				   unsigned long long* next ) const
+  {
+    if ( ofst < m_start || ofst >= m_end ) return false;
+    std::vector< unsigned char >& st = buf.stored;
+
+    // a context stored as a delta needs the ones before it in its block,
+    // from its start or from the record the buffer holds if it is ahead
+    LSE_ContextCodec codec;
+    if ( m_delta ) {
+      size_t b = m_footer.find( ofst );
+      if ( b == m_footer.blocks.size() ) {
+	std::ostringstream ess;
+	ess << "LSE_PositionalReader::read: offset " << ofst << " is in no block of " << m_name;
+	throw std::runtime_error( ess.str() );
+      }
+      unsigned long long from = m_footer.blocks[b].offset;
+      if ( buf.serial == m_serial && buf.next > from && buf.next <= ofst ) {
+	codec.resume( *reinterpret_cast< const LSE_Context* >( &buf.record[0] ) );
+	from = buf.next;
+      }
+      buf.serial = 0;
+      size_t span = ofst - from;
+      if ( span > 0 ) {
+	fill( st, 0, span, from );
+	LSE_Context ctx;
+	size_t p(0);
+	while ( p < span ) {
+	  size_t len = measure( &st[p], span - p );
+	  if ( len > span - p ) break;
+	  codec.decode( &st[p], len, ctx );
+	  p += len;
+	}
+	if ( p != span ) {
+	  std::ostringstream ess;
+	  ess << "LSE_PositionalReader::read: offset " << ofst << " is not at an event of " << m_name;
+	  throw std::runtime_error( ess.str() );
+	}
+      }
+    }
+
+    // the record itself: the front up to the EBF length, then the payload
+    // together with the info and keys behind it
+    size_t avail = m_end - ofst;
+    size_t have = std::min( avail, measure( NULL, 0 ) );
+    fill( st, 0, have, ofst );
+    size_t need(0);
+    while ( ( need = measure( &st[0], have ) ) > have ) {
+      if ( need > avail ) {
+	std::ostringstream ess;
+	ess << "LSE_PositionalReader::read: truncated event at offset " << ofst << " of " << m_name;
+	throw std::runtime_error( ess.str() );
+      }
+      size_t want = std::min( avail, need + LSE_POSITIONAL_TAIL );
+      fill( st, have, want, ofst );
+      have = want;
+    }
+    const unsigned char* rec = &st[0];
+    size_t len = need;
+
+    // rebuild the canonical record from an encoded one
+    if ( m_delta || m_htable ) {
+      std::vector< unsigned char >& out = buf.record;
+      out.resize( sizeof( LSE_Context ) );
+      size_t used = sizeof( LSE_Context );
+      if ( m_delta ) {
+	used = codec.decode( rec, len, *reinterpret_cast< LSE_Context* >( &out[0] ) );
+      } else {
+	memcpy( &out[0], rec, sizeof( LSE_Context ) );
+      }
+      if ( m_htable ) {
+	m_htable->expand( rec + used, len - used, out );
+      } else {
+	out.insert( out.end(), rec + used, rec + len );
+      }
+      rec = &out[0];
+      len = out.size();
+    }
+
+    view.parse( rec, len );
+    view.bind( &m_meta );
+    if ( m_delta ) {
+      buf.serial = m_serial;
+      buf.next = ofst + need;
+    }
+    if ( next ) *next = ofst + need;
+    return true;
+  }
+
+  bool LSE_PositionalReader::probe( unsigned long long ofst, LSE_Context& ctx, LSE_Info::InfoType& infotype,
+				    LSE_Keys::KeysType& keystype, unsigned long long& next ) const
+  {
+    if ( ofst < m_start || ofst >= m_end ) return false;
+    if ( m_delta ) {
+      std::ostringstream ess;
+      ess << "LSE_PositionalReader::probe: " << m_name << " stores its contexts as deltas";
+      throw std::runtime_error( ess.str() );
+    }
+
+    // the context and the EBF length
+    std::vector< unsigned char > v;
+    const size_t head = sizeof( LSE_Context ) + sizeof( uint32_t );
+    fill( v, 0, head, ofst );
+    memcpy( &ctx, &v[0], sizeof( LSE_Context ) );
+    uint32_t ebflen;
+    memcpy( &ebflen, &v[sizeof( LSE_Context )], sizeof( ebflen ) );
+
+    // measure the rest as a record with an empty EBF payload, reading only
+    // the bytes behind the payload
+    unsigned long long tail = ofst + head + ebflen;
+    if ( tail >= m_end ) {
+      std::ostringstream ess;
+      ess << "LSE_PositionalReader::probe: truncated event at offset " << ofst << " of " << m_name;
+      throw std::runtime_error( ess.str() );
+    }
+    size_t hsize = m_htable ? LSE_HandlerTable::COMPACT_SIZE : sizeof( LPA_Handler );
+    v.assign( sizeof( uint32_t ), 0 );
+    size_t have = sizeof( uint32_t ) + std::min< unsigned long long >( m_end - tail, LSE_POSITIONAL_TAIL );
+    fill( v, sizeof( uint32_t ), have, tail - sizeof( uint32_t ) );
+    size_t need(0);
+    while ( ( need = LSE_EventView::measureBody( &v[0], have, hsize, &infotype, &keystype ) ) > have ) {
+      if ( tail + need - sizeof( uint32_t ) > m_end ) {
+	std::ostringstream ess;
+	ess << "LSE_PositionalReader::probe: truncated event at offset " << ofst << " of " << m_name;
+	throw std::runtime_error( ess.str() );
+      }
+      fill( v, have, need, tail - sizeof( uint32_t ) );
+      have = need;
+    }
+    next = tail + need - sizeof( uint32_t );
+    return true;
+  }
+
+  bool LSE_PositionalReader::willNeed( unsigned long long ofst, unsigned long long len ) const
+  {
+#ifdef POSIX_FADV_WILLNEED
+    if ( m_fd < 0 || ofst >= m_end ) return false;
+    if ( len > m_end - ofst ) len = m_end - ofst;
+    return posix_fadvise( m_fd, ofst, len, POSIX_FADV_WILLNEED ) == 0;
+#else
+    return false;
+#endif
+  }
+
+  bool LSE_PositionalReader::read( unsigned long long ofst, LSE_Context& ctx, EBF_Data& ebf,
+				   LSE_Info::InfoType& infotype, LPA_Info& pinfo, LCI_ACD_Info& ainfo,
+				   LCI_CAL_Info& cinfo, LCI_TKR_Info& tinfo, LSE_Keys::KeysType& ktype,
+				   LPA_Keys& pakeys, LCI_Keys& cikeys, unsigned long long* next ) const
+  {
+    Buffer buf;
+    LSE_EventView view;
+    if ( !read( ofst, buf, view, next ) ) {
+      return false;
+    }
+
+    ctx = view.ctx();
+    view.copy( ebf );
+    infotype = view.infotype();
+    switch ( infotype ) {
+    case LSE_Info::LPA:
+      view.copy( pinfo );
+      break;
+    case LSE_Info::LCI_ACD:
+      view.copy( ainfo );
+      break;
+    case LSE_Info::LCI_CAL:
+      view.copy( cinfo );
+      break;
+    case LSE_Info::LCI_TKR:
+      view.copy( tinfo );
+      break;
+    default:
+      break;
+    }
+
+    ktype = view.keystype();
+    switch ( ktype ) {
+    case LSE_Keys::LPA:
+      view.copy( pakeys );
+      break;
+    case LSE_Keys::LCI:
+      view.copy( cikeys );
+      break;
+    default:
+      break;
+    }
+    return true;
+  }
+
+}
+
+#endif // WIN32
@@ -0,0 +1,206 @@
+// read-ahead relies on POSIX threads and pread()
+#ifndef WIN32
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <cstring>
+
+#include <sstream>
+#include <stdexcept>
+
+#include "LSE_Prefetcher.h"
+
+namespace eventFile {
+
+  // wall-clock seconds, for the stall accounting
+  static double now()
+  {
+    struct timeval tv;
+    gettimeofday( &tv, NULL );
+    return tv.tv_sec + 1.0e-6 * tv.tv_usec;
+  }
+
+  LSE_Prefetcher::LSE_Prefetcher( int fd, off_t start, size_t chunksize, unsigned depth ) :
+    m_fd( fd ), m_chunksize( chunksize ), m_slots(), m_ofst( start ), m_fill( 0 ), m_take( 0 ),
+    m_held( false ), m_eof( false ), m_errno( 0 ), m_stop( false ), m_generation( 0 ), m_stats()
+  {
+    // one chunk is held by the consumer, so at least one more must be in flight
+    if ( depth < 2 ) depth = 2;
+    m_slots.resize( depth );
+    for ( unsigned i = 0; i < depth; ++i ) {
+      m_slots[i].data  = new unsigned char[ m_chunksize ];
+      m_slots[i].len   = 0;
+      m_slots[i].state = EMPTY;
+    }
+
+    pthread_mutex_init( &m_mutex, NULL );
+    pthread_cond_init( &m_filled, NULL );
+    pthread_cond_init( &m_freed, NULL );
+
+    int err = pthread_create( &m_thread, NULL, &LSE_Prefetcher::run, this );
+    if ( err != 0 ) {
+      pthread_cond_destroy( &m_freed );
+      pthread_cond_destroy( &m_filled );
+      pthread_mutex_destroy( &m_mutex );
+      for ( unsigned i = 0; i < depth; ++i ) {
+	delete [] m_slots[i].data;
+      }
+      std::ostringstream ess;
+      ess << "LSE_Prefetcher::LSE_Prefetcher: error starting I/O thread";
+      ess << " (" << err << "=" << strerror( err ) << ")";
+      throw std::runtime_error( ess.str() );
+    }
+  }
+
+  LSE_Prefetcher::~LSE_Prefetcher()
+  {
+    pthread_mutex_lock( &m_mutex );
+    m_stop = true;
+    pthread_cond_broadcast( &m_freed );
+    pthread_mutex_unlock( &m_mutex );
+    pthread_join( m_thread, NULL );
+
+    pthread_cond_destroy( &m_freed );
+    pthread_cond_destroy( &m_filled );
+    pthread_mutex_destroy( &m_mutex );
+    for ( size_t i = 0; i < m_slots.size(); ++i ) {
+      delete [] m_slots[i].data;
+    }
+  }
+
+  void* LSE_Prefetcher::run( void* arg )
+  {
+    static_cast< LSE_Prefetcher* >( arg )->loop();
+    return NULL;
+  }
+
+  void LSE_Prefetcher::loop()
+  {
+    pthread_mutex_lock( &m_mutex );
+    while ( !m_stop ) {
+
+      // wait for the next slot in the ring to be free
+      Slot& slot = m_slots[m_fill];
+      if ( m_eof || m_errno || slot.state != EMPTY ) {
+	pthread_cond_wait( &m_freed, &m_mutex );
+	continue;
+      }
+      slot.state = FILLING;
+      off_t ofst = m_ofst;
+      unsigned generation = m_generation;
+      pthread_mutex_unlock( &m_mutex );
+
+      // fill the chunk, stopping early only at end of file
+      size_t len(0);
+      int err(0);
+      while ( len < m_chunksize ) {
+	ssize_t n = pread( m_fd, slot.data + len, m_chunksize - len, ofst + len );
+	if ( n < 0 ) {
+	  if ( errno == EINTR ) continue;
+	  err = errno;
+	  break;
+	}
+	if ( n == 0 ) break;
+	len += n;
+      }
+
+      pthread_mutex_lock( &m_mutex );
+      slot.state = EMPTY;
+
+      // a restart while we were reading makes this chunk useless
+      if ( generation != m_generation ) continue;
+
+      if ( err ) {
+	m_errno = err;
+      } else if ( len > 0 ) {
+	slot.len = len;
+	slot.state = FULL;
+	m_ofst += len;
+	m_fill = ( m_fill + 1 ) % m_slots.size();
+	m_stats.chunks++;
+	m_stats.bytes += len;
+      }
+      if ( len < m_chunksize ) {
+	m_eof = true;
+      }
+      pthread_cond_signal( &m_filled );
+    }
+    pthread_mutex_unlock( &m_mutex );
+  }
+
+  void LSE_Prefetcher::release()
+  {
+    // caller holds the mutex
+    if ( m_held ) {
+      m_slots[ ( m_take + m_slots.size() - 1 ) % m_slots.size() ].state = EMPTY;
+      m_held = false;
+      pthread_cond_signal( &m_freed );
+    }
+  }
+
+  bool LSE_Prefetcher::next( const unsigned char*& data, size_t& len )
+  {
+    pthread_mutex_lock( &m_mutex );
+    release();
+
+    // wait for the I/O thread if it hasn't kept up
+    Slot& slot = m_slots[m_take];
+    if ( slot.state != FULL && !m_eof && !m_errno ) {
+      double t0 = now();
+      while ( slot.state != FULL && !m_eof && !m_errno ) {
+	pthread_cond_wait( &m_filled, &m_mutex );
+      }
+      m_stats.stalls++;
+      m_stats.stallTime += now() - t0;
+    }
+
+    if ( slot.state != FULL ) {
+      int err = m_errno;
+      pthread_mutex_unlock( &m_mutex );
+      if ( err ) {
+	std::ostringstream ess;
+	ess << "LSE_Prefetcher::next: error reading ahead";
+	ess << " (" << err << "=" << strerror( err ) << ")";
+	throw std::runtime_error( ess.str() );
+      }
+      return false;
+    }
+
+    data = slot.data;
+    len  = slot.len;
+    m_take = ( m_take + 1 ) % m_slots.size();
+    m_held = true;
+    pthread_mutex_unlock( &m_mutex );
+    return true;
+  }
+
+  void LSE_Prefetcher::restart( off_t ofst )
+  {
+    pthread_mutex_lock( &m_mutex );
+    for ( size_t i = 0; i < m_slots.size(); ++i ) {
+      if ( m_slots[i].state == FULL ) {
+	m_slots[i].state = EMPTY;
+      }
+    }
+    m_held = false;
+    m_fill = m_take = 0;
+    m_ofst = ofst;
+    m_eof = false;
+    m_errno = 0;
+    m_generation++;
+    pthread_cond_broadcast( &m_freed );
+    pthread_mutex_unlock( &m_mutex );
+  }
+
+  LSEReader::PrefetchStats LSE_Prefetcher::stats() const
+  {
+    pthread_mutex_lock( &m_mutex );
+    LSEReader::PrefetchStats s( m_stats );
+    pthread_mutex_unlock( &m_mutex );
+    return s;
+  }
+
+}
+
+#endif // WIN32
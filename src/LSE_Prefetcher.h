@@ -0,0 +1,72 @@
+// -*- mode: c++ -*-
+/** @file LSE_Prefetcher.h
+ *  @brief Defines class LSE_Prefetcher, the read-ahead engine behind LSEReader::PREFETCH
+ */
+
+#ifndef EVENTFILE_LSE_PREFETCHER_H
+#define EVENTFILE_LSE_PREFETCHER_H
+
+#include <sys/types.h>
+#include <pthread.h>
+
+#include <vector>
+
+#include "LSE_ChunkSource.h"
+
+namespace eventFile {
+
+  /**
+   * @brief Reads a file ahead of its consumer on a dedicated thread
+   *
+   * The I/O thread fills a ring of fixed-size chunk buffers with consecutive
+   * pread() calls while the consumer works through the chunk it holds.  Only
+   * one consumer thread may use the object.
+   */
+  class LSE_Prefetcher : public LSE_ChunkSource {
+  public:
+    LSE_Prefetcher( int fd, off_t start, size_t chunksize, unsigned depth );
+    ~LSE_Prefetcher();
+
+    bool next( const unsigned char*& data, size_t& len );
+    void restart( off_t ofst );
+    LSEReader::PrefetchStats stats() const;
+
+  private:
+    enum SlotState { EMPTY, FILLING, FULL };
+    struct Slot {
+      unsigned char* data;
+      size_t         len;
+      SlotState      state;
+    };
+
+    int                 m_fd;
+    size_t              m_chunksize;
+    std::vector<Slot>   m_slots;
+    off_t               m_ofst;      // next file offset the I/O thread will read
+    unsigned            m_fill;      // next slot the I/O thread will fill
+    unsigned            m_take;      // next slot the consumer will take
+    bool                m_held;      // consumer holds the slot before m_take
+    bool                m_eof;       // I/O thread reached end of file
+    int                 m_errno;     // error seen by the I/O thread
+    bool                m_stop;
+    unsigned            m_generation;
+
+    pthread_t           m_thread;
+    mutable pthread_mutex_t m_mutex;
+    pthread_cond_t      m_filled;
+    pthread_cond_t      m_freed;
+
+    LSEReader::PrefetchStats m_stats;
+
+    static void* run( void* );
+    void loop();
+    void release();
+
+    // not copyable
+    LSE_Prefetcher( const LSE_Prefetcher& );
+    LSE_Prefetcher& operator=( const LSE_Prefetcher& );
+  };
+
+}
+
+#endif // EVENTFILE_LSE_PREFETCHER_H
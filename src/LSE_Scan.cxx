@@ -0,0 +1,259 @@
+// the parallel scan relies on POSIX threads
+#ifndef WIN32
+
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <cstring>
+
+#include <exception>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "eventFile/LSE_Scan.h"
+#include "eventFile/LSE_EventView.h"
+#include "eventFile/LSE_Context.h"
+#include "eventFile/LSE_Index.h"
+#include "eventFile/LSE_Footer.h"
+
+namespace eventFile {
+
+  // an event-aligned slice of the file
+  struct LSE_ScanRange {
+    unsigned long long begin;   // offset of the first event
+    unsigned long long count;   // number of events
+  };
+
+  // state shared by all the workers of one scan
+  struct LSE_ScanShared {
+    pthread_mutex_t mutex;
+    bool            stop;
+    std::string     error;
+  };
+
+  // one worker thread and its reader
+  struct LSE_ScanWorker {
+    unsigned           id;
+    LSEReader*         reader;
+    LSE_ScanRange      range;
+    LSE_EventVisitor*  visitor;
+    LSE_ScanShared*    shared;
+    unsigned long long visited;
+    pthread_t          thread;
+  };
+
+  // first index entry at or beyond a file offset
+  static size_t lowerOffset( const LSE_Index& idx, unsigned long long ofst )
+  {
+    size_t lo( 0 ), hi( idx.size() );
+    while ( lo < hi ) {
+      size_t mid = lo + ( hi - lo ) / 2;
+      if ( idx[mid].offset < ofst ) {
+	lo = mid + 1;
+      } else {
+	hi = mid;
+      }
+    }
+    return lo;
+  }
+
+  // split the events into at most n ranges of roughly equal size in bytes
+  static void partition( LSEReader& probe, const std::string& filename, unsigned n,
+			 std::vector< LSE_ScanRange >& ranges )
+  {
+    ranges.clear();
+    LSE_ScanRange r;
+
+    // use the index when there is one
+    if ( probe.loadIndex() ) {
+      const LSE_Index& idx = *probe.index();
+      if ( idx.empty() ) return;
+      unsigned long long first = idx[0].offset;
+      unsigned long long total = idx[idx.size()-1].offset + idx[idx.size()-1].length - first;
+      size_t ibeg( 0 );
+      for ( unsigned k = 1; k <= n; ++k ) {
+	size_t iend = ( k == n ) ? idx.size() : lowerOffset( idx, first + total * k / n );
+	if ( iend > ibeg ) {
+	  r.begin = idx[ibeg].offset;
+	  r.count = iend - ibeg;
+	  ranges.push_back( r );
+	  ibeg = iend;
+	}
+      }
+      return;
+    }
+
+    // or whole blocks from the footer of a blocked file
+    if ( probe.footer() ) {
+      const std::vector< LSE_BlockInfo >& blocks = probe.footer()->blocks;
+      if ( blocks.empty() ) return;
+      unsigned long long first = blocks[0].offset;
+      unsigned long long total = blocks.back().offset + blocks.back().length - first;
+      unsigned k = 1;
+      r.begin = first;
+      r.count = 0;
+      for ( size_t i = 0; i < blocks.size(); ++i ) {
+	if ( k < n && r.count > 0 && blocks[i].offset >= first + total * k / n ) {
+	  ranges.push_back( r );
+	  r.begin = blocks[i].offset;
+	  r.count = 0;
+	  while ( k < n && blocks[i].offset >= first + total * k / n ) ++k;
+	}
+	r.count += blocks[i].nevents;
+      }
+      if ( r.count > 0 ) {
+	ranges.push_back( r );
+      }
+      return;
+    }
+
+    // otherwise walk the record lengths of a mapped copy of the file
+    struct stat stbuf;
+    if ( stat( filename.c_str(), &stbuf ) != 0 ) {
+      std::ostringstream ess;
+      ess << "forEachEvent: error getting size of " << filename;
+      ess << " (" << errno << "=" << strerror( errno ) << ")";
+      throw std::runtime_error( ess.str() );
+    }
+    LSEReader scan( filename, LSEReader::MMAP );
+    unsigned long long first = scan.dataOffset();
+    unsigned long long total = stbuf.st_size - first;
+    unsigned long long ofst = first;
+    unsigned k = 1;
+    r.begin = first;
+    r.count = 0;
+    LSE_EventView view;
+    while ( scan.read( view ) ) {
+      if ( k < n && r.count > 0 && ofst >= first + total * k / n ) {
+	ranges.push_back( r );
+	r.begin = ofst;
+	r.count = 0;
+	while ( k < n && ofst >= first + total * k / n ) ++k;
+      }
+      r.count++;
+      ofst += view.size();
+    }
+    if ( r.count > 0 ) {
+      ranges.push_back( r );
+    }
+  }
+
+  static void* runWorker( void* arg )
+  {
+    LSE_ScanWorker& w = *static_cast< LSE_ScanWorker* >( arg );
+    try {
+      if ( w.reader->seek( w.range.begin ) != 0 ) {
+	std::ostringstream ess;
+	ess << "forEachEvent: error seeking to " << w.range.begin;
+	throw std::runtime_error( ess.str() );
+      }
+      LSE_EventView view;
+      for ( unsigned long long i = 0; i < w.range.count; ++i ) {
+
+	// look for a failure on another worker now and then
+	if ( ( i & 0xFF ) == 0 ) {
+	  pthread_mutex_lock( &w.shared->mutex );
+	  bool stop = w.shared->stop;
+	  pthread_mutex_unlock( &w.shared->mutex );
+	  if ( stop ) break;
+	}
+
+	if ( !w.reader->read( view ) ) {
+	  std::ostringstream ess;
+	  ess << "forEachEvent: unexpected end of file after " << w.visited;
+	  ess << " events of the range at " << w.range.begin;
+	  throw std::runtime_error( ess.str() );
+	}
+	w.visitor->visit( view, w.id );
+	w.visited++;
+      }
+    } catch ( std::exception& e ) {
+      pthread_mutex_lock( &w.shared->mutex );
+      if ( !w.shared->stop ) w.shared->error = e.what();
+      w.shared->stop = true;
+      pthread_mutex_unlock( &w.shared->mutex );
+    } catch ( ... ) {
+      pthread_mutex_lock( &w.shared->mutex );
+      if ( !w.shared->stop ) w.shared->error = "forEachEvent: unknown exception in visitor";
+      w.shared->stop = true;
+      pthread_mutex_unlock( &w.shared->mutex );
+    }
+    return NULL;
+  }
+
+  unsigned long long forEachEvent( const std::string& filename, unsigned nthreads,
+				   LSE_EventVisitor& visitor, LSEReader::IOMode mode )
+  {
+    if ( nthreads == 0 ) {
+      long ncpu = sysconf( _SC_NPROCESSORS_ONLN );
+      nthreads = ( ncpu > 0 ) ? ncpu : 1;
+    }
+
+    // open the readers up front, on this thread
+    std::vector< LSEReader* > readers;
+    std::vector< LSE_ScanWorker > workers;
+    LSE_ScanShared shared;
+    shared.stop = false;
+    pthread_mutex_init( &shared.mutex, NULL );
+    try {
+      readers.push_back( new LSEReader( filename, mode ) );
+      std::vector< LSE_ScanRange > ranges;
+      partition( *readers[0], filename, nthreads, ranges );
+      while ( readers.size() < ranges.size() ) {
+	readers.push_back( new LSEReader( filename, mode ) );
+      }
+
+      workers.resize( ranges.size() );
+      for ( size_t i = 0; i < ranges.size(); ++i ) {
+	workers[i].id      = i;
+	workers[i].reader  = readers[i];
+	workers[i].range   = ranges[i];
+	workers[i].visitor = &visitor;
+	workers[i].shared  = &shared;
+	workers[i].visited = 0;
+      }
+    } catch ( ... ) {
+      for ( size_t i = 0; i < readers.size(); ++i ) delete readers[i];
+      pthread_mutex_destroy( &shared.mutex );
+      throw;
+    }
+
+    // the calling thread takes the first range itself
+    size_t started( 1 );
+    for ( ; started < workers.size(); ++started ) {
+      int err = pthread_create( &workers[started].thread, NULL, runWorker, &workers[started] );
+      if ( err != 0 ) {
+	std::ostringstream ess;
+	ess << "forEachEvent: error starting worker thread";
+	ess << " (" << err << "=" << strerror( err ) << ")";
+	pthread_mutex_lock( &shared.mutex );
+	shared.error = ess.str();
+	shared.stop = true;
+	pthread_mutex_unlock( &shared.mutex );
+	break;
+      }
+    }
+    if ( !workers.empty() ) {
+      runWorker( &workers[0] );
+    }
+
+    unsigned long long visited( 0 );
+    for ( size_t i = 0; i < workers.size(); ++i ) {
+      if ( i > 0 && i < started ) pthread_join( workers[i].thread, NULL );
+      visited += workers[i].visited;
+    }
+    for ( size_t i = 0; i < readers.size(); ++i ) delete readers[i];
+    pthread_mutex_destroy( &shared.mutex );
+
+    if ( shared.stop ) {
+      throw std::runtime_error( shared.error );
+    }
+    return visited;
+  }
+
+}
+
+#endif // WIN32
@@ -0,0 +1,109 @@
+// staged output relies on writev()
+#ifndef WIN32
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <cstring>
+
+#include <sstream>
+#include <stdexcept>
+
+#include "LSE_StagedWriter.h"
+
+namespace eventFile {
+
+  LSE_StagedWriter::LSE_StagedWriter( int fd, off_t start, size_t bufsize ) :
+    m_fd( fd ), m_bufsize( bufsize ? bufsize : 1 ), m_buf( NULL ), m_used( 0 ), m_ofst( start )
+  {
+    m_buf = new unsigned char[ m_bufsize ];
+  }
+
+  LSE_StagedWriter::~LSE_StagedWriter()
+  {
+    delete [] m_buf;
+  }
+
+  void LSE_StagedWriter::append( const unsigned char* data, size_t len )
+  {
+    if ( m_used + len <= m_bufsize ) {
+      memcpy( m_buf + m_used, data, len );
+      m_used += len;
+      if ( m_used == m_bufsize ) {
+	writeOut( NULL, 0 );
+      }
+      return;
+    }
+
+    // write the staged bytes and this record together
+    writeOut( data, len );
+  }
+
+  void LSE_StagedWriter::flush()
+  {
+    if ( m_used > 0 ) {
+      writeOut( NULL, 0 );
+    }
+  }
+
+  void LSE_StagedWriter::skip( off_t len )
+  {
+    flush();
+    m_ofst += len;
+    if ( lseek( m_fd, m_ofst, SEEK_SET ) < 0 ) {
+      std::ostringstream ess;
+      ess << "LSE_StagedWriter::skip: error seeking to " << m_ofst;
+      ess << " (" << errno << "=" << strerror( errno ) << ")";
+      throw std::runtime_error( ess.str() );
+    }
+  }
+
+  void LSE_StagedWriter::writeOut( const unsigned char* data, size_t len )
+  {
+    struct iovec iov[2];
+    int niov = 0;
+    if ( m_used > 0 ) {
+      iov[niov].iov_base = m_buf;
+      iov[niov].iov_len  = m_used;
+      ++niov;
+    }
+    if ( len > 0 ) {
+      iov[niov].iov_base = const_cast< unsigned char* >( data );
+      iov[niov].iov_len  = len;
+      ++niov;
+    }
+
+    // carry on after short writes until both pieces are out
+    struct iovec* piov = iov;
+    size_t total = m_used + len;
+    while ( niov > 0 ) {
+      ssize_t n = writev( m_fd, piov, niov );
+      if ( n < 0 ) {
+	if ( errno == EINTR ) continue;
+
+	// report the lost bytes once rather than again on every flush
+	m_ofst += total;
+	m_used = 0;
+	std::ostringstream ess;
+	ess << "LSE_StagedWriter::write: error writing " << total << " bytes";
+	ess << " (" << errno << "=" << strerror( errno ) << ")";
+	throw std::runtime_error( ess.str() );
+      }
+      size_t done = n;
+      while ( niov > 0 && done >= piov->iov_len ) {
+	done -= piov->iov_len;
+	++piov;
+	--niov;
+      }
+      if ( niov > 0 ) {
+	piov->iov_base = static_cast< unsigned char* >( piov->iov_base ) + done;
+	piov->iov_len -= done;
+      }
+    }
+    m_ofst += total;
+    m_used = 0;
+  }
+
+}
+
+#endif // WIN32
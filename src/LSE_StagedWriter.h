@@ -0,0 +1,53 @@
+// -*- mode: c++ -*-
+/** @file LSE_StagedWriter.h
+ *  @brief Defines class LSE_StagedWriter, the output sink behind LSEWriter::STAGED
+ */
+
+#ifndef EVENTFILE_LSE_STAGEDWRITER_H
+#define EVENTFILE_LSE_STAGEDWRITER_H
+
+#ifndef WIN32
+
+#include <sys/types.h>
+
+namespace eventFile {
+
+  /**
+   * @brief Output sink gathering records into one large buffer flushed with writev()
+   *
+   * Records are copied into the staging buffer until the next one does not
+   * fit; that record is then written straight from the caller's memory in
+   * the same writev() as the staged bytes, so large events are never copied
+   * and every system call moves at least a buffer's worth of data.
+   */
+  class LSE_StagedWriter {
+  public:
+    LSE_StagedWriter( int fd, off_t start, size_t bufsize );
+    ~LSE_StagedWriter();
+
+    void append( const unsigned char* data, size_t len );
+    void flush();
+    off_t tell() const { return m_ofst + m_used; }
+
+    /// carry on after len bytes put in the file at tell() by other means
+    void skip( off_t len );
+
+  private:
+    int            m_fd;
+    size_t         m_bufsize;
+    unsigned char* m_buf;
+    size_t         m_used;    // bytes staged
+    off_t          m_ofst;    // file offset of the first staged byte
+
+    void writeOut( const unsigned char* data, size_t len );
+
+    // not copyable
+    LSE_StagedWriter( const LSE_StagedWriter& );
+    LSE_StagedWriter& operator=( const LSE_StagedWriter& );
+  };
+
+}
+
+#endif // WIN32
+
+#endif
@@ -0,0 +1,455 @@
+#ifdef HAVE_IO_URING
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <linux/io_uring.h>
+#include <cstring>
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+#include "LSE_Uring.h"
+
+namespace eventFile {
+
+  // wall-clock seconds, for the stall accounting
+  static double now()
+  {
+    struct timeval tv;
+    gettimeofday( &tv, NULL );
+    return tv.tv_sec + 1.0e-6 * tv.tv_usec;
+  }
+
+  static void fail( const char* where, const char* what, int err )
+  {
+    std::ostringstream ess;
+    ess << where << ": " << what;
+    ess << " (" << err << "=" << strerror( err ) << ")";
+    throw std::runtime_error( ess.str() );
+  }
+
+  //
+  // LSE_Uring
+  //
+
+  LSE_Uring::LSE_Uring( unsigned entries ) :
+    m_fd( -1 ), m_entries( 0 ), m_pending( 0 ), m_fixed( false ),
+    m_sqRing( MAP_FAILED ), m_sqRingLen( 0 ), m_sqes( NULL ), m_sqesLen( 0 ),
+    m_cqRing( MAP_FAILED ), m_cqRingLen( 0 )
+  {
+    struct io_uring_params p;
+    memset( &p, 0, sizeof p );
+    m_fd = syscall( __NR_io_uring_setup, entries, &p );
+    if ( m_fd < 0 ) {
+      fail( "LSE_Uring::LSE_Uring", "error creating io_uring", errno );
+    }
+    m_entries = p.sq_entries;
+
+    // map the submission and completion rings (one mapping on newer kernels)
+    m_sqRingLen = p.sq_off.array + p.sq_entries * sizeof( unsigned );
+    m_cqRingLen = p.cq_off.cqes + p.cq_entries * sizeof( struct io_uring_cqe );
+    bool single = ( p.features & IORING_FEAT_SINGLE_MMAP ) != 0;
+    if ( single ) {
+      m_sqRingLen = m_cqRingLen = std::max( m_sqRingLen, m_cqRingLen );
+    }
+    m_sqRing = mmap( NULL, m_sqRingLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		     m_fd, IORING_OFF_SQ_RING );
+    if ( m_sqRing == MAP_FAILED ) {
+      int err = errno;
+      close( m_fd );
+      fail( "LSE_Uring::LSE_Uring", "error mapping submission ring", err );
+    }
+    if ( single ) {
+      m_cqRing = m_sqRing;
+    } else {
+      m_cqRing = mmap( NULL, m_cqRingLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		       m_fd, IORING_OFF_CQ_RING );
+      if ( m_cqRing == MAP_FAILED ) {
+	int err = errno;
+	munmap( m_sqRing, m_sqRingLen );
+	close( m_fd );
+	fail( "LSE_Uring::LSE_Uring", "error mapping completion ring", err );
+      }
+    }
+    m_sqesLen = p.sq_entries * sizeof( struct io_uring_sqe );
+    void* sqes = mmap( NULL, m_sqesLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		       m_fd, IORING_OFF_SQES );
+    if ( sqes == MAP_FAILED ) {
+      int err = errno;
+      if ( m_cqRing != m_sqRing ) munmap( m_cqRing, m_cqRingLen );
+      munmap( m_sqRing, m_sqRingLen );
+      close( m_fd );
+      fail( "LSE_Uring::LSE_Uring", "error mapping submission entries", err );
+    }
+    m_sqes = static_cast< struct io_uring_sqe* >( sqes );
+
+    unsigned char* sq = static_cast< unsigned char* >( m_sqRing );
+    m_sqHead  = reinterpret_cast< unsigned* >( sq + p.sq_off.head );
+    m_sqTail  = reinterpret_cast< unsigned* >( sq + p.sq_off.tail );
+    m_sqMask  = reinterpret_cast< unsigned* >( sq + p.sq_off.ring_mask );
+    m_sqArray = reinterpret_cast< unsigned* >( sq + p.sq_off.array );
+
+    unsigned char* cq = static_cast< unsigned char* >( m_cqRing );
+    m_cqHead  = reinterpret_cast< unsigned* >( cq + p.cq_off.head );
+    m_cqTail  = reinterpret_cast< unsigned* >( cq + p.cq_off.tail );
+    m_cqMask  = reinterpret_cast< unsigned* >( cq + p.cq_off.ring_mask );
+    m_cqes    = reinterpret_cast< struct io_uring_cqe* >( cq + p.cq_off.cqes );
+  }
+
+  LSE_Uring::~LSE_Uring()
+  {
+    munmap( m_sqes, m_sqesLen );
+    if ( m_cqRing != m_sqRing ) munmap( m_cqRing, m_cqRingLen );
+    munmap( m_sqRing, m_sqRingLen );
+    close( m_fd );
+  }
+
+  void LSE_Uring::registerBuffers( const std::vector< struct iovec >& iov )
+  {
+    // fall back to unregistered buffers if the kernel won't pin them
+    m_fixed = ( syscall( __NR_io_uring_register, m_fd, IORING_REGISTER_BUFFERS,
+			 &iov[0], iov.size() ) == 0 );
+  }
+
+  int LSE_Uring::enter( unsigned nsubmit, unsigned nwait )
+  {
+    int ret;
+    do {
+      ret = syscall( __NR_io_uring_enter, m_fd, nsubmit, nwait,
+		     nwait ? IORING_ENTER_GETEVENTS : 0, NULL, 0 );
+    } while ( ret < 0 && errno == EINTR );
+    if ( ret < 0 ) {
+      fail( "LSE_Uring::enter", "error entering io_uring", errno );
+    }
+    return ret;
+  }
+
+  void LSE_Uring::prepare( int opcode, int fd, unsigned ibuf, const void* addr, size_t len, off_t ofst,
+			   unsigned long long user )
+  {
+    // make room if the submission queue is full
+    unsigned tail = *m_sqTail;
+    if ( tail - __atomic_load_n( m_sqHead, __ATOMIC_ACQUIRE ) >= m_entries ) {
+      submit();
+    }
+
+    unsigned idx = tail & *m_sqMask;
+    struct io_uring_sqe* sqe = &m_sqes[idx];
+    memset( sqe, 0, sizeof *sqe );
+    sqe->fd        = fd;
+    sqe->off       = ofst;
+    sqe->addr      = reinterpret_cast< unsigned long >( addr );
+    sqe->len       = len;
+    sqe->user_data = user;
+    if ( m_fixed ) {
+      sqe->opcode    = opcode;
+      sqe->buf_index = ibuf;
+    } else {
+      sqe->opcode    = ( opcode == IORING_OP_READ_FIXED ) ? IORING_OP_READ : IORING_OP_WRITE;
+    }
+    m_sqArray[idx] = idx;
+    __atomic_store_n( m_sqTail, tail + 1, __ATOMIC_RELEASE );
+    ++m_pending;
+  }
+
+  void LSE_Uring::read( int fd, unsigned ibuf, void* addr, size_t len, off_t ofst, unsigned long long user )
+  {
+    prepare( IORING_OP_READ_FIXED, fd, ibuf, addr, len, ofst, user );
+  }
+
+  void LSE_Uring::write( int fd, unsigned ibuf, const void* addr, size_t len, off_t ofst, unsigned long long user )
+  {
+    prepare( IORING_OP_WRITE_FIXED, fd, ibuf, addr, len, ofst, user );
+  }
+
+  void LSE_Uring::submit()
+  {
+    while ( m_pending > 0 ) {
+      m_pending -= enter( m_pending, 0 );
+    }
+  }
+
+  void LSE_Uring::wait( unsigned long long& user, int& res )
+  {
+    for (;;) {
+      unsigned head = *m_cqHead;
+      if ( head != __atomic_load_n( m_cqTail, __ATOMIC_ACQUIRE ) ) {
+	struct io_uring_cqe* cqe = &m_cqes[ head & *m_cqMask ];
+	user = cqe->user_data;
+	res  = cqe->res;
+	__atomic_store_n( m_cqHead, head + 1, __ATOMIC_RELEASE );
+	return;
+      }
+      unsigned nsubmit = m_pending;
+      m_pending -= enter( nsubmit, 1 );
+    }
+  }
+
+  //
+  // LSE_UringReader
+  //
+
+  LSE_UringReader::LSE_UringReader( int fd, off_t start, size_t chunksize, unsigned depth ) :
+    m_fd( fd ), m_chunksize( chunksize ), m_ring( depth < 2 ? 2 : depth ), m_slots(),
+    m_ofst( start ), m_take( 0 ), m_held( false ), m_eof( false ), m_resync( -1 ), m_stats()
+  {
+    // one chunk is held by the consumer, so at least one more must be in flight
+    if ( depth < 2 ) depth = 2;
+    m_slots.resize( depth );
+    std::vector< struct iovec > iov( depth );
+    for ( unsigned i = 0; i < depth; ++i ) {
+      m_slots[i].data  = new unsigned char[ m_chunksize ];
+      m_slots[i].ofst  = 0;
+      m_slots[i].res   = 0;
+      m_slots[i].state = FREE;
+      iov[i].iov_base = m_slots[i].data;
+      iov[i].iov_len  = m_chunksize;
+    }
+    m_ring.registerBuffers( iov );
+
+    for ( unsigned i = 0; i < depth; ++i ) {
+      submit( i );
+    }
+    m_ring.submit();
+  }
+
+  LSE_UringReader::~LSE_UringReader()
+  {
+    // the kernel may still be writing into our buffers
+    try {
+      drain();
+    } catch ( std::exception& ) {
+    }
+    for ( size_t i = 0; i < m_slots.size(); ++i ) {
+      delete [] m_slots[i].data;
+    }
+  }
+
+  void LSE_UringReader::submit( unsigned islot )
+  {
+    Slot& slot = m_slots[islot];
+    slot.ofst  = m_ofst;
+    slot.state = INFLIGHT;
+    m_ofst += m_chunksize;
+    m_ring.read( m_fd, islot, slot.data, m_chunksize, slot.ofst, islot );
+  }
+
+  void LSE_UringReader::reap()
+  {
+    unsigned long long user(0);
+    int res(0);
+    m_ring.wait( user, res );
+    Slot& slot = m_slots[user];
+    slot.res   = res;
+    slot.state = DONE;
+  }
+
+  void LSE_UringReader::drain()
+  {
+    m_ring.submit();
+    for ( size_t i = 0; i < m_slots.size(); ++i ) {
+      while ( m_slots[i].state == INFLIGHT ) {
+	reap();
+      }
+    }
+  }
+
+  bool LSE_UringReader::next( const unsigned char*& data, size_t& len )
+  {
+    // hand the held buffer back for the next unread chunk
+    if ( m_held ) {
+      unsigned iheld = ( m_take + m_slots.size() - 1 ) % m_slots.size();
+      m_held = false;
+      if ( m_eof || m_resync >= 0 ) {
+	m_slots[iheld].state = FREE;
+      } else {
+	submit( iheld );
+	m_ring.submit();
+      }
+    }
+
+    // after a short read, the chunks in flight may not follow on from it
+    if ( m_resync >= 0 ) {
+      restart( m_resync );
+    }
+    if ( m_eof ) return false;
+
+    // wait for the chunk if it hasn't arrived yet
+    Slot& slot = m_slots[m_take];
+    if ( slot.state == INFLIGHT ) {
+      double t0 = now();
+      while ( slot.state == INFLIGHT ) {
+	reap();
+      }
+      m_stats.stalls++;
+      m_stats.stallTime += now() - t0;
+    }
+
+    if ( slot.res < 0 ) {
+      m_eof = true;
+      slot.state = FREE;
+      fail( "LSE_UringReader::next", "error reading ahead", -slot.res );
+    }
+    if ( slot.res == 0 ) {
+      m_eof = true;
+      slot.state = FREE;
+      return false;
+    }
+    if ( static_cast<size_t>( slot.res ) < m_chunksize ) {
+      m_resync = slot.ofst + slot.res;
+    }
+
+    slot.state = HELD;
+    m_held = true;
+    m_take = ( m_take + 1 ) % m_slots.size();
+    m_stats.chunks++;
+    m_stats.bytes += slot.res;
+    data = slot.data;
+    len  = slot.res;
+    return true;
+  }
+
+  void LSE_UringReader::restart( off_t ofst )
+  {
+    drain();
+    m_take = 0;
+    m_held = false;
+    m_eof = false;
+    m_resync = -1;
+    m_ofst = ofst;
+    for ( unsigned i = 0; i < m_slots.size(); ++i ) {
+      submit( i );
+    }
+    m_ring.submit();
+  }
+
+  //
+  // LSE_UringWriter
+  //
+
+  LSE_UringWriter::LSE_UringWriter( int fd, off_t start, size_t bufsize, unsigned depth ) :
+    m_fd( fd ), m_bufsize( bufsize ), m_ring( depth < 2 ? 2 : depth ), m_slots(),
+    m_ofst( start ), m_fill( 0 ), m_inflight( 0 ), m_errno( 0 )
+  {
+    // one buffer is being filled while the others are written
+    if ( depth < 2 ) depth = 2;
+    m_slots.resize( depth );
+    std::vector< struct iovec > iov( depth );
+    for ( unsigned i = 0; i < depth; ++i ) {
+      m_slots[i].data  = new unsigned char[ m_bufsize ];
+      m_slots[i].used  = 0;
+      m_slots[i].len   = 0;
+      m_slots[i].ofst  = 0;
+      m_slots[i].state = FREE;
+      iov[i].iov_base = m_slots[i].data;
+      iov[i].iov_len  = m_bufsize;
+    }
+    m_ring.registerBuffers( iov );
+  }
+
+  LSE_UringWriter::~LSE_UringWriter()
+  {
+    // the kernel may still be reading from our buffers
+    try {
+      m_ring.submit();
+      while ( m_inflight > 0 ) {
+	reap();
+      }
+    } catch ( std::exception& ) {
+    }
+    for ( size_t i = 0; i < m_slots.size(); ++i ) {
+      delete [] m_slots[i].data;
+    }
+  }
+
+  void LSE_UringWriter::submit( unsigned islot )
+  {
+    Slot& slot = m_slots[islot];
+    slot.ofst  = m_ofst;
+    slot.len   = slot.used;
+    slot.used  = 0;
+    slot.state = INFLIGHT;
+    m_ofst += slot.len;
+    ++m_inflight;
+    m_ring.write( m_fd, islot, slot.data, slot.len, slot.ofst, islot );
+    m_ring.submit();
+  }
+
+  void LSE_UringWriter::reap()
+  {
+    unsigned long long user(0);
+    int res(0);
+    m_ring.wait( user, res );
+    Slot& slot = m_slots[user];
+    --m_inflight;
+
+    if ( res < 0 ) {
+      m_errno = -res;
+    } else {
+      // finish a short write synchronously
+      size_t done = res;
+      while ( done < slot.len ) {
+	ssize_t n = pwrite( m_fd, slot.data + done, slot.len - done, slot.ofst + done );
+	if ( n < 0 ) {
+	  if ( errno == EINTR ) continue;
+	  m_errno = errno;
+	  break;
+	}
+	done += n;
+      }
+    }
+    slot.len   = 0;
+    slot.state = FREE;
+  }
+
+  void LSE_UringWriter::check()
+  {
+    if ( m_errno ) {
+      int err = m_errno;
+      m_errno = 0;
+      fail( "LSE_UringWriter::write", "error writing", err );
+    }
+  }
+
+  void LSE_UringWriter::append( const unsigned char* data, size_t len )
+  {
+    while ( len > 0 ) {
+      // wait for the buffer if it is still being written
+      while ( m_slots[m_fill].state == INFLIGHT ) {
+	reap();
+      }
+      check();
+
+      Slot& slot = m_slots[m_fill];
+      size_t n = std::min( len, m_bufsize - slot.used );
+      memcpy( slot.data + slot.used, data, n );
+      slot.used += n;
+      data += n;
+      len -= n;
+
+      if ( slot.used == m_bufsize ) {
+	submit( m_fill );
+	m_fill = ( m_fill + 1 ) % m_slots.size();
+      }
+    }
+  }
+
+  void LSE_UringWriter::flush()
+  {
+    if ( m_slots[m_fill].used > 0 ) {
+      submit( m_fill );
+      m_fill = ( m_fill + 1 ) % m_slots.size();
+    }
+    while ( m_inflight > 0 ) {
+      reap();
+    }
+    check();
+  }
+
+}
+
+#endif // HAVE_IO_URING
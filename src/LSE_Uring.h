@@ -0,0 +1,170 @@
+// -*- mode: c++ -*-
+/** @file LSE_Uring.h
+ *  @brief Defines the io_uring classes behind the LSEReader and LSEWriter URING modes
+ *
+ *  These are only built when HAVE_IO_URING is defined (Linux with the
+ *  io_uring kernel headers).  The rings are driven with raw system calls so
+ *  that there is no run-time dependency on liburing.
+ */
+
+#ifndef EVENTFILE_LSE_URING_H
+#define EVENTFILE_LSE_URING_H
+
+#ifdef HAVE_IO_URING
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <vector>
+
+#include "LSE_ChunkSource.h"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace eventFile {
+
+  /**
+   * @brief Minimal io_uring submission/completion queue pair
+   *
+   * Fixed-buffer operations are used when the buffers could be registered
+   * with the kernel; otherwise (e.g. RLIMIT_MEMLOCK too small) the plain
+   * read/write opcodes are used on the same buffers.
+   */
+  class LSE_Uring {
+  public:
+    explicit LSE_Uring( unsigned entries );
+    ~LSE_Uring();
+
+    /// register the buffers that later read()/write() calls will refer to
+    void registerBuffers( const std::vector< struct iovec >& );
+
+    /// queue a read into, or write from, registered buffer ibuf
+    void read( int fd, unsigned ibuf, void* addr, size_t len, off_t ofst, unsigned long long user );
+    void write( int fd, unsigned ibuf, const void* addr, size_t len, off_t ofst, unsigned long long user );
+
+    /// hand all queued operations to the kernel
+    void submit();
+
+    /// block until one operation completes
+    void wait( unsigned long long& user, int& res );
+
+  private:
+    int       m_fd;
+    unsigned  m_entries;
+    unsigned  m_pending;
+    bool      m_fixed;
+
+    // submission queue
+    void*     m_sqRing;
+    size_t    m_sqRingLen;
+    unsigned* m_sqHead;
+    unsigned* m_sqTail;
+    unsigned* m_sqMask;
+    unsigned* m_sqArray;
+    struct io_uring_sqe* m_sqes;
+    size_t    m_sqesLen;
+
+    // completion queue
+    void*     m_cqRing;
+    size_t    m_cqRingLen;
+    unsigned* m_cqHead;
+    unsigned* m_cqTail;
+    unsigned* m_cqMask;
+    struct io_uring_cqe* m_cqes;
+
+    void prepare( int opcode, int fd, unsigned ibuf, const void* addr, size_t len, off_t ofst,
+		  unsigned long long user );
+    int enter( unsigned nsubmit, unsigned nwait );
+
+    // not copyable
+    LSE_Uring( const LSE_Uring& );
+    LSE_Uring& operator=( const LSE_Uring& );
+  };
+
+  /**
+   * @brief Chunk source keeping several large reads in flight on an io_uring
+   *
+   * Chunks are read into a ring of registered buffers in file order, and each
+   * buffer is resubmitted for the next unread chunk as soon as the consumer
+   * lets go of it.
+   */
+  class LSE_UringReader : public LSE_ChunkSource {
+  public:
+    LSE_UringReader( int fd, off_t start, size_t chunksize, unsigned depth );
+    ~LSE_UringReader();
+
+    bool next( const unsigned char*& data, size_t& len );
+    void restart( off_t ofst );
+    LSEReader::PrefetchStats stats() const { return m_stats; }
+
+  private:
+    enum SlotState { FREE, INFLIGHT, DONE, HELD };
+    struct Slot {
+      unsigned char* data;
+      off_t          ofst;
+      int            res;
+      SlotState      state;
+    };
+
+    int                 m_fd;
+    size_t              m_chunksize;
+    LSE_Uring           m_ring;
+    std::vector<Slot>   m_slots;
+    off_t               m_ofst;      // next file offset to submit
+    unsigned            m_take;      // next slot the consumer will take
+    bool                m_held;
+    bool                m_eof;
+    off_t               m_resync;    // where to restart after a short read, or -1
+
+    LSEReader::PrefetchStats m_stats;
+
+    void submit( unsigned islot );
+    void reap();
+    void drain();
+  };
+
+  /**
+   * @brief Output sink staging bytes into registered buffers written via io_uring
+   *
+   * Full buffers are submitted as single positional writes while the next
+   * buffer is filled; the caller only waits when every buffer is in flight.
+   */
+  class LSE_UringWriter {
+  public:
+    LSE_UringWriter( int fd, off_t start, size_t bufsize, unsigned depth );
+    ~LSE_UringWriter();
+
+    void append( const unsigned char* data, size_t len );
+    void flush();
+    off_t tell() const { return m_ofst + m_slots[m_fill].used; }
+
+  private:
+    enum SlotState { FREE, INFLIGHT };
+    struct Slot {
+      unsigned char* data;
+      size_t         used;    // bytes staged while filling
+      size_t         len;     // bytes being written while in flight
+      off_t          ofst;
+      SlotState      state;
+    };
+
+    int                 m_fd;
+    size_t              m_bufsize;
+    LSE_Uring           m_ring;
+    std::vector<Slot>   m_slots;
+    off_t               m_ofst;      // file offset of the buffer being filled
+    unsigned            m_fill;      // buffer being filled
+    unsigned            m_inflight;
+    int                 m_errno;
+
+    void submit( unsigned islot );
+    void reap();
+    void check();
+  };
+
+}
+
+#endif // HAVE_IO_URING
+
+#endif // EVENTFILE_LSE_URING_H
@@ -0,0 +1,174 @@
+// the writer thread relies on POSIX threads
+#ifndef WIN32
+
+#include <sys/time.h>
+#include <cstring>
+
+#include <sstream>
+#include <stdexcept>
+
+#include "LSE_WriteQueue.h"
+
+namespace eventFile {
+
+  // wall-clock seconds, for the blocked-time accounting
+  static double now()
+  {
+    struct timeval tv;
+    gettimeofday( &tv, NULL );
+    return tv.tv_sec + 1.0e-6 * tv.tv_usec;
+  }
+
+  LSE_WriteQueue::LSE_WriteQueue( LSEWriter& writer, unsigned depth ) :
+    m_writer( writer ), m_slots(), m_head( 0 ), m_count( 0 ), m_stop( false ),
+    m_running( false ), m_error(), m_reported( false ), m_stats()
+  {
+    if ( depth < 1 ) depth = 1;
+    m_slots.resize( depth );
+
+    pthread_mutex_init( &m_mutex, NULL );
+    pthread_mutex_init( &m_pmutex, NULL );
+    pthread_cond_init( &m_filled, NULL );
+    pthread_cond_init( &m_freed, NULL );
+
+    int err = pthread_create( &m_thread, NULL, &LSE_WriteQueue::run, this );
+    if ( err != 0 ) {
+      pthread_cond_destroy( &m_freed );
+      pthread_cond_destroy( &m_filled );
+      pthread_mutex_destroy( &m_pmutex );
+      pthread_mutex_destroy( &m_mutex );
+      std::ostringstream ess;
+      ess << "LSE_WriteQueue::LSE_WriteQueue: error starting writer thread";
+      ess << " (" << err << "=" << strerror( err ) << ")";
+      throw std::runtime_error( ess.str() );
+    }
+    m_running = true;
+  }
+
+  LSE_WriteQueue::~LSE_WriteQueue()
+  {
+    try {
+      stop();
+    } catch ( std::exception& ) {
+    }
+    pthread_cond_destroy( &m_freed );
+    pthread_cond_destroy( &m_filled );
+    pthread_mutex_destroy( &m_pmutex );
+    pthread_mutex_destroy( &m_mutex );
+  }
+
+  void* LSE_WriteQueue::run( void* arg )
+  {
+    static_cast< LSE_WriteQueue* >( arg )->loop();
+    return NULL;
+  }
+
+  void LSE_WriteQueue::loop()
+  {
+    pthread_mutex_lock( &m_mutex );
+    for (;;) {
+      while ( m_count == 0 && !m_stop ) {
+	pthread_cond_wait( &m_filled, &m_mutex );
+      }
+      if ( m_count == 0 ) break;
+
+      // producers never touch the head slot while it is queued
+      Slot& slot = m_slots[m_head];
+      bool failed = !m_error.empty();
+      pthread_mutex_unlock( &m_mutex );
+
+      std::string err;
+      if ( !failed ) {
+	try {
+	  m_writer.commit( slot.rec, slot.ctx, slot.itype, slot.ktype );
+	} catch ( std::exception& e ) {
+	  err = e.what();
+	}
+      }
+
+      pthread_mutex_lock( &m_mutex );
+      if ( !err.empty() ) m_error = err;
+      m_head = ( m_head + 1 ) % m_slots.size();
+      --m_count;
+      m_stats.depth = m_count;
+      pthread_cond_broadcast( &m_freed );
+    }
+    pthread_mutex_unlock( &m_mutex );
+  }
+
+  void LSE_WriteQueue::check( bool always )
+  {
+    // called with the mutex held
+    if ( !m_error.empty() && ( always || !m_reported ) ) {
+      m_reported = true;
+      std::string err( m_error );
+      pthread_mutex_unlock( &m_mutex );
+      throw std::runtime_error( err );
+    }
+  }
+
+  void LSE_WriteQueue::push( std::vector< unsigned char >& rec, const LSE_Context& ctx, int itype, int ktype )
+  {
+    pthread_mutex_lock( &m_mutex );
+    check( true );
+
+    // wait for room, charging the time to the producers
+    if ( m_count == m_slots.size() ) {
+      double t0 = now();
+      while ( m_count == m_slots.size() && m_error.empty() ) {
+	pthread_cond_wait( &m_freed, &m_mutex );
+      }
+      m_stats.stalls++;
+      m_stats.blockedTime += now() - t0;
+      check( true );
+    }
+
+    Slot& slot = m_slots[ ( m_head + m_count ) % m_slots.size() ];
+    slot.rec.swap( rec );
+    slot.ctx   = ctx;
+    slot.itype = itype;
+    slot.ktype = ktype;
+    ++m_count;
+    m_stats.events++;
+    m_stats.depth = m_count;
+    if ( m_count > m_stats.maxDepth ) m_stats.maxDepth = m_count;
+    pthread_cond_signal( &m_filled );
+    pthread_mutex_unlock( &m_mutex );
+  }
+
+  void LSE_WriteQueue::drain()
+  {
+    pthread_mutex_lock( &m_mutex );
+    while ( m_count > 0 ) {
+      pthread_cond_wait( &m_freed, &m_mutex );
+    }
+    check( false );
+    pthread_mutex_unlock( &m_mutex );
+  }
+
+  void LSE_WriteQueue::stop()
+  {
+    if ( m_running ) {
+      pthread_mutex_lock( &m_mutex );
+      m_stop = true;
+      pthread_cond_signal( &m_filled );
+      pthread_mutex_unlock( &m_mutex );
+      pthread_join( m_thread, NULL );
+      m_running = false;
+    }
+    pthread_mutex_lock( &m_mutex );
+    check( false );
+    pthread_mutex_unlock( &m_mutex );
+  }
+
+  LSEWriter::AsyncStats LSE_WriteQueue::stats() const
+  {
+    pthread_mutex_lock( &m_mutex );
+    LSEWriter::AsyncStats s( m_stats );
+    pthread_mutex_unlock( &m_mutex );
+    return s;
+  }
+
+}
+
+#endif // WIN32
@@ -0,0 +1,96 @@
+// -*- mode: c++ -*-
+/** @file LSE_WriteQueue.h
+ *  @brief Defines class LSE_WriteQueue, the writer thread behind LSEWriter::enableAsync()
+ */
+
+#ifndef EVENTFILE_LSE_WRITEQUEUE_H
+#define EVENTFILE_LSE_WRITEQUEUE_H
+
+#ifndef WIN32
+
+#include <pthread.h>
+
+#include <string>
+#include <vector>
+
+#include "eventFile/LSEWriter.h"
+#include "eventFile/LSE_Context.h"
+
+namespace eventFile {
+
+  /**
+   * @brief Bounded queue of serialized events committed by a dedicated thread
+   *
+   * Producers hand over records already packed by LSEWriter; the writer
+   * thread encodes, indexes and writes them in queue order through the
+   * LSEWriter, so everything behind LSEWriter::commit() is touched by that
+   * thread alone.  Records are swapped into the slots rather than copied.
+   * An error raised on the writer thread is reported once, by the next
+   * push(), drain() or stop(); later events are dropped and every later
+   * push() fails.
+   */
+  class LSE_WriteQueue {
+  public:
+    LSE_WriteQueue( LSEWriter& writer, unsigned depth );
+    ~LSE_WriteQueue();
+
+    /// queue the record, leaving a spare buffer in rec; blocks while full
+    void push( std::vector< unsigned char >& rec, const LSE_Context& ctx, int itype, int ktype );
+
+    /// wait until every queued record has been written
+    void drain();
+
+    /// drain the queue and stop the writer thread
+    void stop();
+
+    LSEWriter::AsyncStats stats() const;
+
+    /** keeps LSEWriter::write() calls from several producer threads from
+	interleaving; a no-op when the writer is not asynchronous */
+    class Producer {
+    public:
+      explicit Producer( LSE_WriteQueue* q ) : m_q( q ) { if ( m_q ) pthread_mutex_lock( &m_q->m_pmutex ); }
+      ~Producer() { if ( m_q ) pthread_mutex_unlock( &m_q->m_pmutex ); }
+    private:
+      LSE_WriteQueue* m_q;
+    };
+
+  private:
+    struct Slot {
+      std::vector< unsigned char > rec;
+      LSE_Context                  ctx;
+      int                          itype;
+      int                          ktype;
+    };
+
+    LSEWriter&          m_writer;
+    std::vector<Slot>   m_slots;
+    unsigned            m_head;      // next slot the writer thread will commit
+    unsigned            m_count;     // slots queued
+    bool                m_stop;
+    bool                m_running;
+    std::string         m_error;     // error seen by the writer thread
+    bool                m_reported;  // m_error has been thrown
+
+    pthread_t           m_thread;
+    mutable pthread_mutex_t m_mutex;
+    pthread_mutex_t     m_pmutex;
+    pthread_cond_t      m_filled;
+    pthread_cond_t      m_freed;
+
+    LSEWriter::AsyncStats m_stats;
+
+    static void* run( void* );
+    void loop();
+    void check( bool always );
+
+    // not copyable
+    LSE_WriteQueue( const LSE_WriteQueue& );
+    LSE_WriteQueue& operator=( const LSE_WriteQueue& );
+  };
+
+}
+
+#endif // WIN32
+
+#endif // EVENTFILE_LSE_WRITEQUEUE_H
@@ -5,9 +5,35 @@
  * @section intro Introduction
  * The eventFile package provides a layer of abstraction between the eventRet
  * package and ldfReader / LatIntegration / Gleam.  It has minimal dependencies
- * on external libraries, and can be compiled as a single-threaded library.
+ * on external libraries.  Apart from the optional read-ahead I/O thread used by
+ * LSEReader's PREFETCH mode, the block inflater for compressed files, the
+ * writer thread of LSEWriter::enableAsync(), the reader threads of
+ * LSE_EventFetcher and the forEachEvent() parallel scan (POSIX threads), it
+ * is a single-threaded library;
+ * LSE_PositionalReader offers pread()-based reads by offset that any number of
+ * threads may share.  Each reader keeps the MOOT key/alias of its own file
+ * (LSEReader::mootKey(), LSE_EventView::mootKey()), so many files can be open
+ * at once.
  * It supports reading a serialized stream of context+metainfo+event blocks
  * from files created using eventRet
+ *
+ * On Linux builds where the io_uring kernel headers are present (HAVE_IO_URING),
+ * LSEReader and LSEWriter also offer a URING mode that keeps several large
+ * reads or writes in flight through an io_uring instance.  LSEWriter's STAGED
+ * mode gathers whole events into one large buffer flushed with writev().
+ * LSEWriter::copy() appends runs of stored records, with copy_file_range()
+ * where it is available (HAVE_COPY_FILE_RANGE); writeMerge.exe uses it for
+ * index entries that follow each other in the same chunk file.  With
+ * WRITEMERGE_THREADS=<n>, writeMerge.exe reads the events of the index
+ * entries ahead of it on n threads through an LSE_EventFetcher.  With
+ * WRITEMERGE_LOOKAHEAD=<n>, it parses n index entries ahead and advises the
+ * kernel of the chunk-file ranges they need
+ * (LSE_PositionalReader::willNeed()).  It keeps at most WRITEMERGE_MAXOPEN
+ * (default 256) chunk files open, closing the least recently used; the
+ * readers' reopen() skips reading the header again if the file is unchanged.
+ *
+ * Where zlib is available (HAVE_ZLIB), LSEWriter can deflate blocked files a
+ * block at a time, and LSEReader inflates them on a pool of worker threads.
  * 
  * @section depends Dependencies
  * - The \c ldf external package which provides the LDF library.
@@ -0,0 +1,119 @@
+// checks that EBF_Data draws its payload from an EBF_Arena until the arena
+// is reset and from its own reused heap storage otherwise, and that read()
+// refuses a stored length the file cannot hold
+#include <stdio.h>
+#include <string.h>
+
+#include <iostream>
+#include <stdexcept>
+
+#include "eventFile/EBF_Arena.h"
+#include "test_events.h"
+
+using namespace eventFile;
+
+// true if p lies within the n bytes from base
+static bool within( const unsigned char* p, const unsigned char* base, size_t n )
+{
+  return p >= base && p < base + n;
+}
+
+// what read() throws for the file, or "" if it reads it
+static std::string readError( const char* fn, EBF_Data& ebf )
+{
+  FILE* fp = fopen( fn, "rb" );
+  CHECK( fp );
+  std::string error;
+  try {
+    ebf.read( fp );
+  } catch ( std::runtime_error& e ) {
+    error = e.what();
+  }
+  fclose( fp );
+  return error;
+}
+
+int main( int, char** )
+{
+  // storage is handed out aligned, from blocks that survive a reset
+  EBF_Arena arena( 4096 );
+  unsigned char* first = arena.allocate( 3 );
+  unsigned char* second = arena.allocate( 10 );
+  CHECK( second == first + 8 && arena.used() == 24 && arena.capacity() == 4096 );
+  unsigned char* big = arena.allocate( 10000 );
+  CHECK( arena.capacity() == 4096 + 10000 );
+  unsigned gen = arena.generation();
+  arena.reset();
+  CHECK( arena.generation() == gen + 1 && arena.used() == 0 && arena.capacity() == 4096 + 10000 );
+  CHECK( arena.allocate( 100 ) == first );
+  arena.reset();
+
+  // payloads come from the arena, and each takes only what it needs
+  std::vector< EBF_Data* > batch;
+  for ( unsigned i = 0; i < 20; i++ ) {
+    batch.push_back( new EBF_Data( arena ) );
+    testEvents::makeEBF( *batch.back(), i );
+  }
+  for ( unsigned i = 0; i < batch.size(); i++ ) {
+    const unsigned char* p = batch[i]->data();
+    CHECK( within( p, first, 4096 ) || within( p, big, 10000 ) );
+    EBF_Data expect;
+    testEvents::makeEBF( expect, i );
+    CHECK( batch[i]->size() == expect.size() && memcmp( p, expect.data(), expect.size() ) == 0 );
+  }
+  CHECK( arena.capacity() == 4096 + 10000 );
+
+  // after a reset nothing drawn before is used again, however small the event
+  arena.reset();
+  testEvents::makeEBF( *batch[5], 0 );
+  CHECK( batch[5]->data() == first && batch[5]->capacity() == 8 );
+  testEvents::makeEBF( *batch[6], 1 );
+  CHECK( batch[6]->data() == first + 8 );
+  for ( unsigned i = 0; i < batch.size(); i++ ) delete batch[i];
+
+  // heap storage is kept and reused while events fit in it
+  EBF_Data heap;
+  testEvents::makeEBF( heap, 50 );
+  const unsigned char* own = heap.data();
+  unsigned cap = heap.capacity();
+  CHECK( cap % 4096 == 0 && cap >= heap.size() );
+  testEvents::makeEBF( heap, 3 );
+  CHECK( heap.data() == own && heap.capacity() == cap );
+
+  // a copy owns its storage
+  EBF_Data copy( heap );
+  CHECK( copy.data() != heap.data() && copy.size() == heap.size() );
+  CHECK( memcmp( copy.data(), heap.data(), heap.size() ) == 0 );
+
+  // read() round trip
+  const char* fn = "test_Arena.ebf";
+  FILE* fp = fopen( fn, "wb" );
+  CHECK( fp );
+  heap.write( fp );
+  fclose( fp );
+  EBF_Data back( arena );
+  CHECK( readError( fn, back ) == "" );
+  CHECK( back.size() == heap.size() && memcmp( back.data(), heap.data(), heap.size() ) == 0 );
+
+  // a stored length far past the end of the file is refused before anything
+  // is reserved for it, and one cut short leaves no payload behind
+  unsigned lengths[] = { 0x7FFFFFF0, 2000 };
+  for ( int i = 0; i < 2; i++ ) {
+    fp = fopen( fn, "wb" );
+    CHECK( fp );
+    CHECK( fwrite( &lengths[i], sizeof lengths[i], 1, fp ) == 1 );
+    CHECK( fwrite( heap.data(), 100, 1, fp ) == 1 );
+    fclose( fp );
+    std::string error = readError( fn, heap );
+    if ( i == 0 ) {
+      CHECK( error.find( "exceeds the 100 bytes left" ) != std::string::npos );
+      CHECK( heap.capacity() == cap );
+    } else {
+      CHECK( error.find( "error reading data" ) != std::string::npos );
+    }
+    CHECK( heap.size() == 0 );
+  }
+  remove( fn );
+  printf( "test_Arena: OK\n" );
+  return 0;
+}
@@ -0,0 +1,86 @@
+// checks that readBatch() fills every column of LSE_EventBatch with the
+// values of the events read, in every reader mode and batch size, and picks
+// up where read() left off
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+#include "eventFile/LSE_EventBatch.h"
+#include "eventFile/LSE_EventView.h"
+#include "test_events.h"
+
+using namespace eventFile;
+
+static const unsigned N = 1000;
+
+// check event k of the batch against event i of the file
+static void verifyBatch( const LSE_EventBatch& batch, size_t k, unsigned i )
+{
+  LSE_Context c;
+  testEvents::makeContext( c, i );
+  CHECK( batch.sequence[k] == c.scalers.sequence );
+  CHECK( batch.timeSecs[k] == c.current.timeSecs );
+  CHECK( batch.livetime[k] == c.scalers.livetime );
+  LSE_Info::InfoType itype = i % 10 < 7 ? LSE_Info::LPA : i % 10 == 7 ? LSE_Info::LCI_ACD :
+    i % 10 == 8 ? LSE_Info::LCI_CAL : LSE_Info::LCI_TKR;
+  CHECK( batch.infotype[k] == itype );
+  CHECK( batch.keystype[k] == ( itype == LSE_Info::LPA ? LSE_Keys::LPA : LSE_Keys::LCI ) );
+  EBF_Data ebf;
+  testEvents::makeEBF( ebf, i );
+  CHECK( batch.ebfSize( k ) == ebf.size() );
+  CHECK( memcmp( batch.ebf( k ), ebf.data(), ebf.size() ) == 0 );
+}
+
+int main( int, char** )
+{
+  const char* fn = "test_Batch.evt";
+  {
+    LSEWriter w( fn, 1 );
+    testEvents::writeEvents( w, N );
+  }
+
+  static const LSEReader::IOMode modes[] = { LSEReader::STDIO, LSEReader::MMAP, LSEReader::PREFETCH };
+  static const size_t sizes[] = { 1, 7, 128, 2 * N };
+  for ( size_t m = 0; m < sizeof modes / sizeof modes[0]; m++ ) {
+    for ( size_t s = 0; s < sizeof sizes / sizeof sizes[0]; s++ ) {
+      LSEReader r( fn, modes[m] );
+
+      // a few events one at a time first
+      LSE_EventView view;
+      unsigned i = 0;
+      for ( ; i < 3; i++ ) CHECK( r.read( view ) );
+
+      LSE_EventBatch batch;
+      size_t cap = 0;
+      for ( ;; ) {
+	size_t n = r.readBatch( batch, sizes[s] );
+	CHECK( n == batch.size() && n == std::min( sizes[s], static_cast< size_t >( N - i ) ) );
+	if ( n == 0 ) break;
+	CHECK( batch.timeSecs.size() == n && batch.livetime.size() == n );
+	CHECK( batch.infotype.size() == n && batch.keystype.size() == n );
+	CHECK( batch.ebfOffset.size() == n && batch.ebfLength.size() == n );
+
+	// the payloads lie back to back
+	size_t bytes = 0;
+	for ( size_t k = 0; k < n; k++, i++ ) {
+	  CHECK( batch.ebfOffset[k] == bytes );
+	  bytes += batch.ebfSize( k );
+	  verifyBatch( batch, k, i );
+	}
+	CHECK( batch.payload.size() == bytes );
+
+	// refilling a batch of the same size keeps its storage
+	if ( n == sizes[s] && cap ) CHECK( batch.sequence.capacity() == cap );
+	cap = batch.sequence.capacity();
+      }
+      CHECK( i == N && batch.empty() );
+    }
+    printf( "test_Batch: mode %d OK\n", static_cast< int >( modes[m] ) );
+  }
+  remove( fn );
+  printf( "test_Batch: OK\n" );
+  return 0;
+}
@@ -0,0 +1,66 @@
+// checks that the columns sidecar LSEWriter writes holds, across several
+// blocks, each numeric context field of every event as read back from the
+// event file
+#include <stdio.h>
+#include <string.h>
+
+#include <iostream>
+#include <stdexcept>
+
+#include "eventFile/LSE_ContextColumns.h"
+#include "test_events.h"
+
+using namespace eventFile;
+
+// enough events to fill one block and start another
+static const unsigned N = LSE_COLUMNS_BLOCK + 1234;
+
+int main( int, char** )
+{
+  const char* fn = "test_Columns.evt";
+  {
+    // small events, so that the file stays small however many there are
+    LSEWriter w( fn, 7 );
+    w.enableColumns();
+    LSE_Context c;
+    EBF_Data e;
+    LPA_Info p;
+    for ( unsigned i = 0; i < N; i++ ) {
+      testEvents::makeContext( c, i );
+      c.ccsds.utc += 0.25;
+      testEvents::makeEBF( e, 0 );
+      testEvents::makeLPA( p, i );
+      w.write( c, e, p, LPA_Keys( 0x111, 0x222, 0x333, i ) );
+    }
+  }
+
+  LSE_ContextColumns cols;
+  LSE_ColumnsHeader hdr = cols.load( LSE_ContextColumns::name( fn ) );
+  CHECK( hdr.marker == LSE_COLUMNS_MARKER && hdr.version == LSE_COLUMNS_VERSION );
+  CHECK( hdr.ncolumns == LSE_ContextColumns::NCOLUMNS && hdr.runid == 7 && hdr.count == N );
+  CHECK( cols.size() == N );
+  CHECK( cols.elapsed.size() == N && cols.livetime.size() == N && cols.prescaled.size() == N );
+  CHECK( cols.discarded.size() == N && cols.deadzone.size() == N && cols.utc.size() == N );
+  CHECK( cols.timeSecs.size() == N && cols.tics.size() == N && cols.hacks.size() == N );
+
+  LSEReader r( fn );
+  LSE_Context c;
+  for ( unsigned i = 0; i < N; i++ ) {
+    CHECK( r.readContext( c ) );
+    CHECK( cols.elapsed[i] == c.scalers.elapsed && cols.livetime[i] == c.scalers.livetime );
+    CHECK( cols.prescaled[i] == c.scalers.prescaled && cols.discarded[i] == c.scalers.discarded );
+    CHECK( cols.sequence[i] == c.scalers.sequence && cols.deadzone[i] == c.scalers.deadzone );
+    CHECK( cols.utc[i] == c.ccsds.utc && cols.timeSecs[i] == c.current.timeSecs );
+    CHECK( cols.tics[i] == c.current.timeHack.tics && cols.hacks[i] == c.current.timeHack.hacks );
+  }
+  CHECK( !r.readContext( c ) );
+
+  // load() replaces what was there
+  cols.load( LSE_ContextColumns::name( fn ) );
+  CHECK( cols.size() == N );
+
+  remove( LSE_ContextColumns::name( fn ).c_str() );
+  remove( fn );
+  printf( "test_Columns: OK\n" );
+  return 0;
+}
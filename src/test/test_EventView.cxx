@@ -0,0 +1,125 @@
+// checks LSE_EventView parsing and the copies out of it, in place and through LSEReader
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <stdexcept>
+
+#include "eventFile/LSE_EventView.h"
+#include "test_events.h"
+
+using namespace eventFile;
+
+// a record by hand: an LCI_ACD event with a one-word EBF, whose info block
+// stores only len bytes
+static std::vector< unsigned char > shortRecord( unsigned len )
+{
+  std::vector< unsigned char > rec( sizeof( LSE_Context ) );
+  LSE_Context ctx;
+  testEvents::makeContext( ctx, 7 );
+  memcpy( &rec[0], &ctx, sizeof ctx );
+
+  unsigned words[] = { 4, 0x104f0010, LSE_Info::LCI_ACD, len };
+  rec.insert( rec.end(), reinterpret_cast< unsigned char* >( words ), reinterpret_cast< unsigned char* >( words + 4 ) );
+  for ( unsigned i = 0; i < len; i++ ) rec.push_back( 0xA5 );
+  unsigned keys[] = { LSE_Keys::LCI, 1, 2, 3 };
+  rec.insert( rec.end(), reinterpret_cast< unsigned char* >( keys ), reinterpret_cast< unsigned char* >( keys + 4 ) );
+  return rec;
+}
+
+static void checkShort( const LCI_ACD_Info& a, unsigned len )
+{
+  const unsigned char* p = reinterpret_cast< const unsigned char* >( &a );
+  for ( unsigned i = 0; i < sizeof a; i++ ) {
+    CHECK( p[i] == ( i < len ? 0xA5 : 0 ) );
+  }
+}
+
+int main( int, char** )
+{
+  const char* fn = "test_EventView.evt";
+  const unsigned N = 200;
+
+  // whole files, through the copying and the mapped reader
+  {
+    LSEWriter w( fn, 1 );
+    testEvents::writeEvents( w, N );
+  }
+  {
+    LSEReader r( fn );
+    testEvents::verifyFile( r, N );
+  }
+  {
+    LSEReader r( fn, LSEReader::MMAP );
+    testEvents::verifyFile( r, N );
+  }
+
+  // an LPA event without handlers after one with them reads back without
+  // any, in both readers (the original LPA_Info::read() kept the old ones)
+  {
+    LSEWriter w( fn, 1 );
+    LSE_Context ctx; EBF_Data ebf; LPA_Info pinfo;
+    for ( unsigned i = 0; i < 2; i++ ) {
+      testEvents::makeContext( ctx, i ); testEvents::makeEBF( ebf, i ); testEvents::makeLPA( pinfo, i );
+      if ( i == 1 ) pinfo.handlers.clear();
+      w.write( ctx, ebf, pinfo, LPA_Keys( 1, 2, 3, i ) );
+    }
+  }
+  for ( int mode = 0; mode < 2; mode++ ) {
+    LSEReader r( fn, mode ? LSEReader::MMAP : LSEReader::STDIO );
+    testEvents::Event e;
+    CHECK( e.read( r ) && e.pinfo.handlers.size() == 3 );
+    CHECK( e.read( r ) && e.pinfo.handlers.empty() );
+  }
+
+  // an LCI block shorter than its struct is copied as far as it goes
+  const unsigned len = 12;
+  std::vector< unsigned char > rec = shortRecord( len );
+  LSE_EventView view;
+  CHECK( view.parse( &rec[0], rec.size() ) == rec.size() );
+  CHECK( view.infotype() == LSE_Info::LCI_ACD && view.ainfo() == NULL );
+  LCI_ACD_Info ainfo;
+  memset( static_cast<void*>( &ainfo ), 0xFF, sizeof ainfo );
+  view.copy( ainfo );
+  checkShort( ainfo, len );
+  LCI_Keys cikeys;
+  view.copy( cikeys );
+  CHECK( cikeys.LCI_script == 3 );
+
+  // and so is it by the stdio reader, with the record behind a one-event header
+  unsigned long long start = 0;
+  {
+    LSEWriter w( fn, 1 );
+    start = w.tell();
+    testEvents::writeEvents( w, 1 );
+  }
+  CHECK( truncate( fn, start ) == 0 );
+  FILE* fp = fopen( fn, "ab" );
+  CHECK( fp && fwrite( &rec[0], rec.size(), 1, fp ) == 1 );
+  fclose( fp );
+  {
+    LSEReader r( fn );
+    testEvents::Event e;
+    memset( static_cast<void*>( &e.ainfo ), 0xFF, sizeof e.ainfo );
+    CHECK( e.read( r ) && e.itype == LSE_Info::LCI_ACD );
+    checkShort( e.ainfo, len );
+    CHECK( e.cikeys.LCI_script == 3 );
+  }
+
+  // an absurd block length is an error rather than a read out of bounds
+  std::vector< unsigned char > bad = shortRecord( 4 );
+  unsigned huge = LSE_INFO_MAX_LCI + 1;
+  memcpy( &bad[ sizeof( LSE_Context ) + 3 * sizeof( unsigned ) ], &huge, sizeof huge );
+  bool thrown = false;
+  try {
+    LSE_EventView::measure( &bad[0], bad.size() );
+  } catch ( std::runtime_error& ) {
+    thrown = true;
+  }
+  CHECK( thrown );
+
+  remove( fn );
+  printf( "test_EventView: OK\n" );
+  return 0;
+}
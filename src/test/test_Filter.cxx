@@ -0,0 +1,143 @@
+// checks that LSEReader returns only the events its filter accepts, through
+// every kind of read and in every reader mode, for plain and compressed files
+#include <stdio.h>
+#include <string.h>
+
+#include <iostream>
+#include <stdexcept>
+
+#include "eventFile/LSE_EventFilter.h"
+#include "eventFile/LSE_EventView.h"
+#include "eventFile/LSE_EventBatch.h"
+#include "test_events.h"
+
+using namespace eventFile;
+
+static const unsigned N = 2000;
+
+static unsigned eventNumber( unsigned long long sequence )
+{
+  return static_cast< unsigned >( ( sequence - 5000000ULL ) / 2 );
+}
+
+// every third event
+class EveryThird : public LSE_EventFilter {
+public:
+  bool accept( const LSE_EventView& view )
+  {
+    CHECK( view.ctx().scalers.sequence >= 5000000ULL );
+    return eventNumber( view.ctx().scalers.sequence ) % 3 == 1;
+  }
+};
+
+static void checkFile( const char* fn, LSEReader::IOMode mode )
+{
+  // full reads of one kind of meta-info
+  {
+    LSEReader r( fn, mode, 3, 5000 );
+    LSE_InfoTypeFilter f( LSE_Info::LCI_CAL );
+    r.setFilter( &f );
+    testEvents::Event e;
+    unsigned n = 0;
+    while ( e.read( r ) ) {
+      unsigned i = eventNumber( e.ctx.scalers.sequence );
+      CHECK( i % 10 == 8 );
+      testEvents::verify( e, i );
+      n++;
+    }
+    CHECK( n == N / 10 );
+    CHECK( r.filterStats().accepted == N / 10 && r.filterStats().rejected == N - N / 10 );
+    CHECK( r.filterStats().skippedBytes > 0 );
+  }
+
+  // reads without the EBF, and of the context alone
+  {
+    LSEReader r( fn, mode, 3, 5000 );
+    EveryThird f;
+    r.setFilter( &f );
+    testEvents::Event e;
+    unsigned n = 0;
+    while ( r.read( e.ctx, e.itype, e.pinfo, e.ainfo, e.cinfo, e.tinfo, e.ktype, e.pakeys, e.cikeys ) ) {
+      unsigned i = eventNumber( e.ctx.scalers.sequence );
+      CHECK( i % 3 == 1 );
+      testEvents::makeEBF( e.ebf, i );
+      testEvents::verify( e, i );
+      n++;
+    }
+    CHECK( n == ( N + 1 ) / 3 );
+  }
+  {
+    LSEReader r( fn, mode, 3, 5000 );
+    EveryThird f;
+    r.setFilter( &f );
+    LSE_Context ctx;
+    unsigned n = 0;
+    while ( r.readContext( ctx ) ) n++;
+    CHECK( n == ( N + 1 ) / 3 );
+  }
+
+  // batches of one handler's state, and a seek that lands on a rejected event
+  {
+    LSEReader r( fn, mode, 3, 5000 );
+    LSE_HandlerFilter f( LPA_Handler::GAMMA, LPA_Handler::LEAKED );
+    r.setFilter( &f );
+    LSE_EventBatch batch;
+    unsigned n = 0;
+    while ( r.readBatch( batch, 50 ) ) {
+      for ( size_t k = 0; k < batch.size(); k++ ) {
+	unsigned i = eventNumber( batch.sequence[k] );
+	CHECK( i % 10 < 7 && i % 5 == LPA_Handler::LEAKED );
+	EBF_Data ebf;
+	testEvents::makeEBF( ebf, i );
+	CHECK( batch.ebfSize( k ) == ebf.size() );
+      }
+      n += batch.size();
+    }
+    CHECK( n == N / 10 );
+    CHECK( r.seekSequence( 5000000ULL + 2 * 1000 ) );
+    testEvents::Event e;
+    CHECK( e.read( r ) && eventNumber( e.ctx.scalers.sequence ) == 1003 );
+  }
+
+  // and a prescaler no event went through
+  {
+    LSEReader r( fn, mode );
+    LSE_HandlerFilter f( LPA_Handler::GAMMA, LPA_Handler::LEAKED, LPA_Handler::INPUT );
+    r.setFilter( &f );
+    testEvents::Event e;
+    CHECK( !e.read( r ) );
+  }
+}
+
+int main( int, char** )
+{
+  const char* fn = "test_Filter.evt";
+  static const LSEReader::IOMode modes[] = {
+    LSEReader::STDIO, LSEReader::MMAP, LSEReader::PREFETCH, LSEReader::URING
+  };
+  for ( int layout = 0; layout < 2; layout++ ) {
+    try {
+      LSEWriter w( fn, 1 );
+      if ( layout == 1 ) {
+	w.enableBlocks( 64 );
+	w.enableCompression( 1 );
+	w.enableContextDelta();
+      }
+      testEvents::writeEvents( w, N );
+    } catch ( std::runtime_error& e ) {
+      if ( !testEvents::unsupported( e ) ) throw;
+      continue;
+    }
+    for ( size_t m = 0; m < sizeof modes / sizeof modes[0]; m++ ) {
+      try {
+	checkFile( fn, modes[m] );
+      } catch ( std::runtime_error& e ) {
+	if ( !testEvents::unsupported( e ) ) throw;
+      }
+    }
+    printf( "test_Filter: layout %d OK\n", layout );
+  }
+  remove( fn );
+  printf( "test_Filter: OK\n" );
+  return 0;
+}
@@ -0,0 +1,61 @@
+// checks that the index LSEWriter writes holds, for every event, the offset
+// and length of its record in the event file and the fields it summarizes,
+// and that its lookups and the reader's seeks through it land on the event
+#include <stdio.h>
+#include <string.h>
+
+#include <iostream>
+#include <stdexcept>
+
+#include "eventFile/LSE_Index.h"
+#include "eventFile/LSE_EventView.h"
+#include "test_events.h"
+
+using namespace eventFile;
+
+static const unsigned N = 2000;
+
+int main( int, char** )
+{
+  const char* fn = "test_Index.evt";
+  std::vector< unsigned long long > ofs;
+  {
+    LSEWriter w( fn, 42 );
+    w.enableIndex();
+    testEvents::writeEvents( w, N, ofs );
+  }
+
+  LSE_Index idx( LSE_Index::name( fn ) );
+  CHECK( idx.size() == N && idx.runid() == 42 );
+  for ( unsigned i = 0; i < N; i++ ) {
+    const LSE_IndexEntry& e = idx[i];
+    LSE_Context c;
+    testEvents::makeContext( c, i );
+    CHECK( e.offset == ofs[i] && e.length == ofs[i+1] - ofs[i] );
+    CHECK( e.sequence == c.scalers.sequence && e.timeSecs == c.current.timeSecs );
+    CHECK( e.infotype == ( i % 10 < 7 ? LSE_Info::LPA : i % 10 == 7 ? LSE_Info::LCI_ACD :
+			   i % 10 == 8 ? LSE_Info::LCI_CAL : LSE_Info::LCI_TKR ) );
+    CHECK( e.keystype == ( i % 10 < 7 ? LSE_Keys::LPA : LSE_Keys::LCI ) );
+  }
+
+  // lookups: events are two sequence numbers and a tenth of a second apart
+  CHECK( idx.lowerSequence( 0 ) == 0 && idx.lowerSequence( 5000000ULL + 2 * N ) == N );
+  CHECK( idx.lowerSequence( 5000000ULL + 2 * 123 ) == 123 );
+  CHECK( idx.lowerSequence( 5000000ULL + 2 * 123 + 1 ) == 124 );
+  CHECK( idx.lowerTime( 0 ) == 0 && idx.lowerTime( 250000000 + N / 10 ) == N );
+  CHECK( idx.lowerTime( 250000000 + 37 ) == 370 );
+
+  // the reader uses the index, and every offset in it starts an event
+  LSEReader r( fn );
+  CHECK( r.loadIndex() && r.index() && r.index()->size() == N );
+  testEvents::Event e;
+  for ( unsigned i = 0; i < N; i += 97 ) {
+    CHECK( r.seek( idx[i].offset ) == 0 && e.read( r ) );
+    testEvents::verify( e, i );
+  }
+
+  remove( LSE_Index::name( fn ).c_str() );
+  remove( fn );
+  printf( "test_Index: OK\n" );
+  return 0;
+}
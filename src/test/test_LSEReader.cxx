@@ -73,7 +73,7 @@ int main( int argc, char* argv[] )
     printf( "==========================================\n" );
     printf( "\nEvent %lld context:", ctx.scalers.sequence );
     printf( "\n------------------\n" );
-    ctx.dump();
+    ctx.dump( pLSE->meta() );
 
     // print out the event-type-specific information
     printf( "\nEvent %lld info:", ctx.scalers.sequence );
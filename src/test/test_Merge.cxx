@@ -0,0 +1,214 @@
+// runs writeMerge over chunk files of every encoding and checks that the
+// merged files hold the indexed events, and that copying the records,
+// decoding them and reading them on threads all give the same bytes
+//
+// usage: test_Merge [path to writeMerge]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include "eventFile/LSE_Index.h"
+#include "test_events.h"
+
+using namespace eventFile;
+
+static const unsigned NF = 4;    // chunk files
+static const unsigned N = 400;   // events per chunk file
+
+static std::string writeMerge = "./writeMerge";
+
+static std::string slurp( const std::string& fn )
+{
+  std::ifstream in( fn.c_str(), std::ios::binary );
+  std::ostringstream out;
+  out << in.rdbuf();
+  return out.str();
+}
+
+// merge the chunks under the given environment, returning the names of the
+// output files and, as one string, their names and contents
+static std::string merge( const std::string& env, const std::string& tag, std::vector< std::string >& outputs,
+			  const std::string& latc = "" )
+{
+  std::string log = "test_Merge_" + tag + ".log";
+  std::string cmd = env + " " + writeMerge + " test_Merge.idx test_Merge_" + tag + "_%u_%llu.evt 9 300 "
+    + latc + " > " + log;
+  CHECK( system( cmd.c_str() ) == 0 );
+
+  // the log names each file written
+  outputs.clear();
+  std::string all, line;
+  std::ifstream in( log.c_str() );
+  const std::string wrote = "writeMerge: wrote ";
+  while ( getline( in, line ) ) {
+    if ( line.find( wrote ) != 0 ) continue;
+    std::string fn = line.substr( line.find( " events to " ) + 11 );
+    outputs.push_back( fn );
+    all += fn.substr( std::string( "test_Merge_" + tag ).size() ) + "\n" + slurp( fn );
+  }
+  in.close();
+  remove( log.c_str() );
+  CHECK( !outputs.empty() );
+  return all;
+}
+
+// writeMerge fails under the given environment, saying why
+static void fails( const std::string& env, const std::string& idx, const std::string& why )
+{
+  std::string log = "test_Merge_fails.log";
+  std::string cmd = env + " " + writeMerge + " " + idx + " test_Merge_fails_%u_%llu.evt 9 > " + log;
+  CHECK( system( cmd.c_str() ) != 0 );
+  std::ifstream in( log.c_str() );
+  std::string all, line, wrote;
+  while ( getline( in, line ) ) {
+    all += line + "\n";
+    if ( line.find( "writeMerge: created output file " ) == 0 ) wrote = line.substr( 32 );
+  }
+  in.close();
+  CHECK( all.find( why ) != std::string::npos );
+  remove( log.c_str() );
+  if ( !wrote.empty() ) remove( wrote.c_str() );
+  printf( "test_Merge: %s fails OK\n", env.c_str() );
+}
+
+static void removeAll( const std::vector< std::string >& outputs )
+{
+  for ( size_t k = 0; k < outputs.size(); k++ ) remove( outputs[k].c_str() );
+}
+
+// the same bytes as base under another environment
+static void same( const std::string& base, const std::string& env, const std::string& tag,
+		  const std::string& latc = "" )
+{
+  std::vector< std::string > outputs;
+  CHECK( merge( env, tag, outputs, latc ) == base );
+  removeAll( outputs );
+  printf( "test_Merge: %s OK\n", env.c_str() );
+}
+
+int main( int argc, char* argv[] )
+{
+  if ( argc > 1 ) writeMerge = argv[1];
+
+  // chunk files stored plainly, in blocks, and encoded
+  std::vector< std::vector< unsigned long long > > ofs( NF );
+  std::vector< std::string > chunks;
+  for ( unsigned f = 0; f < NF; f++ ) {
+    std::ostringstream fn;
+    fn << "test_Merge_chunk" << f << ".evt";
+    chunks.push_back( fn.str() );
+    LSEWriter w( fn.str(), 9 );
+    if ( f == 1 ) w.enableIndex();
+    if ( f == 2 ) w.enableBlocks( 64 );
+    if ( f == 3 ) {
+      w.enableContextDelta();
+      w.enableHandlerTable();
+    }
+    testEvents::writeEvents( w, N, ofs[f], f * N );
+  }
+
+  // runs of adjacent events out of the chunks, interleaved, now and then
+  // out of order
+  std::vector< unsigned > expected;
+  {
+    std::ofstream idx( "test_Merge.idx" );
+    idx << "HDR: not an event\n";
+    unsigned pos[NF] = { 0 };
+    srand( 3 );
+    for ( unsigned k = 0; k < 300; k++ ) {
+      unsigned f = rand() % NF;
+      unsigned run = 1 + rand() % 12;
+      for ( unsigned j = 0; j < run && pos[f] < N; j++, pos[f]++ ) {
+	unsigned i = ( rand() % 17 == 0 && pos[f] + 1 < N ) ? pos[f] + 1 : pos[f];
+	unsigned n = f * N + i;
+	expected.push_back( n );
+	idx << "EVT: 249999999 " << 5000000ULL + 2 * n << " 956 1 START CONTINUE ";
+	idx << ofs[f][i] << " " << chunks[f] << "\n";
+      }
+    }
+  }
+
+  // the merged files hold the indexed events, in order
+  std::vector< std::string > outputs;
+  std::string base = merge( "", "base", outputs );
+  size_t k = 0;
+  for ( size_t o = 0; o < outputs.size(); o++ ) {
+    LSEReader r( outputs[o] );
+    testEvents::Event e;
+    while ( e.read( r ) ) {
+      CHECK( k < expected.size() );
+      testEvents::verify( e, expected[k++] );
+    }
+  }
+  CHECK( k == expected.size() );
+  removeAll( outputs );
+  printf( "test_Merge: %u events in %u files OK\n", static_cast< unsigned >( k ),
+	  static_cast< unsigned >( outputs.size() ) );
+
+  // copied, read record by record, decoded, staged, and read on threads
+  same( base, "WRITEMERGE_NOCOPY=1", "nocopy" );
+  same( base, "WRITEMERGE_DECODE=1", "decode" );
+  same( base, "WRITEMERGE_STAGEBUF=65536", "staged" );
+  same( base, "LSEWRITER_ASYNC=8", "async" );
+  same( base, "WRITEMERGE_THREADS=3", "threads" );
+  same( base, "WRITEMERGE_THREADS=2 WRITEMERGE_NOCOPY=1", "threadsnc" );
+  same( base, "WRITEMERGE_LOOKAHEAD=32", "lookahead" );
+  same( base, "WRITEMERGE_MAXOPEN=1", "maxopen" );
+  same( base, "WRITEMERGE_MAXOPEN=1 WRITEMERGE_THREADS=3", "maxopenthr" );
+  same( base, "WRITEMERGE_MAXOPEN=2 WRITEMERGE_LOOKAHEAD=32 WRITEMERGE_THREADS=2", "maxopenla" );
+
+  // encoded output, and a patched LATC key, copied or decoded
+  std::string enc = merge( "LSEWRITER_HANDLERS=1 LSEWRITER_CTXDELTA=1", "enc", outputs );
+  removeAll( outputs );
+  CHECK( enc != base );
+  same( enc, "LSEWRITER_HANDLERS=1 LSEWRITER_CTXDELTA=1 WRITEMERGE_DECODE=1", "encdec" );
+  same( enc, "LSEWRITER_HANDLERS=1 LSEWRITER_CTXDELTA=1 WRITEMERGE_THREADS=2", "encthr" );
+  std::string latc = merge( "", "latc", outputs, "0x777" );
+  removeAll( outputs );
+  CHECK( latc != base );
+  same( latc, "WRITEMERGE_DECODE=1", "latcdec", "0x777" );
+  same( latc, "WRITEMERGE_THREADS=3", "latcthr", "0x777" );
+
+  // a record whose meta-info type no decode could write is refused, not
+  // copied as it stands
+  {
+    unsigned long long at[4];
+    {
+      LSEWriter w( "test_Merge_bad.evt", 9 );
+      for ( unsigned i = 0; i < 3; i++ ) {
+	at[i] = w.tell();
+	testEvents::writeEvents( w, 1, i );
+      }
+      at[3] = w.tell();
+    }
+    LSE_Context ctx;
+    testEvents::makeContext( ctx, 3 );
+    int record[] = { 0, 7, LSE_Keys::LCI, 1, 2, 3 };
+    FILE* fp = fopen( "test_Merge_bad.evt", "ab" );
+    CHECK( fwrite( &ctx, sizeof ctx, 1, fp ) == 1 && fwrite( record, sizeof record, 1, fp ) == 1 );
+    fclose( fp );
+    std::ofstream idx( "test_Merge_bad.idx" );
+    for ( unsigned i = 0; i < 4; i++ ) {
+      idx << "EVT: 249999999 " << 5000000ULL + 2 * i << " 956 1 START CONTINUE ";
+      idx << at[i] << " test_Merge_bad.evt\n";
+    }
+  }
+  fails( "", "test_Merge_bad.idx", "unknown LSE_Info type 7" );
+  fails( "WRITEMERGE_THREADS=2", "test_Merge_bad.idx", "unknown LSE_Info type 7" );
+  fails( "WRITEMERGE_DECODE=1", "test_Merge_bad.idx", "unknown LSE_Info type 7" );
+  remove( "test_Merge_bad.evt" );
+  remove( "test_Merge_bad.idx" );
+
+  for ( unsigned f = 0; f < NF; f++ ) {
+    remove( chunks[f].c_str() );
+    remove( LSE_Index::name( chunks[f] ).c_str() );
+  }
+  remove( "test_Merge.idx" );
+  printf( "test_Merge: OK\n" );
+  return 0;
+}
@@ -0,0 +1,121 @@
+// checks that files with different MOOT keys read side by side, in turn or
+// on threads of their own, each report their own through the readers and
+// the views, and that reading never rewrites the LSEHeader statics
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <iostream>
+#include <stdexcept>
+
+#include "eventFile/LSE_EventView.h"
+#include "eventFile/LSEHeader.h"
+#include "test_events.h"
+
+using namespace eventFile;
+
+static const unsigned N = 2000;
+static const char* files[]   = { "test_MootKey_a.evt", "test_MootKey_b.evt" };
+static const char* keys[]    = { "0x1234", "0x5678" };
+static const unsigned key[]  = { 0x1234, 0x5678 };
+static const char* aliases[] = { "alias_a", "alias_b" };
+
+static void checkMeta( const LSEHeaderMeta& meta, int f )
+{
+  CHECK( meta.moot_key() == key[f] );
+  CHECK( strcmp( meta.moot_alias(), aliases[f] ) == 0 );
+}
+
+// every event of one file through every kind of read, each checked against
+// the key of the reader it came from
+static void readAll( LSEReader& r, int f, unsigned statics )
+{
+  testEvents::Event e;
+  LSE_Context ctx;
+  LSE_EventView view;
+  unsigned n = 0;
+  for ( ;; n++ ) {
+    bool more;
+    switch ( n % 4 ) {
+    case 0:
+      more = e.read( r );
+      break;
+    case 1:
+      more = r.read( e.ctx, e.itype, e.pinfo, e.ainfo, e.cinfo, e.tinfo, e.ktype, e.pakeys, e.cikeys );
+      break;
+    case 2:
+      more = r.readContext( ctx );
+      break;
+    default:
+      more = r.read( view );
+      if ( more ) {
+	CHECK( view.mootKey() == key[f] && strcmp( view.mootAlias(), aliases[f] ) == 0 );
+      }
+      break;
+    }
+    if ( !more ) break;
+    checkMeta( r.meta(), f );
+    CHECK( LSEHeader::moot_key() == statics );
+  }
+  CHECK( n == N );
+}
+
+struct Job {
+  int      f;
+  unsigned statics;
+};
+
+static void* readThread( void* arg )
+{
+  const Job* job = static_cast< const Job* >( arg );
+  for ( int pass = 0; pass < 4; pass++ ) {
+    LSEReader r( files[job->f], job->f ? LSEReader::MMAP : LSEReader::STDIO );
+    readAll( r, job->f, job->statics );
+  }
+  return NULL;
+}
+
+int main( int, char** )
+{
+  // writers leave the statics alone
+  for ( int f = 0; f < 2; f++ ) {
+    setenv( "LSEWRITER_MOOTKEY", keys[f], 1 );
+    setenv( "LSEWRITER_MOOTALIAS", aliases[f], 1 );
+    LSEWriter w( files[f], 1 );
+    testEvents::writeEvents( w, N );
+    CHECK( w.mootKey() == key[f] );
+  }
+  CHECK( LSEHeader::moot_key() == 0xFFFFFFFF );
+
+  // the first file read fills them, once; the second does not
+  LSEReader* r[2];
+  for ( int f = 0; f < 2; f++ ) {
+    r[f] = new LSEReader( files[f], f ? LSEReader::MMAP : LSEReader::STDIO );
+    checkMeta( r[f]->meta(), f );
+  }
+  CHECK( LSEHeader::moot_key() == key[0] && strcmp( LSEHeader::moot_alias(), aliases[0] ) == 0 );
+
+  // in turn
+  for ( int f = 0; f < 2; f++ ) {
+    readAll( *r[f], f, key[0] );
+    delete r[f];
+  }
+
+  // and at once, each reader on its own thread
+  Job jobs[2];
+  pthread_t threads[2];
+  for ( int f = 0; f < 2; f++ ) {
+    jobs[f].f = f;
+    jobs[f].statics = key[0];
+    CHECK( pthread_create( &threads[f], NULL, readThread, &jobs[f] ) == 0 );
+  }
+  for ( int f = 0; f < 2; f++ ) {
+    CHECK( pthread_join( threads[f], NULL ) == 0 );
+  }
+  CHECK( LSEHeader::moot_key() == key[0] );
+
+  for ( int f = 0; f < 2; f++ ) remove( files[f] );
+  printf( "test_MootKey: OK\n" );
+  return 0;
+}
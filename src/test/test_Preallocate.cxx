@@ -0,0 +1,72 @@
+// checks that the space LSEWriter::preallocate() reserves is used by the
+// events and that close() gives back what they did not use, in every output
+// mode, with the file reading back unchanged
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <iostream>
+#include <stdexcept>
+
+#include "test_events.h"
+
+using namespace eventFile;
+
+static const unsigned N = 1000;
+
+// far more than N events need
+static const unsigned long long RESERVE = 64ULL * 1024 * 1024;
+
+// bytes the file occupies on disk, rounded up to the filesystem's blocks
+static unsigned long long onDisk( const char* fn, unsigned long long& size )
+{
+  struct stat stbuf;
+  CHECK( stat( fn, &stbuf ) == 0 );
+  size = stbuf.st_size;
+  return static_cast< unsigned long long >( stbuf.st_blocks ) * 512;
+}
+
+int main( int, char** )
+{
+  const char* fn = "test_Preallocate.evt";
+  static const LSEWriter::IOMode modes[] = { LSEWriter::STDIO, LSEWriter::STAGED, LSEWriter::URING };
+  for ( size_t m = 0; m < sizeof modes / sizeof modes[0]; m++ ) {
+    for ( int blocked = 0; blocked < 2; blocked++ ) {
+      LSEWriter* w = NULL;
+      try {
+	w = new LSEWriter( fn, 1, modes[m] );
+      } catch ( std::runtime_error& e ) {
+	if ( !testEvents::unsupported( e ) ) throw;
+	continue;
+      }
+      if ( blocked ) w->enableBlocks( 64 );
+      if ( !w->preallocate( RESERVE ) ) {
+	// nothing to check where space cannot be reserved
+	delete w;
+	printf( "test_Preallocate: not supported here\n" );
+	remove( fn );
+	return 0;
+      }
+
+      // the reserve is held while the file is written, without growing it
+      unsigned long long size;
+      CHECK( onDisk( fn, size ) >= RESERVE && size < RESERVE );
+      testEvents::writeEvents( *w, N );
+      w->close();
+      delete w;
+
+      // and given back on close
+      unsigned long long used = onDisk( fn, size );
+      CHECK( used < size + 1024 * 1024 );
+      LSEReader r( fn );
+      CHECK( r.evtcnt() == N );
+      testEvents::verifyFile( r, N );
+      printf( "test_Preallocate: mode %d %s OK (%llu bytes, %llu on disk)\n",
+	      static_cast< int >( m ), blocked ? "blocked" : "plain", size, used );
+    }
+  }
+  remove( fn );
+  printf( "test_Preallocate: OK\n" );
+  return 0;
+}
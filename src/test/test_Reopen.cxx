@@ -0,0 +1,101 @@
+// checks that LSEReader and LSE_PositionalReader keep what they read of an
+// unchanged file across close() and reopen(), and read it again when the
+// file was rewritten, even to the same size within the same second where
+// the platform keeps the modification time to the nanosecond
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <iostream>
+#include <stdexcept>
+
+#include "eventFile/LSE_EventView.h"
+#include "eventFile/LSE_PositionalReader.h"
+#include "test_events.h"
+
+using namespace eventFile;
+
+static std::vector< unsigned long long > ofs;
+
+// write n events from base under the given MOOT key, stamped with the
+// given nanosecond of one fixed second
+static void writeFile( const char* fn, unsigned n, unsigned base, bool delta, const char* key, long nsec )
+{
+  setenv( "LSEWRITER_MOOTKEY", key, 1 );
+  {
+    LSEWriter w( fn, 9 );
+    if ( delta ) w.enableContextDelta();
+    testEvents::writeEvents( w, n, ofs, base );
+  }
+  struct timespec times[2];
+  times[0].tv_sec = times[1].tv_sec = 1700000000;
+  times[0].tv_nsec = times[1].tv_nsec = nsec;
+  CHECK( utimensat( AT_FDCWD, fn, times, 0 ) == 0 );
+}
+
+#ifdef HAVE_ST_MTIM
+static unsigned long long fileSize( const char* fn )
+{
+  struct stat stbuf;
+  CHECK( stat( fn, &stbuf ) == 0 );
+  return stbuf.st_size;
+}
+#endif
+
+int main( int, char** )
+{
+  const char* fn = "test_Reopen.evt";
+  for ( int delta = 0; delta < 2; delta++ ) {
+    writeFile( fn, 50, 0, delta, "0x1234", 100 );
+    LSEReader r( fn );
+    LSE_PositionalReader p( fn );
+    LSE_EventView view;
+    for ( unsigned i = 0; i < 5; i++ ) CHECK( r.read( view ) );
+
+    // unchanged: read again from the first event, and seeks still work
+    r.close();
+    p.close();
+    CHECK( !r.isOpen() && !p.isOpen() );
+    r.reopen();
+    p.reopen();
+    CHECK( r.isOpen() && p.isOpen() );
+    CHECK( r.read( view ) && view.ctx().scalers.sequence == 5000000ULL );
+    CHECK( r.seek( ofs[4] ) == 0 && r.read( view ) && view.ctx().scalers.sequence == 5000000ULL + 2 * 4 );
+    CHECK( r.evtcnt() == 50 && p.evtcnt() == 50 );
+
+#ifdef HAVE_ST_MTIM
+    // rewritten to the same size in the same second, under another key; only
+    // told apart where the modification time has nanoseconds
+    unsigned long long size = fileSize( fn );
+    r.close();
+    p.close();
+    writeFile( fn, 50, 0, delta, "0x5678", 200 );
+    CHECK( fileSize( fn ) == size );
+    r.reopen();
+    p.reopen();
+    CHECK( r.mootKey() == 0x5678 && p.mootKey() == 0x5678 );
+    CHECK( r.read( view ) && view.mootKey() == 0x5678 );
+#endif
+
+    // rewritten with other events
+    r.close();
+    p.close();
+    writeFile( fn, 80, 1000, delta, "0x5678", 300 );
+    r.reopen();
+    p.reopen();
+    CHECK( r.evtcnt() == 80 && p.evtcnt() == 80 );
+    unsigned n = 0;
+    while ( r.read( view ) ) {
+      CHECK( view.ctx().scalers.sequence == 5000000ULL + 2 * ( 1000 + n ) );
+      n++;
+    }
+    CHECK( n == 80 );
+    LSE_PositionalReader::Buffer buf;
+    CHECK( p.read( p.dataOffset(), buf, view ) && view.ctx().scalers.sequence == 5000000ULL + 2 * 1000 );
+    printf( "test_Reopen: %s OK\n", delta ? "delta" : "plain" );
+  }
+  remove( fn );
+  printf( "test_Reopen: OK\n" );
+  return 0;
+}
@@ -0,0 +1,212 @@
+// writes the same events with every LSEWriter mode and option and reads them
+// back with every LSEReader mode, whole and after seeks into their middle
+#include <stdio.h>
+#include <string.h>
+
+#include <iostream>
+#include <stdexcept>
+
+#include "eventFile/LSE_EventView.h"
+#include "eventFile/LSE_EventBatch.h"
+#include "eventFile/LSE_Index.h"
+#include "eventFile/LSE_ContextColumns.h"
+#include "eventFile/LSE_Footer.h"
+#include "eventFile/LSE_PositionalReader.h"
+#include "test_events.h"
+
+using namespace eventFile;
+
+enum {
+  INDEX    = 1 << 0,
+  COLUMNS  = 1 << 1,
+  BLOCKS   = 1 << 2,
+  COMPRESS = 1 << 3,
+  DELTA    = 1 << 4,
+  HANDLERS = 1 << 5,
+  ASYNC    = 1 << 6
+};
+
+struct WriterConfig {
+  const char*       name;
+  LSEWriter::IOMode mode;
+  unsigned          options;
+};
+
+static const WriterConfig writers[] = {
+  { "stdio",                   LSEWriter::STDIO,  0 },
+  { "index",                   LSEWriter::STDIO,  INDEX },
+  { "columns",                 LSEWriter::STDIO,  COLUMNS },
+  { "blocks",                  LSEWriter::STDIO,  BLOCKS },
+  { "compressed",              LSEWriter::STDIO,  COMPRESS },
+  { "delta",                   LSEWriter::STDIO,  DELTA },
+  { "handlers",                LSEWriter::STDIO,  HANDLERS },
+  { "delta+handlers+compress", LSEWriter::STDIO,  DELTA | HANDLERS | COMPRESS | INDEX },
+  { "async",                   LSEWriter::STDIO,  ASYNC },
+  { "async+delta+columns",     LSEWriter::STDIO,  ASYNC | DELTA | COLUMNS | INDEX },
+  { "staged",                  LSEWriter::STAGED, 0 },
+  { "staged+blocks+index",     LSEWriter::STAGED, BLOCKS | INDEX },
+  { "staged+async",            LSEWriter::STAGED, ASYNC | HANDLERS },
+  { "uring",                   LSEWriter::URING,  0 },
+  { "uring+compress+handlers", LSEWriter::URING,  COMPRESS | HANDLERS },
+};
+
+static const LSEReader::IOMode readers[] = {
+  LSEReader::STDIO, LSEReader::MMAP, LSEReader::PREFETCH, LSEReader::URING
+};
+static const char* readerNames[] = { "stdio", "mmap", "prefetch", "uring" };
+
+static const unsigned N = 1000;      // events per file
+static const unsigned BLOCK = 64;    // events per block
+
+// the events to seek to: block edges and the middle of blocks
+static const unsigned targets[] = { 0, 1, 33, 63, 64, 65, 500, 517, 998, 999 };
+
+// write the file, noting the offset of every event; false if the build
+// lacks the mode
+static bool writeFile( const char* fn, const WriterConfig& c, std::vector< unsigned long long >& ofs )
+{
+  LSEWriter* w = NULL;
+  try {
+    w = new LSEWriter( fn, 1, c.mode, 4, 64 * 1024 );
+    if ( c.options & INDEX )    w->enableIndex();
+    if ( c.options & COLUMNS )  w->enableColumns();
+    if ( c.options & BLOCKS )   w->enableBlocks( BLOCK );
+    if ( c.options & ( COMPRESS | DELTA | HANDLERS ) ) w->enableBlocks( BLOCK );
+    if ( c.options & COMPRESS ) w->enableCompression( 1 );
+    if ( c.options & DELTA )    w->enableContextDelta();
+    if ( c.options & HANDLERS ) w->enableHandlerTable();
+    if ( c.options & ASYNC )    w->enableAsync( 16 );
+  } catch ( std::runtime_error& e ) {
+    delete w;
+    if ( testEvents::unsupported( e ) ) return false;
+    throw;
+  }
+  testEvents::writeEvents( *w, N, ofs );
+  w->close();
+  CHECK( w->evtcnt() == N );
+  delete w;
+  return true;
+}
+
+static void readFile( const char* fn, const WriterConfig& c, LSEReader::IOMode mode,
+		      const std::vector< unsigned long long >& ofs )
+{
+  LSEReader* r = NULL;
+  try {
+    r = new LSEReader( fn, mode, 3, 16 * 1024 );
+  } catch ( std::runtime_error& e ) {
+    if ( testEvents::unsupported( e ) ) return;
+    throw;
+  }
+  CHECK( r->evtcnt() == N );
+  testEvents::verifyFile( *r, N );
+
+  // straight to events in the middle of blocks, and back
+  testEvents::Event e;
+  for ( size_t k = 0; k < sizeof targets / sizeof targets[0]; k++ ) {
+    unsigned i = targets[k];
+    CHECK( r->seek( ofs[i] ) == 0 );
+    CHECK( e.read( *r ) );
+    testEvents::verify( e, i );
+    if ( i + 1 < N ) {
+      CHECK( e.read( *r ) );
+      testEvents::verify( e, i + 1 );
+    }
+  }
+  // forwards and backwards within one block
+  static const unsigned within[] = { 130, 131, 140, 135, 190, 128, 191, 129 };
+  for ( size_t k = 0; k < sizeof within / sizeof within[0]; k++ ) {
+    CHECK( r->seek( ofs[ within[k] ] ) == 0 );
+    CHECK( e.read( *r ) );
+    testEvents::verify( e, within[k] );
+  }
+  LSE_Context ctx;
+  testEvents::makeContext( ctx, 517 );
+  CHECK( r->seekSequence( ctx.scalers.sequence ) );
+  CHECK( e.read( *r ) );
+  testEvents::verify( e, 517 );
+  CHECK( r->seekLast() );
+  CHECK( e.read( *r ) );
+  testEvents::verify( e, N - 1 );
+
+  // views and batches see the same events
+  CHECK( r->seek( ofs[0] ) == 0 );
+  LSE_EventView view;
+  for ( unsigned i = 0; i < N; i++ ) {
+    CHECK( r->read( view ) );
+    testEvents::makeContext( ctx, i );
+    CHECK( memcmp( &ctx, &view.ctx(), sizeof ctx ) == 0 );
+  }
+  CHECK( r->seek( ofs[0] ) == 0 );
+  LSE_EventBatch batch;
+  size_t total = 0, n;
+  while ( ( n = r->readBatch( batch, 100 ) ) > 0 ) total += n;
+  CHECK( total == N );
+
+  if ( c.options & INDEX ) {
+    CHECK( r->loadIndex() && r->index()->size() == N );
+  }
+  bool blocked = ( c.options & ( BLOCKS | COMPRESS | DELTA | HANDLERS ) ) != 0;
+  CHECK( ( r->footer() != NULL ) == blocked );
+  if ( blocked ) {
+    CHECK( r->footer()->blocks.size() == ( N + BLOCK - 1 ) / BLOCK );
+  }
+  delete r;
+}
+
+int main( int, char** )
+{
+  const char* fn = "test_RoundTrip.evt";
+  std::vector< unsigned long long > ofs;
+  for ( size_t w = 0; w < sizeof writers / sizeof writers[0]; w++ ) {
+    const WriterConfig& c = writers[w];
+    if ( !writeFile( fn, c, ofs ) ) {
+      printf( "test_RoundTrip: %s writer not supported in this build\n", c.name );
+      continue;
+    }
+    for ( size_t r = 0; r < sizeof readers / sizeof readers[0]; r++ ) {
+      readFile( fn, c, readers[r], ofs );
+      printf( "test_RoundTrip: %s writer, %s reader OK\n", c.name, readerNames[r] );
+    }
+
+    // records read by offset, where they are not compressed
+    if ( !( c.options & COMPRESS ) ) {
+      LSE_PositionalReader p( fn );
+      testEvents::Event e;
+      for ( unsigned i = 0; i < N; i++ ) {
+	CHECK( p.read( ofs[i], e.ctx, e.ebf, e.itype, e.pinfo, e.ainfo, e.cinfo, e.tinfo,
+		       e.ktype, e.pakeys, e.cikeys ) );
+	testEvents::verify( e, i );
+      }
+
+      // and through one buffer, in and out of order
+      static const unsigned order[] = { 5, 6, 40, 20, 63, 64, 66, 65, 999, 130, 131 };
+      LSE_PositionalReader::Buffer buf;
+      LSE_EventView view;
+      LSE_Context ctx;
+      for ( size_t k = 0; k < sizeof order / sizeof order[0]; k++ ) {
+	unsigned long long next;
+	CHECK( p.read( ofs[ order[k] ], buf, view, &next ) );
+	testEvents::makeContext( ctx, order[k] );
+	CHECK( memcmp( &ctx, &view.ctx(), sizeof ctx ) == 0 );
+	CHECK( next == ofs[ order[k] + 1 ] );
+      }
+    }
+
+    if ( c.options & COLUMNS ) {
+      LSE_ContextColumns cols;
+      cols.load( LSE_ContextColumns::name( fn ) );
+      CHECK( cols.size() == N );
+      LSE_Context ctx;
+      for ( unsigned i = 0; i < N; i++ ) {
+	testEvents::makeContext( ctx, i );
+	CHECK( cols.sequence[i] == ctx.scalers.sequence );
+      }
+    }
+    remove( LSE_Index::name( fn ).c_str() );
+    remove( LSE_ContextColumns::name( fn ).c_str() );
+  }
+  remove( fn );
+  printf( "test_RoundTrip: OK\n" );
+  return 0;
+}
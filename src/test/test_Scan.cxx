@@ -0,0 +1,102 @@
+// checks that forEachEvent() hands every event to exactly one worker, in file
+// order within each, for plain, indexed and blocked files
+#include <stdio.h>
+#include <string.h>
+
+#include <iostream>
+#include <stdexcept>
+
+#include "eventFile/LSE_Scan.h"
+#include "eventFile/LSE_EventView.h"
+#include "eventFile/LSE_Index.h"
+#include "test_events.h"
+
+using namespace eventFile;
+
+static const unsigned N = 3000;
+static const unsigned MAXTHREADS = 8;
+
+// event numbers seen by each worker, checked against the context as they come
+class Collector : public LSE_EventVisitor {
+public:
+  Collector() : m_seen( MAXTHREADS ) {};
+  void visit( const LSE_EventView& view, unsigned worker )
+  {
+    CHECK( worker < MAXTHREADS );
+    unsigned i = ( view.ctx().scalers.sequence - 5000000ULL ) / 2;
+    LSE_Context ctx;
+    testEvents::makeContext( ctx, i );
+    CHECK( memcmp( &ctx, &view.ctx(), sizeof ctx ) == 0 );
+    CHECK( view.infotype() == ( i % 10 < 7 ? LSE_Info::LPA : i % 10 == 7 ? LSE_Info::LCI_ACD :
+				i % 10 == 8 ? LSE_Info::LCI_CAL : LSE_Info::LCI_TKR ) );
+    m_seen[worker].push_back( i );
+  }
+  void check( unsigned long long visited ) const
+  {
+    CHECK( visited == N );
+    std::vector< unsigned > count( N );
+    for ( size_t w = 0; w < m_seen.size(); w++ ) {
+      for ( size_t k = 0; k < m_seen[w].size(); k++ ) {
+	CHECK( m_seen[w][k] < N );
+	CHECK( k == 0 || m_seen[w][k] == m_seen[w][k-1] + 1 );
+	count[ m_seen[w][k] ]++;
+      }
+    }
+    for ( unsigned i = 0; i < N; i++ ) CHECK( count[i] == 1 );
+  }
+  unsigned workers() const
+  {
+    unsigned n = 0;
+    for ( size_t w = 0; w < m_seen.size(); w++ ) n += !m_seen[w].empty();
+    return n;
+  }
+private:
+  std::vector< std::vector< unsigned > > m_seen;
+};
+
+// gives up on one event
+class Thrower : public LSE_EventVisitor {
+public:
+  void visit( const LSE_EventView& view, unsigned )
+  {
+    if ( view.ctx().scalers.sequence == 5000000ULL + 2 * ( N / 2 ) ) {
+      throw std::runtime_error( "test_Scan: visitor failed" );
+    }
+  }
+};
+
+int main( int, char** )
+{
+  const char* fn = "test_Scan.evt";
+  for ( int layout = 0; layout < 4; layout++ ) {
+    {
+      LSEWriter w( fn, 1 );
+      if ( layout == 1 ) w.enableIndex();
+      if ( layout >= 2 ) w.enableBlocks( 100 );
+      if ( layout == 3 ) w.enableContextDelta();
+      testEvents::writeEvents( w, N );
+    }
+    const unsigned threads[] = { 1, 3, MAXTHREADS };
+    for ( size_t t = 0; t < sizeof threads / sizeof threads[0]; t++ ) {
+      for ( int mode = 0; mode < 2; mode++ ) {
+	Collector c;
+	c.check( forEachEvent( fn, threads[t], c, mode ? LSEReader::MMAP : LSEReader::STDIO ) );
+	CHECK( c.workers() <= threads[t] && ( threads[t] == 1 || c.workers() > 1 ) );
+      }
+    }
+
+    bool thrown = false;
+    try {
+      Thrower v;
+      forEachEvent( fn, 4, v );
+    } catch ( std::runtime_error& e ) {
+      thrown = strcmp( e.what(), "test_Scan: visitor failed" ) == 0;
+    }
+    CHECK( thrown );
+    remove( LSE_Index::name( fn ).c_str() );
+    printf( "test_Scan: layout %d OK\n", layout );
+  }
+  remove( fn );
+  printf( "test_Scan: OK\n" );
+  return 0;
+}
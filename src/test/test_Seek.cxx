@@ -0,0 +1,66 @@
+// checks that seekSequence(), seekTime() and seekLast() leave the reader at
+// the right event whether they scan the file, search its index or search
+// the footer of a blocked file, in every reader mode
+#include <stdio.h>
+#include <string.h>
+
+#include <iostream>
+#include <stdexcept>
+
+#include "eventFile/LSE_Index.h"
+#include "eventFile/LSE_EventView.h"
+#include "test_events.h"
+
+using namespace eventFile;
+
+static const unsigned N = 2000;
+
+// the number of the event the reader reads next, or N at end of file
+static unsigned next( LSEReader& r )
+{
+  LSE_EventView view;
+  if ( !r.read( view ) ) return N;
+  return static_cast< unsigned >( ( view.ctx().scalers.sequence - 5000000ULL ) / 2 );
+}
+
+int main( int, char** )
+{
+  const char* fn = "test_Seek.evt";
+  static const char* layouts[] = { "scanned", "indexed", "blocked" };
+  static const LSEReader::IOMode modes[] = { LSEReader::STDIO, LSEReader::MMAP, LSEReader::PREFETCH };
+  for ( int layout = 0; layout < 3; layout++ ) {
+    {
+      LSEWriter w( fn, 1 );
+      if ( layout == 1 ) w.enableIndex();
+      if ( layout == 2 ) w.enableBlocks( 64 );
+      testEvents::writeEvents( w, N );
+    }
+    if ( layout != 1 ) remove( LSE_Index::name( fn ).c_str() );
+
+    for ( size_t m = 0; m < sizeof modes / sizeof modes[0]; m++ ) {
+      LSEReader r( fn, modes[m] );
+
+      // by sequence: on an event, between two, before the first, past the last
+      CHECK( r.seekSequence( 5000000ULL + 2 * 777 ) && next( r ) == 777 && next( r ) == 778 );
+      CHECK( r.seekSequence( 5000000ULL + 2 * 64 + 1 ) && next( r ) == 65 );
+      CHECK( r.seekSequence( 0 ) && next( r ) == 0 );
+      CHECK( r.seekSequence( 5000000ULL + 2 * ( N - 1 ) ) && next( r ) == N - 1 && next( r ) == N );
+      CHECK( !r.seekSequence( 5000000ULL + 2 * N ) && next( r ) == N );
+
+      // by time: ten events to the second, the first of them found
+      CHECK( r.seekTime( 250000000 + 123 ) && next( r ) == 1230 );
+      CHECK( r.seekTime( 0 ) && next( r ) == 0 );
+      CHECK( !r.seekTime( 250000000 + N / 10 ) && next( r ) == N );
+
+      // to the last event, and on from there
+      CHECK( r.seekLast() && next( r ) == N - 1 && next( r ) == N );
+      CHECK( r.seekSequence( 5000000ULL + 2 * 10 ) && next( r ) == 10 );
+    }
+    printf( "test_Seek: %s OK\n", layouts[layout] );
+  }
+
+  remove( LSE_Index::name( fn ).c_str() );
+  remove( fn );
+  printf( "test_Seek: OK\n" );
+  return 0;
+}
@@ -0,0 +1,72 @@
+// checks that a blocked file whose writer died before close() says v10 in
+// its header and is refused by the readers, rather than read as v9 events
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <iostream>
+#include <stdexcept>
+
+#include "eventFile/LSE_PositionalReader.h"
+#include "test_events.h"
+
+using namespace eventFile;
+
+static const unsigned N = 500;
+
+// what the reader's constructor throws, or "" if it opens the file
+template< class Reader > static std::string openError( const char* fn )
+{
+  try {
+    Reader r( fn );
+  } catch ( std::runtime_error& e ) {
+    return e.what();
+  }
+  return "";
+}
+
+int main( int, char** )
+{
+  const char* fn = "test_Unfinished.evt";
+  for ( int layout = 0; layout < 3; layout++ ) {
+    // the writer is killed, in effect, part way through the file
+    pid_t pid = fork();
+    CHECK( pid >= 0 );
+    if ( pid == 0 ) {
+      try {
+	LSEWriter* w = new LSEWriter( fn, 1 );
+	w->enableBlocks( 64 );
+	if ( layout == 1 ) w->enableCompression( 1 );
+	if ( layout == 2 ) {
+	  w->enableContextDelta();
+	  w->enableHandlerTable();
+	}
+	testEvents::writeEvents( *w, N );
+      } catch ( std::runtime_error& e ) {
+	_exit( testEvents::unsupported( e ) ? 2 : 1 );
+      }
+      _exit( 0 );
+    }
+    int status;
+    CHECK( waitpid( pid, &status, 0 ) == pid && WIFEXITED( status ) );
+    if ( WEXITSTATUS( status ) == 2 ) continue;
+    CHECK( WEXITSTATUS( status ) == 0 );
+
+    // the header was marked before the first event
+    FILE* fp = fopen( fn, "rb" );
+    unsigned head[2];
+    CHECK( fp && fread( head, sizeof head, 1, fp ) == 1 );
+    fclose( fp );
+    CHECK( head[0] == 0xFAF32000 && head[1] == 0x0A0A0A0A );
+
+    std::string error = openError< LSEReader >( fn );
+    CHECK( error.find( "no block footer" ) != std::string::npos );
+    error = openError< LSE_PositionalReader >( fn );
+    CHECK( error.find( "no block footer" ) != std::string::npos );
+    printf( "test_Unfinished: layout %d OK\n", layout );
+  }
+  remove( fn );
+  printf( "test_Unfinished: OK\n" );
+  return 0;
+}
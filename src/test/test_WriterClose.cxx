@@ -0,0 +1,105 @@
+// checks that LSEWriter finishes the event file and releases everything
+// when a step of close() fails, throwing from close() but not from the
+// destructor
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <iostream>
+#include <stdexcept>
+
+#include "eventFile/LSE_ContextColumns.h"
+#include "test_events.h"
+
+using namespace eventFile;
+
+// few enough events that the index only fails when close() flushes it
+static const unsigned N = 100;
+
+// close() the writer, returning the error it threw or "" if none
+static std::string closeError( LSEWriter& w )
+{
+  try {
+    w.close();
+  } catch ( std::runtime_error& e ) {
+    return e.what();
+  }
+  return "";
+}
+
+int main( int, char** )
+{
+  const char* fn = "test_WriterClose.evt";
+
+  // an index that cannot be written, dropped by the destructor
+  {
+    LSEWriter w( fn, 1 );
+    w.enableIndex( "/dev/full" );
+    testEvents::writeEvents( w, N );
+  }
+  {
+    LSEReader r( fn );
+    CHECK( r.evtcnt() == N );
+    testEvents::verifyFile( r, N );
+  }
+
+  // and closed explicitly, in every output mode, with the steps after the
+  // index still taken
+  static const LSEWriter::IOMode modes[] = { LSEWriter::STDIO, LSEWriter::STAGED, LSEWriter::URING };
+  for ( size_t m = 0; m < sizeof modes / sizeof modes[0]; m++ ) {
+    for ( int blocked = 0; blocked < 2; blocked++ ) {
+      LSEWriter* w = NULL;
+      try {
+	w = new LSEWriter( fn, 1, modes[m] );
+      } catch ( std::runtime_error& e ) {
+	if ( !testEvents::unsupported( e ) ) throw;
+	continue;
+      }
+      w->enableIndex( "/dev/full" );
+      w->enableColumns();
+      if ( blocked ) w->enableBlocks( 64 );
+      testEvents::writeEvents( *w, N );
+      std::string error = closeError( *w );
+      CHECK( strstr( error.c_str(), "error writing index /dev/full" ) != NULL );
+      CHECK( closeError( *w ).empty() );
+      delete w;
+
+      LSEReader r( fn );
+      CHECK( r.evtcnt() == N && ( r.footer() != NULL ) == ( blocked != 0 ) );
+      testEvents::verifyFile( r, N );
+      LSE_ContextColumns cols;
+      cols.load( LSE_ContextColumns::name( fn ) );
+      CHECK( cols.size() == N );
+    }
+  }
+
+  // a failing event file, left to the destructor or closed explicitly,
+  // with the error behind the writer thread too
+  for ( int k = 0; k < 3; k++ ) {
+    LSEWriter w( "/dev/full", 1, k == 0 ? LSEWriter::STDIO : LSEWriter::STAGED, 1, 4096 );
+    if ( k == 2 ) w.enableAsync( 4 );
+    try {
+      testEvents::writeEvents( w, N );
+    } catch ( std::runtime_error& ) {
+    }
+    if ( k > 0 ) CHECK( !closeError( w ).empty() );
+  }
+
+  // a feature the environment asks for that cannot be had fails the
+  // constructor with its own error, not the one closing the file gives
+  setenv( "LSEWRITER_BLOCK", "64", 1 );
+  setenv( "LSEWRITER_COMPRESS", "99", 1 );
+  try {
+    LSEWriter w( "/dev/full", 1 );
+    CHECK( false );
+  } catch ( std::runtime_error& e ) {
+    CHECK( strstr( e.what(), "LSEWriter::enableCompression" ) != NULL );
+  }
+  unsetenv( "LSEWRITER_BLOCK" );
+  unsetenv( "LSEWRITER_COMPRESS" );
+
+  remove( LSE_ContextColumns::name( fn ).c_str() );
+  remove( fn );
+  printf( "test_WriterClose: OK\n" );
+  return 0;
+}
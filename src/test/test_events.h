@@ -0,0 +1,162 @@
+/** -*- Mode: C++; -*-
+ * Synthetic events for the self-checking tests: writeEvents() writes a run
+ * of events numbered from first, and verify() checks one read back against
+ * the event of that number.
+ *
+ * $Header$
+ */
+
+#ifndef EVENTFILE_TEST_EVENTS_H
+#define EVENTFILE_TEST_EVENTS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+#include <string>
+#include <stdexcept>
+
+#include "eventFile/LSEReader.h"
+#include "eventFile/LSEWriter.h"
+#include "eventFile/LSE_Context.h"
+#include "eventFile/LSE_Info.h"
+#include "eventFile/LPA_Handler.h"
+#include "eventFile/EBF_Data.h"
+#include "eventFile/LSE_Keys.h"
+
+#define CHECK( c ) do { if ( !( c ) ) { \
+      fprintf( stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #c ); \
+      exit( EXIT_FAILURE ); } } while ( 0 )
+
+namespace testEvents {
+
+  using namespace eventFile;
+
+  inline void makeContext( LSE_Context& c, unsigned i )
+  {
+    memset( static_cast<void*>( &c ), 0, sizeof c );
+    c.ccsds.scid = 77; c.ccsds.apid = 956; c.ccsds.utc = 1000.5 + i;
+    c.current.timeSecs = 250000000 + i/10; c.current.timeHack.tics = i*7; c.current.timeHack.hacks = i/10;
+    c.previous.timeSecs = 250000000 + i/10 - 1;
+    c.scalers.elapsed = 1000ULL*i; c.scalers.livetime = 900ULL*i; c.scalers.prescaled = i/3;
+    c.scalers.discarded = i/5; c.scalers.sequence = 5000000ULL + 2*i; c.scalers.deadzone = i/11;
+    c.run.platform = 1; c.run.origin = 2; c.run.groundId = 0x1234; c.run.startedAt = 249999999;
+    strcpy( c.run.platformTxt, "LAT" ); strcpy( c.run.originTxt, "ORBIT" );
+    c.open.modeChanges = i/100; c.open.datagrams = i/50; c.open.action = 1;
+    strcpy( c.open.actionTxt, "START" ); strcpy( c.open.modeTxt, "NORMAL" );
+    c.close.action = 2; strcpy( c.close.actionTxt, "CONTINUE" );
+  }
+
+  inline void makeEBF( EBF_Data& e, unsigned i )
+  {
+    std::vector< unsigned char > p( ( i * 37 ) % 3000 );
+    for ( size_t k = 0; k < p.size(); k++ ) p[k] = static_cast< unsigned char >( k * 13 + i );
+    e.init( p.size(), p.empty() ? static_cast< const void* >( "" ) : &p[0] );
+  }
+
+  inline void makeLPA( LPA_Info& p, unsigned i )
+  {
+    memset( static_cast<void*>( &p ), 0, sizeof( LSE_Info ) );
+    p.timeTics = i; p.softwareKey = 0x100; p.hardwareKey = 0x200; p.lpaDbKey = 0x300 + i/1000;
+    p.handlers.clear();
+    for ( int h = 0; h < 3; h++ ) {
+      LPA_Handler x;
+      memset( static_cast<void*>( &x ), 0, sizeof x );
+      x.type = LPA_Handler::Filter; x.masterKey = 0xA0 + h; x.cfgKey = 0xB0 + h; x.cfgId = h;
+      x.state = static_cast< LPA_Handler::RsdState >( ( i + h ) % 5 );
+      x.prescaler = LPA_Handler::OUTPUT; x.version = 1;
+      x.id = h == 0 ? LPA_Handler::GAMMA : h == 1 ? LPA_Handler::MIP : LPA_Handler::HIP;
+      x.has = true; x.rsd.gamma1.status = i; x.rsd.gamma1.energyInLeus = i*3;
+      p.handlers.push_back( x );
+    }
+  }
+
+  template< class T > void makeLCI( T& t, unsigned i )
+  {
+    memset( static_cast<void*>( &t ), 0, sizeof t );
+    t.timeTics = i; t.softwareKey = 0x55; t.periodicPrescale = i%7;
+  }
+
+  /// mostly LPA events, with every tenth of each LCI flavour
+  inline void writeEvents( LSEWriter& w, unsigned n, unsigned first = 0 )
+  {
+    LSE_Context c; EBF_Data e; LPA_Info p; LCI_ACD_Info a; LCI_CAL_Info cal; LCI_TKR_Info t;
+    for ( unsigned i = first; i < first + n; i++ ) {
+      makeContext( c, i ); makeEBF( e, i );
+      switch ( i % 10 ) {
+      case 7: makeLCI( a, i ); a.range = i; w.write( c, e, a, LCI_Keys( 1, 2, i ) ); break;
+      case 8: makeLCI( cal, i ); cal.uld = i; w.write( c, e, cal, LCI_Keys( 1, 2, i ) ); break;
+      case 9: makeLCI( t, i ); t.splitLow = i; w.write( c, e, t, LCI_Keys( 1, 2, i ) ); break;
+      default: makeLPA( p, i ); w.write( c, e, p, LPA_Keys( 0x111, 0x222, 0x333, i ) ); break;
+      }
+    }
+  }
+
+  /// as writeEvents(), noting the offset each event starts at in ofs,
+  /// followed by the offset just past the last
+  inline void writeEvents( LSEWriter& w, unsigned n, std::vector< unsigned long long >& ofs, unsigned first = 0 )
+  {
+    ofs.clear();
+    for ( unsigned i = first; i < first + n; i++ ) {
+      ofs.push_back( w.tell() );
+      writeEvents( w, 1, i );
+    }
+    ofs.push_back( w.tell() );
+  }
+
+  /// true for what a reader or writer throws for a mode or feature this
+  /// build was made without
+  inline bool unsupported( const std::runtime_error& e )
+  {
+    return strstr( e.what(), "not supported in this build" ) != NULL;
+  }
+
+  /// an event as read through the full LSEReader::read()
+  struct Event {
+    LSE_Context ctx; EBF_Data ebf; LSE_Info::InfoType itype; LPA_Info pinfo;
+    LCI_ACD_Info ainfo; LCI_CAL_Info cinfo; LCI_TKR_Info tinfo;
+    LSE_Keys::KeysType ktype; LPA_Keys pakeys; LCI_Keys cikeys;
+    bool read( LSEReader& r )
+    {
+      return r.read( ctx, ebf, itype, pinfo, ainfo, cinfo, tinfo, ktype, pakeys, cikeys );
+    }
+  };
+
+  inline void verify( const Event& e, unsigned i )
+  {
+    LSE_Context c; makeContext( c, i );
+    CHECK( memcmp( &c, &e.ctx, sizeof c ) == 0 );
+    EBF_Data x; makeEBF( x, i );
+    CHECK( x.size() == e.ebf.size() );
+    CHECK( x.size() == 0 || memcmp( x.data(), e.ebf.data(), x.size() ) == 0 );
+    switch ( i % 10 ) {
+    case 7: CHECK( e.itype == LSE_Info::LCI_ACD && e.ainfo.range == i && e.cikeys.LCI_script == i ); break;
+    case 8: CHECK( e.itype == LSE_Info::LCI_CAL && e.cinfo.uld == i && e.cikeys.LCI_script == i ); break;
+    case 9: CHECK( e.itype == LSE_Info::LCI_TKR && e.tinfo.splitLow == i && e.cikeys.LCI_script == i ); break;
+    default: {
+      CHECK( e.itype == LSE_Info::LPA && e.ktype == LSE_Keys::LPA );
+      CHECK( e.pakeys.LPA_db == i && e.pakeys.LATC_master == 0x111 );
+      LPA_Info p; makeLPA( p, i );
+      CHECK( e.pinfo.timeTics == i && e.pinfo.lpaDbKey == p.lpaDbKey );
+      CHECK( e.pinfo.handlers.size() == 3 );
+      for ( int h = 0; h < 3; h++ ) {
+	CHECK( memcmp( &p.handlers[h], &e.pinfo.handlers[h], sizeof( LPA_Handler ) ) == 0 );
+      }
+    } }
+  }
+
+  /// read every event of a file and check them against first, first+1, ...
+  inline void verifyFile( LSEReader& r, unsigned n, unsigned first = 0 )
+  {
+    Event e;
+    for ( unsigned i = first; i < first + n; i++ ) {
+      CHECK( e.read( r ) );
+      verify( e, i );
+    }
+    CHECK( !e.read( r ) );
+  }
+
+}
+
+#endif
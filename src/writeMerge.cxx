@@ -2,6 +2,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include <iostream>
 #include <fstream>
@@ -10,14 +12,20 @@
 #include <sstream>
 #include <stdexcept>
 #include <algorithm>
+#include <deque>
+#include <list>
+#include <vector>
 
 #include "eventFile/LSEReader.h"
+#include "eventFile/LSE_PositionalReader.h"
 #include "eventFile/LSEWriter.h"
 #include "eventFile/LSE_Context.h"
 #include "eventFile/LSE_Info.h"
 #include "eventFile/LPA_Handler.h"
 #include "eventFile/EBF_Data.h"
 #include "eventFile/LSE_Keys.h"
+#include "eventFile/LSE_EventView.h"
+#include "eventFile/LSE_EventFetcher.h"
 
 struct EvtIdx {
   std::string tag;
@@ -35,8 +43,9 @@ struct EvtIdx {
   double dgmUTC;
   off_t fileofst;
   std::string evtfile;
+  bool fetched;  // its event has been requested of the reader threads
 
-  EvtIdx( const std::string& idxline ) {
+  EvtIdx( const std::string& idxline ) : fetched( false ) {
     // make the text line into an input stream
     std::istringstream iss( idxline );
 
@@ -59,18 +68,294 @@ struct EvtIdx {
   };
 };
 
-typedef std::map< std::string, eventFile::LSEReader* > lser_map;
-typedef lser_map::iterator lser_iter;
+// index entries read ahead per reader thread
+#define WRITEMERGE_FETCH_DEPTH 8
 
-struct cleanup {
-  void operator() ( lser_map::value_type x ) { delete x.second; }
+// assumed event size for read-ahead hints when a chunk file has no count
+#define WRITEMERGE_HINT_EVENT 65536
+
+// chunk files kept open at once unless WRITEMERGE_MAXOPEN says otherwise
+#define WRITEMERGE_DEFAULT_MAXOPEN 256
+
+// the readers of the chunk files, holding at most maxOpen of their files
+// open: the least recently used one that no read in flight still needs is
+// closed to make room, and reopened when it is wanted again, without
+// reading its header afresh if it is unchanged
+class ReaderPool {
+public:
+  explicit ReaderPool( size_t maxOpen ) :
+    m_entries(), m_lru(), m_maxOpen( maxOpen ? maxOpen : 1 ), m_open( 0 ),
+    m_hits( 0 ), m_misses( 0 ), m_reopens( 0 ), m_evictions( 0 ) {};
+
+  ~ReaderPool()
+  {
+    for ( entry_iter it = m_entries.begin(); it != m_entries.end(); ++it ) {
+      delete it->second.lse;
+#ifndef WIN32
+      delete it->second.pos;
+#endif
+    }
+  };
+
+  // the file's LSEReader, open; throws if it cannot be opened
+  eventFile::LSEReader* reader( const std::string& evtfile )
+  {
+    Entry& e = entry( evtfile );
+    if ( e.lse && e.lse->isOpen() ) {
+      m_hits++;
+    } else {
+      m_misses++;
+      makeRoom( e );
+      if ( e.lse ) {
+	e.lse->reopen();
+	m_reopens++;
+      } else {
+	e.lse = new eventFile::LSEReader( evtfile );
+      }
+      m_open++;
+    }
+    touch( e );
+    return e.lse;
+  };
+
+  // its positional reader, open, or NULL if it must be read through its LSEReader
+  eventFile::LSE_PositionalReader* positional( const std::string& evtfile )
+  {
+#ifndef WIN32
+    Entry& e = entry( evtfile );
+    if ( e.pos && e.pos->isOpen() ) {
+      m_hits++;
+    } else if ( e.pos || !e.posTried ) {
+      m_misses++;
+      makeRoom( e );
+      try {
+	if ( e.pos ) {
+	  e.pos->reopen();
+	  m_reopens++;
+	} else {
+	  e.posTried = true;
+	  e.pos = new eventFile::LSE_PositionalReader( evtfile );
+	}
+      } catch ( std::runtime_error& ) {
+	// e.g. compressed, or gone; the LSEReader handles it or says why not
+	return NULL;
+      }
+      m_open++;
+    }
+    if ( e.pos ) touch( e );
+    return e.pos;
+#else
+    return NULL;
+#endif
+  };
+
+  // its positional reader if that is open already, else NULL; neither
+  // counted nor marked as used
+  eventFile::LSE_PositionalReader* openPositional( const std::string& evtfile ) const
+  {
+#ifndef WIN32
+    entry_map::const_iterator it = m_entries.find( evtfile );
+    if ( it != m_entries.end() && it->second.pos && it->second.pos->isOpen() ) {
+      return it->second.pos;
+    }
+#endif
+    return NULL;
+  };
+
+  // keep the file open while reads of it are in flight; files held open
+  // past the limit that way are closed once released
+  void pin( const std::string& evtfile ) { entry( evtfile ).pins++; };
+  void unpin( const std::string& evtfile )
+  {
+    entry( evtfile ).pins--;
+    // the most recently used file may be the one being read now
+    if ( m_open > m_maxOpen ) evict( m_maxOpen, m_lru.front() );
+  };
+
+  unsigned long long hits() const { return m_hits; };
+  unsigned long long misses() const { return m_misses; };
+  unsigned long long reopens() const { return m_reopens; };
+  unsigned long long evictions() const { return m_evictions; };
+
+private:
+  struct Entry {
+    Entry() : lse( NULL ), pos( NULL ), posTried( false ), pins( 0 ), listed( false ), lru() {};
+    eventFile::LSEReader* lse;
+    eventFile::LSE_PositionalReader* pos;
+    bool posTried;  // pos is NULL because the file cannot be read positionally
+    unsigned pins;
+    bool listed;    // in the recently-used list, which holds the entries with a file open
+    std::list< Entry* >::iterator lru;
+  };
+  typedef std::map< std::string, Entry > entry_map;
+  typedef entry_map::iterator entry_iter;
+
+  entry_map           m_entries;
+  std::list< Entry* > m_lru;      // most recently used first
+  size_t              m_maxOpen;
+  size_t              m_open;     // files open, counting each reader's separately
+  unsigned long long  m_hits;
+  unsigned long long  m_misses;
+  unsigned long long  m_reopens;
+  unsigned long long  m_evictions;
+
+  Entry& entry( const std::string& evtfile ) { return m_entries[evtfile]; };
+
+  void touch( Entry& e )
+  {
+    if ( e.listed ) {
+      m_lru.splice( m_lru.begin(), m_lru, e.lru );
+    } else {
+      e.lru = m_lru.insert( m_lru.begin(), &e );
+      e.listed = true;
+    }
+  };
+
+  // close files, least recently used first, until one more may be opened
+  // for keep
+  void makeRoom( Entry& keep ) { evict( m_maxOpen - 1, &keep ); };
+
+  // close files other than keep, least recently used first, until at most
+  // limit are open; pinned files stay open even if that means going over
+  void evict( size_t limit, const Entry* keep )
+  {
+    std::list< Entry* >::iterator it = m_lru.end();
+    while ( m_open > limit && it != m_lru.begin() ) {
+      Entry* e = *--it;
+      if ( e == keep || e->pins > 0 ) continue;
+      if ( e->lse && e->lse->isOpen() ) {
+	e->lse->close();
+	m_open--;
+      }
+#ifndef WIN32
+      if ( e->pos && e->pos->isOpen() ) {
+	e->pos->close();
+	m_open--;
+      }
+#endif
+      e->listed = false;
+      it = m_lru.erase( it );
+      m_evictions++;
+    }
+  };
+
+  // not copyable
+  ReaderPool( const ReaderPool& );
+  ReaderPool& operator=( const ReaderPool& );
+};
+
+// adjacent records of one chunk file, waiting to be copied in one go; the
+// file is pinned open in the pool until they are
+struct EvtRun {
+  std::string evtfile;
+  eventFile::LSE_PositionalReader* src;
+  unsigned long long begin;
+  unsigned long long end;
+  unsigned long long count;
+  eventFile::LSE_Context first;
+  eventFile::LSE_Context last;
+
+  EvtRun() : evtfile(), src( NULL ), begin( 0 ), end( 0 ), count( 0 ) {};
+};
+
+// append the pending run of records to the output file
+static void flushRun( eventFile::LSEWriter* pLSEW, EvtRun& run, ReaderPool& pool )
+{
+  if ( run.count == 0 ) return;
+  try {
+    pLSEW->copy( *run.src, run.begin, run.end, run.count, run.first, run.last );
+  } catch ( std::runtime_error& e ) {
+    std::cout << e.what() << std::endl;
+    exit( EXIT_FAILURE );
+  }
+  run.count = 0;
+  pool.unpin( run.evtfile );
+}
+
+#ifndef WIN32
+// advises the kernel of the chunk-file ranges that the index entries read
+// ahead will need, a batch of entries at a time, each file's ranges in
+// ascending offset order
+class EvtHints {
+public:
+  EvtHints() : m_batch(), m_ranges( 0 ), m_bytes( 0 ) {};
+
+  void add( eventFile::LSE_PositionalReader* src, unsigned long long ofst )
+  {
+    if ( src ) m_batch.push_back( Entry( src, ofst ) );
+  };
+
+  void flush()
+  {
+    std::sort( m_batch.begin(), m_batch.end() );
+    size_t i = 0;
+    while ( i < m_batch.size() ) {
+      // records of about the file's average size, merged where they meet
+      eventFile::LSE_PositionalReader* src = m_batch[i].first;
+      unsigned long long evtBytes = WRITEMERGE_HINT_EVENT;
+      if ( src->evtcnt() > 0 && src->endOffset() > src->dataOffset() ) {
+	evtBytes = ( src->endOffset() - src->dataOffset() ) / src->evtcnt() + 1;
+      }
+      unsigned long long begin = m_batch[i].second;
+      unsigned long long end = begin + evtBytes;
+      for ( ++i; i < m_batch.size() && m_batch[i].first == src && m_batch[i].second <= end + evtBytes; ++i ) {
+	end = std::max( end, m_batch[i].second + evtBytes );
+      }
+      if ( src->willNeed( begin, end - begin ) ) {
+	m_ranges++;
+	m_bytes += end - begin;
+      }
+    }
+    m_batch.clear();
+  };
+
+  unsigned long long ranges() const { return m_ranges; };
+  unsigned long long bytes() const { return m_bytes; };
+
+private:
+  typedef std::pair< eventFile::LSE_PositionalReader*, unsigned long long > Entry;
+  std::vector< Entry > m_batch;
+  unsigned long long   m_ranges;
+  unsigned long long   m_bytes;
 };
+#endif
+
+// close an output file and report on it
+static void finish( eventFile::LSEWriter* pLSEW )
+{
+  try {
+    pLSEW->close();
+  } catch ( std::runtime_error& e ) {
+    std::cout << e.what() << std::endl;
+    exit( EXIT_FAILURE );
+  }
+  std::cout << "writeMerge: wrote " << pLSEW->evtcnt() << " events to " << pLSEW->name() << std::endl;
+  if ( pLSEW->asyncStats().events > 0 ) {
+    eventFile::LSEWriter::AsyncStats s = pLSEW->asyncStats();
+    std::cout << "writeMerge: writer queue max depth " << s.maxDepth;
+    std::cout << ", " << s.stalls << " stalls, " << s.blockedTime << " s blocked" << std::endl;
+  }
+  delete pLSEW;
+}
+
+// the error for a record whose meta-info type is not one writeMerge knows
+static std::runtime_error unknownInfo( int infotype, const EvtIdx& edx )
+{
+  std::ostringstream ess;
+  ess << "writeMerge: unknown LSE_Info type " << infotype;
+  ess << " at offset "            << edx.fileofst;
+  ess << " in "                   << edx.evtfile;
+  return std::runtime_error( ess.str() );
+}
 
 int main( int argc, char* argv[] )
 {
   // get the input and output file names
   if ( argc < 4 ) {
     std::cout << "writeMerge: not enough input arguments" << std::endl;
+    std::cout << "usage: writeMerge <index file> <output file template> <downlink id> [max events] [LATC key]" << std::endl;
+    std::cout << "  event records are copied as stored; set WRITEMERGE_DECODE to decode and" << std::endl;
+    std::cout << "  re-encode each one instead, as earlier versions always did" << std::endl;
     exit( EXIT_FAILURE );
   }
   std::string idxfile( argv[1] );
@@ -96,6 +381,16 @@ int main( int argc, char* argv[] )
     WRITEMERGE_CHUNKFLOOR = atof( envbuf );
   }
 
+  // optionally gather the output into a large staging buffer
+  size_t WRITEMERGE_STAGEBUF = 0;
+  envbuf = getenv( "WRITEMERGE_STAGEBUF" );
+  if ( envbuf ) {
+    WRITEMERGE_STAGEBUF = strtoul( envbuf, NULL, 0 );
+  }
+
+  // copy the event records verbatim unless asked to decode and re-encode them
+  bool WRITEMERGE_DECODE = ( getenv( "WRITEMERGE_DECODE" ) != NULL );
+
   // add support for overriding translated LATC master key
   unsigned long overrideLATC = 0xffffffff;
   if ( argc >= 6 ) {
@@ -105,12 +400,40 @@ int main( int argc, char* argv[] )
     std::cout << "writeMerge: no LATC key override" << std::endl;
   }
 
+  // copy runs of adjacent records straight from the chunk files, unless
+  // the records must be looked at or patched
+  bool WRITEMERGE_COPY = ( getenv( "WRITEMERGE_NOCOPY" ) == NULL && !WRITEMERGE_DECODE
+			   && overrideLATC == 0xffffffff );
+
+  // optionally read the upcoming events on a pool of threads
+  unsigned WRITEMERGE_THREADS = 0;
+  envbuf = getenv( "WRITEMERGE_THREADS" );
+  if ( envbuf ) {
+    WRITEMERGE_THREADS = strtoul( envbuf, NULL, 0 );
+  }
+
+  // and/or advise the kernel of the chunk-file ranges the next index entries need
+  size_t WRITEMERGE_LOOKAHEAD = 0;
+  envbuf = getenv( "WRITEMERGE_LOOKAHEAD" );
+  if ( envbuf ) {
+    WRITEMERGE_LOOKAHEAD = strtoul( envbuf, NULL, 0 );
+  }
+
+  // bound the number of chunk files open at once
+  size_t WRITEMERGE_MAXOPEN = WRITEMERGE_DEFAULT_MAXOPEN;
+  envbuf = getenv( "WRITEMERGE_MAXOPEN" );
+  if ( envbuf ) {
+    WRITEMERGE_MAXOPEN = strtoul( envbuf, NULL, 0 );
+  }
+  bool poolStats = ( envbuf != NULL );
+
   // declare the file-output object pointer
   int eventsOut = 0;
   eventFile::LSEWriter* pLSEW = NULL;
 
   // create a container for the chunk-evt input files
-  lser_map mapLSER;
+  ReaderPool pool( WRITEMERGE_MAXOPEN );
+  EvtRun run;
 
   // declare object to receive the event information
   eventFile::LSE_Context ctx;
@@ -124,6 +447,38 @@ int main( int argc, char* argv[] )
   eventFile::LPA_Keys     pakeys;
   eventFile::LCI_Keys     cikeys;
 
+  // or the raw event record, and a copy of it for patching the LATC key
+  eventFile::LSE_EventView view;
+  std::vector< unsigned char > patched;
+
+  // the reader threads fetch the events of the index entries read ahead,
+  // handing them back in index order; not for decoding
+  size_t lookahead = 1;
+  size_t refill = 0;  // top up the entries read ahead when down to this many
+#ifndef WIN32
+  eventFile::LSE_EventFetcher* pFetch = NULL;
+  if ( WRITEMERGE_THREADS > 0 && !WRITEMERGE_DECODE ) {
+    try {
+      pFetch = new eventFile::LSE_EventFetcher( WRITEMERGE_THREADS, WRITEMERGE_FETCH_DEPTH * WRITEMERGE_THREADS );
+    } catch ( std::runtime_error& e ) {
+      std::cout << e.what() << std::endl;
+      exit( EXIT_FAILURE );
+    }
+    lookahead = pFetch->depth();
+  }
+
+  // hints go out for half the lookahead at a time, so that each file's
+  // ranges can be sorted and merged
+  EvtHints hints;
+  if ( WRITEMERGE_LOOKAHEAD > 1 ) {
+    lookahead = std::max( lookahead, WRITEMERGE_LOOKAHEAD );
+    refill = lookahead / 2;
+  } else {
+    refill = lookahead - 1;
+  }
+  size_t nreq = 0;  // leading entries of ahead already offered to the reader threads
+#endif
+
   // read the index file and parse the entries, retrieving the 
   // requeseted events as we go
   std::string idxline;
@@ -133,30 +488,100 @@ int main( int argc, char* argv[] )
     std::cout << " (" << errno << ":" << strerror(errno) << ")" << std::endl;
     exit( EXIT_FAILURE );
   }
-  while ( getline( idx, idxline ) ) {
+  std::deque< EvtIdx > ahead;
+  bool idxdone = false;
+  for (;;) {
+
+    // keep the index entries up to the lookahead parsed
+    if ( ahead.size() <= refill ) {
+      while ( !idxdone && ahead.size() < lookahead ) {
+	if ( !getline( idx, idxline ) ) {
+	  idxdone = true;
+	  break;
+	}
     
-    // skip non-event records
-    if ( idxline.find( "EVT:" ) != 0 ) continue;
+	// skip non-event records
+	if ( idxline.find( "EVT:" ) != 0 ) continue;
+
+	// make an event-index object
+	ahead.push_back( EvtIdx( idxline ) );
+#ifndef WIN32
+	// only files already open are advised, rather than opening them early
+	if ( WRITEMERGE_LOOKAHEAD > 1 ) {
+	  hints.add( pool.openPositional( ahead.back().evtfile ), ahead.back().fileofst );
+	}
+#endif
+      }
+#ifndef WIN32
+      hints.flush();
+#endif
+    }
 
-    // make an event-index object
-    EvtIdx edx( idxline );
+#ifndef WIN32
+    // and the events of as many as the reader threads have room for requested
+    while ( pFetch && nreq < ahead.size() && nreq < pFetch->depth() ) {
+      eventFile::LSE_PositionalReader* src = pool.positional( ahead[nreq].evtfile );
+      if ( src ) {
+	pool.pin( ahead[nreq].evtfile );
+	pFetch->request( *src, ahead[nreq].fileofst, WRITEMERGE_COPY && src->canonical() );
+	ahead[nreq].fetched = true;
+      }
+      nreq++;
+    }
+
+    // the first of them is taken now
+    if ( nreq > 0 ) nreq--;
+#endif
+    if ( ahead.empty() ) break;
+    EvtIdx edx( ahead.front() );
+    ahead.pop_front();
 
-    // get an LSEReader for the file
-    lser_iter it = mapLSER.find( edx.evtfile );
-    if ( it == mapLSER.end() ) {
+    // get the file's positional reader, to copy its records as stored or
+    // to collect them from the reader threads
+    eventFile::LSE_PositionalReader* src = NULL;
+    bool fetched = edx.fetched;
+    if ( WRITEMERGE_COPY || fetched ) {
+      src = pool.positional( edx.evtfile );
+    }
+    eventFile::LSE_PositionalReader* pLSPR = ( WRITEMERGE_COPY && src && src->canonical() ) ? src : NULL;
+
+    // or else its LSEReader
+    eventFile::LSEReader* pLSER = NULL;
+    if ( !fetched && !pLSPR ) {
       try {
-	it = mapLSER.insert( std::pair< std::string, eventFile::LSEReader* >( edx.evtfile, new eventFile::LSEReader( edx.evtfile ) ) ).first;
-      }	catch ( std::runtime_error& e ) {
+	pLSER = pool.reader( edx.evtfile );
+      } catch ( std::runtime_error& e ) {
 	std::cout << e.what() << std::endl;
 	exit( EXIT_FAILURE );
       }
     }
 
-    // read the event at the specified location
+    // read the event at the specified location, or only find its extent
+    // if it is to be copied
     bool bevtread = false;
+    unsigned long long nextofst = 0;
     try {
-      it->second->seek( edx.fileofst );
-      bevtread = it->second->read( ctx, ebf, infotype, pinfo, ainfo, cinfo, tinfo, ktype, pakeys, cikeys );
+#ifndef WIN32
+      if ( fetched && pLSPR ) {
+	bevtread = pFetch->next( ctx, infotype, ktype, nextofst );
+      } else if ( fetched ) {
+	if ( ( bevtread = pFetch->next( view, nextofst ) ) ) {
+	  ctx = view.ctx();
+	  infotype = view.infotype();
+	}
+      } else if ( pLSPR ) {
+	bevtread = pLSPR->probe( edx.fileofst, ctx, infotype, ktype, nextofst );
+      } else
+#endif
+      {
+	pLSER->seek( edx.fileofst );
+	if ( WRITEMERGE_DECODE ) {
+	  bevtread = pLSER->read( ctx, ebf, infotype, pinfo, ainfo, cinfo, tinfo, ktype, pakeys, cikeys );
+	} else if ( ( bevtread = pLSER->read( view ) ) ) {
+	  ctx = view.ctx();
+	  infotype = view.infotype();
+	}
+      }
     } catch( std::runtime_error e ) {
       std::cout << e.what() << std::endl;
       exit( EXIT_FAILURE );
@@ -178,62 +603,120 @@ int main( int argc, char* argv[] )
 
       // open the output file
       try {
-	pLSEW = new eventFile::LSEWriter( std::string( ofn ), downlinkID );
+	if ( WRITEMERGE_STAGEBUF > 0 ) {
+	  pLSEW = new eventFile::LSEWriter( std::string( ofn ), downlinkID, eventFile::LSEWriter::STAGED,
+					    1, WRITEMERGE_STAGEBUF );
+	} else {
+	  pLSEW = new eventFile::LSEWriter( std::string( ofn ), downlinkID );
+	}
       } catch ( std::runtime_error& e ) {
 	std::cout << e.what() << std::endl;
 	exit( EXIT_FAILURE );
       }
       std::cout << "writeMerge: created output file " << pLSEW->name() << std::endl;
+
+      // reserve room for a full output file, sized by the input's records
+      struct stat stbuf;
+      unsigned long long evtcnt = pLSER ? pLSER->evtcnt() : src->evtcnt();
+      unsigned long long start = pLSER ? pLSER->dataOffset() : src->dataOffset();
+      if ( currMax > 0 && evtcnt > 0 && stat( edx.evtfile.c_str(), &stbuf ) == 0 ) {
+	unsigned long long evtBytes = ( stbuf.st_size - start ) / evtcnt;
+	pLSEW->preallocate( currMax, evtBytes );
+      }
     }
 
     // write the event to the merged file
     try {
-      switch( infotype ) {
-      case eventFile::LSE_Info::LPA:
-	if ( overrideLATC != 0xffffffff ) {
-	  pakeys.LATC_master = overrideLATC;
+      if ( pLSPR ) {
+	// records are copied unread, but only those a decode could write
+	if ( infotype <= eventFile::LSE_Info::NONE || infotype >= eventFile::LSE_Info::NumLSEInfoTypes ) {
+	  throw unknownInfo( infotype, edx );
+	}
+
+	// extend the pending run, or start a new one
+	if ( run.count == 0 || run.src != pLSPR || run.end != static_cast< unsigned long long >( edx.fileofst ) ) {
+	  flushRun( pLSEW, run, pool );
+	  pool.pin( edx.evtfile );
+	  run.evtfile = edx.evtfile;
+	  run.src = pLSPR;
+	  run.begin = edx.fileofst;
+	  run.first = ctx;
+	}
+	run.end = nextofst;
+	run.last = ctx;
+	run.count++;
+      } else if ( !WRITEMERGE_DECODE && infotype > eventFile::LSE_Info::NONE
+	   && infotype < eventFile::LSE_Info::NumLSEInfoTypes ) {
+	if ( overrideLATC != 0xffffffff && infotype == eventFile::LSE_Info::LPA ) {
+	  // patch the key in a copy of the record
+	  unsigned key = overrideLATC;
+	  patched.assign( view.record(), view.record() + view.size() );
+	  memcpy( &patched[ view.keysOffset() ], &key, sizeof( key ) );
+	  view.parse( &patched[0], patched.size() );
+	}
+	flushRun( pLSEW, run, pool );
+	pLSEW->write( view );
+      } else {
+	flushRun( pLSEW, run, pool );
+	switch( infotype ) {
+	case eventFile::LSE_Info::LPA:
+	  if ( overrideLATC != 0xffffffff ) {
+	    pakeys.LATC_master = overrideLATC;
+	  }
+	  pLSEW->write( ctx, ebf, pinfo, pakeys );
+	  break;
+	case eventFile::LSE_Info::LCI_ACD:
+	  pLSEW->write( ctx, ebf, ainfo, cikeys );
+	  break;
+	case eventFile::LSE_Info::LCI_CAL:
+	  pLSEW->write( ctx, ebf, cinfo, cikeys );
+	  break;
+	case eventFile::LSE_Info::LCI_TKR:
+	  pLSEW->write( ctx, ebf, tinfo, cikeys );
+	  break;
+	default:
+	  throw unknownInfo( infotype, edx );
+	  break;
 	}
-	pLSEW->write( ctx, ebf, pinfo, pakeys );
-	break;
-      case eventFile::LSE_Info::LCI_ACD:
-	pLSEW->write( ctx, ebf, ainfo, cikeys );
-	break;
-      case eventFile::LSE_Info::LCI_CAL:
-	pLSEW->write( ctx, ebf, cinfo, cikeys );
-	break;
-      case eventFile::LSE_Info::LCI_TKR:
-	pLSEW->write( ctx, ebf, tinfo, cikeys );
-	break;
-      default:
-	std::ostringstream ess;
-	ess << "writeMerge: unknown LSE_Info type " << infotype;
-	ess << " at offset "            << edx.fileofst;
-	ess << " in "                   << edx.evtfile;
-	throw std::runtime_error( ess.str() );
-	break;
       }
     } catch ( std::runtime_error& e ) {
       std::cout << e.what() << std::endl;
       exit( EXIT_FAILURE );
     }
+    if ( fetched ) pool.unpin( edx.evtfile );
 
     // check to see if the output file is full
     if ( currMax > 0 && ++eventsOut >= currMax ) {
       // close the current file and reset the event counter
-      std::cout << "writeMerge: wrote " << pLSEW->evtcnt() << " events to " << pLSEW->name() << std::endl;
-      delete pLSEW; pLSEW = NULL;
+      flushRun( pLSEW, run, pool );
+      finish( pLSEW ); pLSEW = NULL;
       eventsOut = 0;
 
       // rescale the max-event count for the next file
       currMax = ( currMax <= WRITEMERGE_CHUNKFLOOR * maxEvents ) ? maxEvents : WRITEMERGE_CHUNKSCALE * currMax;
     }
   }
-  std::for_each( mapLSER.begin(), mapLSER.end(), cleanup() );
-  idx.close();
   if ( pLSEW ) {
-    std::cout << "writeMerge: wrote " << pLSEW->evtcnt() << " events to " << pLSEW->name() << std::endl;
-    delete pLSEW;
+    flushRun( pLSEW, run, pool );
+    finish( pLSEW );
+  }
+#ifndef WIN32
+  if ( pFetch ) {
+    eventFile::LSE_EventFetcher::Stats s = pFetch->stats();
+    std::cout << "writeMerge: read " << s.requests << " events on " << WRITEMERGE_THREADS << " threads, ";
+    std::cout << s.waits << " waits, " << s.waitTime << " s waiting" << std::endl;
+    delete pFetch;
   }
+  if ( WRITEMERGE_LOOKAHEAD > 1 ) {
+    std::cout << "writeMerge: advised " << hints.ranges() << " ranges, " << hints.bytes();
+    std::cout << " bytes of the chunk files ahead of reading them" << std::endl;
+  }
+#endif
+  if ( poolStats ) {
+    std::cout << "writeMerge: chunk-file readers " << pool.hits() << " hits, " << pool.misses();
+    std::cout << " misses, " << pool.reopens() << " reopens, " << pool.evictions() << " evictions" << std::endl;
+  }
+  idx.close();
 
   // all done
   return 0;